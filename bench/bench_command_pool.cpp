@@ -0,0 +1,153 @@
+/*
+ * Running attendant commands: a detached thread each against a CommandPool.
+ *
+ * First a burst of quick commands (an `op#` costs about a microsecond) is run both ways: one
+ * std::thread per command, as CommandProcessor::run used to start them, with the next command
+ * taken only once the previous one has signalled completion, and the whole burst handed to
+ * a CommandPool at once, waiting on the futures at the end. Reported is the time per command.
+ *
+ * Then a refill that takes `refill` milliseconds is issued, followed by `op` commands, and the
+ * time from typing each `op` to it having run is reported: the old loop cannot take the
+ * next command before the refill is done, the pool runs them beside it.
+ */
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "command_pool.h"
+#include "bench_util.h"
+
+static const BenchTable burstTable({ 20 });
+static const BenchTable table({ 20, 16 });
+
+static std::atomic<int> approvals(0);
+
+static void
+quickCommand()
+{
+	approvals++;
+}
+
+// the completion handshake CommandProcessor::run waited on before taking the next command
+struct Completion
+{
+	std::mutex mutex;
+	std::condition_variable cv;
+	bool completed = true;
+
+	void wait()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		cv.wait(lock, [this] { return completed; });
+		completed = false;
+	}
+
+	void signal()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		completed = true;
+		cv.notify_one();
+	}
+};
+
+static double
+burstWithThreads(int num_commands)
+{
+	Completion completion;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < num_commands; i++) {
+		completion.wait();
+		std::thread t([&completion] { quickCommand(); completion.signal(); });
+		t.detach();
+	}
+	completion.wait();
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / num_commands;
+}
+
+static double
+burstWithPool(int num_commands, CommandPool& pool)
+{
+	std::vector<std::future<void>> done;
+	done.reserve(num_commands);
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < num_commands; i++)
+		done.push_back(pool.submit(quickCommand));
+	for (auto& command : done)
+		command.get();
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / num_commands;
+}
+
+// time from issuing each `op` to it having run, in microseconds
+static std::vector<double>
+opsBehindRefillWithThreads(int refill_ms, int num_ops)
+{
+	Completion completion;
+	std::vector<double> latencies;
+
+	completion.wait();
+	std::thread refill([&completion, refill_ms] {
+		std::this_thread::sleep_for(std::chrono::milliseconds(refill_ms));
+		completion.signal();
+	});
+	refill.detach();
+
+	for (int i = 0; i < num_ops; i++) {
+		auto typed = std::chrono::steady_clock::now();
+		completion.wait();
+		std::promise<void> ran;
+		std::future<void> done = ran.get_future();
+		std::thread t([&completion, &ran] { quickCommand(); ran.set_value(); completion.signal(); });
+		t.detach();
+		done.get();
+		latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - typed).count());
+	}
+	completion.wait();
+	return latencies;
+}
+
+static std::vector<double>
+opsBehindRefillWithPool(int refill_ms, int num_ops, CommandPool& pool)
+{
+	std::vector<double> latencies;
+	std::future<void> refill = pool.submit([refill_ms] { std::this_thread::sleep_for(std::chrono::milliseconds(refill_ms)); });
+
+	for (int i = 0; i < num_ops; i++) {
+		auto typed = std::chrono::steady_clock::now();
+		pool.submit(quickCommand).get();
+		latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - typed).count());
+	}
+	refill.get();
+	return latencies;
+}
+
+static void
+reportOps(const char* name, std::vector<double> latencies)
+{
+	Percentiles<double> latency = percentiles(latencies);
+	table.row(name, decimals(latency.median, 1), decimals(latency.max, 1));
+}
+
+int
+main(int argc, char* argv[])
+{
+	const int num_commands = (argc > 1) ? atoi(argv[1]) : 20000;
+	const int refill_ms = (argc > 2) ? atoi(argv[2]) : 500;
+	const int num_ops = 6;
+	CommandPool pool(4);
+
+	std::cout << num_commands << " quick commands" << std::endl;
+	burstTable.row("Commands run by", "ns per command");
+	burstTable.row("Thread each", decimals(burstWithThreads(num_commands), 0));
+	burstTable.row("CommandPool", decimals(burstWithPool(num_commands, pool), 0));
+
+	std::cout << std::endl << num_ops << " op commands typed right after a " << refill_ms << " ms refill" << std::endl;
+	table.row("Commands run by", "Median (us)", "Max (us)");
+	reportOps("Thread each", opsBehindRefillWithThreads(refill_ms, num_ops));
+	reportOps("CommandPool", opsBehindRefillWithPool(refill_ms, num_ops, pool));
+	return 0;
+}
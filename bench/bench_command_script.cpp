@@ -0,0 +1,191 @@
+/*
+ * Reading a command script: the way CommandProcessor::run took a typed line against the way
+ * CommandProcessor::runBatch takes one.
+ *
+ * A script of `lines` commands (gc, op, cp, rf and pt, some of them timed with `@<seconds>`)
+ * is written to a temporary file and read back both ways: with std::getline into a string,
+ * the command copied out with substr and upper-cased with std::transform, and its numbers
+ * read with a std::stringstream over another substr, as run() did; and with fgets into one
+ * buffer, the command upper-cased in place and the numbers read with strtol and strtof where
+ * they lie. Only the reading and parsing is timed, not the commands. Reported are the time
+ * and the heap allocations per line.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include "bench_util.h"
+
+static const BenchTable table({ 20, 12, 16 });
+
+static std::atomic<long long> allocations(0);
+
+void*
+operator new(std::size_t size)
+{
+	allocations++;
+	if (void* p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void
+operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void
+operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+struct ScriptBenchResult
+{
+	double ns;
+	long long allocations;
+	long long checksum;	// keeps the parsing from being optimised away
+};
+
+static std::FILE*
+writeScript(int lines)
+{
+	static const char* commands[] = { "gc3", "op 2", "OP5", "cp1 4.75", "rf0", "pt", "op1", "gc 1" };
+	std::FILE* script = std::tmpfile();
+	for (int i = 0; i < lines; i++) {
+		if (i % 4 == 0)
+			std::fprintf(script, "@%d.5 ", i / 4);
+		std::fprintf(script, "%s\n", commands[i % (sizeof(commands) / sizeof(commands[0]))]);
+	}
+	return script;
+}
+
+static double
+since(std::chrono::steady_clock::time_point start)
+{
+	return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+// as CommandProcessor::run did, with the line read by getline instead of a key at a time
+static ScriptBenchResult
+readWithStrings(std::FILE* script)
+{
+	std::rewind(script);
+	ScriptBenchResult result = { 0, 0, 0 };
+	char buffer[256];
+	const long long allocations_before = allocations.load();
+	auto start = std::chrono::steady_clock::now();
+
+	while (std::fgets(buffer, sizeof(buffer), script) != NULL) {
+		std::string input(buffer);
+		input.erase(input.find_last_not_of("\r\n") + 1);
+		if (input[0] == '@') {
+			std::stringstream at(input.substr(1));
+			float seconds;
+			at >> seconds;
+			result.checksum += static_cast<long long>(seconds);
+			input = input.substr(input.find(' ') + 1);
+		}
+
+		std::string command = input.substr(0, 2);
+		std::transform(command.begin(), command.end(), command.begin(), ::toupper);
+		if (command == "CP") {
+			int grade;
+			float price;
+			std::stringstream ss(input.substr(2));
+			if (ss >> grade >> price)
+				result.checksum += grade + static_cast<long long>(price);
+		}
+		else if (command != "PT") {
+			int number;
+			std::stringstream ss(input.substr(2));
+			if (ss >> number)
+				result.checksum += number;
+		}
+		result.checksum += command[0];
+	}
+
+	result.ns = since(start);
+	result.allocations = allocations.load() - allocations_before;
+	return result;
+}
+
+// as CommandProcessor::runBatch and execute do
+static ScriptBenchResult
+readInPlace(std::FILE* script)
+{
+	std::rewind(script);
+	ScriptBenchResult result = { 0, 0, 0 };
+	char line[256];
+	const long long allocations_before = allocations.load();
+	auto start = std::chrono::steady_clock::now();
+
+	while (std::fgets(line, sizeof(line), script) != NULL) {
+		const char* p = line;
+		char* end;
+		if (*p == '@') {
+			float seconds = std::strtof(p + 1, &end);
+			result.checksum += static_cast<long long>(seconds);
+			p = end;
+			while (*p == ' ')
+				p++;
+		}
+
+		const char name[2] = { static_cast<char>(::toupper(static_cast<unsigned char>(p[0]))),
+							   static_cast<char>(::toupper(static_cast<unsigned char>(p[1]))) };
+		const std::string command(name, 2);
+		const char* args = p + 2;
+		if (command == "CP") {
+			long grade = std::strtol(args, &end, 10);
+			if (end != args) {
+				args = end;
+				float price = std::strtof(args, &end);
+				if (end != args)
+					result.checksum += grade + static_cast<long long>(price);
+			}
+		}
+		else if (command != "PT") {
+			long number = std::strtol(args, &end, 10);
+			if (end != args)
+				result.checksum += number;
+		}
+		result.checksum += command[0];
+	}
+
+	result.ns = since(start);
+	result.allocations = allocations.load() - allocations_before;
+	return result;
+}
+
+static void
+report(const char* name, int lines, const ScriptBenchResult& result)
+{
+	table.row(name, decimals(result.ns / lines, 0), decimals(static_cast<double>(result.allocations) / lines, 2),
+		result.checksum);
+}
+
+int
+main(int argc, char* argv[])
+{
+	const int lines = (argc > 1) ? atoi(argv[1]) : 200000;
+	std::FILE* script = writeScript(lines);
+	if (script == NULL) {
+		std::cout << "Cannot create the script file" << std::endl;
+		return 1;
+	}
+
+	std::cout << lines << " script lines" << std::endl;
+	table.row("Parsed with", "ns/line", "Allocs/line", "Checksum");
+
+	report("Strings", lines, readWithStrings(script));
+	report("In place", lines, readInPlace(script));
+	std::fclose(script);
+	return 0;
+}
@@ -0,0 +1,209 @@
+/*
+ * Which of a pump's transitions a slow Computer gets to see.
+ *
+ * One pump thread runs transactions the way Pump::main does, publishing TxnStarted,
+ * Approved, one Tick per TICKS_PER_TXN flow ticks, Done and Reset, and sleeps `tick`
+ * microseconds between flow ticks as the simulation clock would make it. One Computer
+ * thread spends `draw` microseconds on every status it draws.
+ *
+ * It is run once with the Computer reading only the newest record in the PumpStatusSlot, as
+ * it did before the ring, and once with it applying the pump's events PUMP_EVENT_BATCH at a
+ * time and resyncing from the record when the ring has been lapped. Reported are how many
+ * of the transactions the Computer saw approved and done, how many statuses it drew, how
+ * often it had to resync, and the median and 99th percentile of one publish as seen by the pump.
+ */
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "rt.h"
+#include "common.h"
+#include "pump_controller.h"
+#include "bench_util.h"
+
+static const BenchTable table({ 16, 10, 10, 8, 8, 9, 14 });
+
+static const int TICKS_PER_TXN = 14;	// 70 L at 5 L a tick
+
+struct RingBenchArgs
+{
+	int numTxns;
+	int tickUs;
+	int drawUs;
+	PumpStatusSlot* slot;
+	std::atomic<bool> finished;
+	std::vector<long long> publishNs;
+};
+
+struct RingBenchResult
+{
+	std::vector<bool> approvedSeen;
+	std::vector<bool> doneSeen;
+	int drawn;
+	int resyncs;
+};
+
+static void
+spin(int us)
+{
+	auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(us);
+	while (std::chrono::steady_clock::now() < until)
+		;
+}
+
+static void
+publish(RingBenchArgs* bench, CustomerRecordWire& wire, PumpEventType type, TxnStatus status)
+{
+	wire.setTxnStatus(status);
+
+	auto start = std::chrono::steady_clock::now();
+	PumpEvent event{};
+	event.type = type;
+	event.changed = PUMP_FIELD_STATUS | PUMP_FIELD_VOLUME;
+	event.status = static_cast<uint8_t>(status);
+	event.receivedMl = litresToMl(wire.receivedVolume);
+	event.costMills = 0;
+	const bool whole = type == PumpEventType::TxnStarted || type == PumpEventType::Reset;
+	if (whole)
+		event.changed = PUMP_FIELDS_ALL;
+	bench->slot->publish(event, whole ? &wire : nullptr);
+	bench->publishNs.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+UINT __stdcall
+runTransactions(void* args)
+{
+	RingBenchArgs* bench = static_cast<RingBenchArgs*>(args);
+	CustomerRecordWire wire;
+	memset(&wire, 0, sizeof(wire));
+	strcpy(wire.name, "Bench");
+
+	for (int i = 0; i < bench->numTxns; i++) {
+		wire.pumpId = i;
+		wire.receivedVolume = 0;
+		publish(bench, wire, PumpEventType::TxnStarted, TxnStatus::Pending);
+		publish(bench, wire, PumpEventType::Approved, TxnStatus::Approved);
+		for (int tick = 1; tick <= TICKS_PER_TXN; tick++) {
+			std::this_thread::sleep_for(std::chrono::microseconds(bench->tickUs));
+			wire.receivedVolume = static_cast<float>(tick * DEFAULT_FLOW_RATE);
+			publish(bench, wire, PumpEventType::Tick, TxnStatus::Approved);
+		}
+		publish(bench, wire, PumpEventType::Done, TxnStatus::Done);
+		publish(bench, wire, PumpEventType::Reset, TxnStatus::Pending);
+	}
+	bench->finished.store(true);
+	bench->slot->changed.notify();
+	return 0;
+}
+
+// the transaction is told by the pump ID the bench gives it
+static void
+see(RingBenchResult& result, int txn, TxnStatus status)
+{
+	if (txn < 0)
+		return;
+	if (status == TxnStatus::Approved)
+		result.approvedSeen[txn] = true;
+	else if (status == TxnStatus::Done)
+		result.doneSeen[txn] = true;
+}
+
+// the Computer's runPump(), for each way of following the pump
+static void
+readLatest(RingBenchArgs& bench, RingBenchResult& result)
+{
+	CustomerRecordWire wire;
+	uint64_t read_event = 0;
+	while (true) {
+		uint32_t generation = bench.slot->changed.current();
+		if (bench.slot->events.getPublished() == read_event) {
+			if (bench.finished.load())
+				break;
+			bench.slot->changed.waitForChange(generation);
+			continue;
+		}
+		read_event = bench.slot->read(wire);
+		see(result, wire.pumpId, wire.txnStatus());
+
+		spin(bench.drawUs);
+		result.drawn++;
+	}
+}
+
+static void
+readEvents(RingBenchArgs& bench, RingBenchResult& result)
+{
+	PumpEventReader events(*bench.slot);
+	CustomerRecord data;
+	data.pumpId = -1;
+	while (true) {
+		uint32_t generation = bench.slot->changed.current();
+		if (!events.hasEvents()) {
+			if (bench.finished.load())
+				break;
+			bench.slot->changed.waitForChange(generation);
+			continue;
+		}
+
+		uint64_t resyncs = events.getResyncs();
+		events.apply(data, [&result](const CustomerRecord& record, uint8_t) { see(result, record.pumpId, record.txnStatus); });
+		result.resyncs += static_cast<int>(events.getResyncs() - resyncs);
+
+		spin(bench.drawUs);
+		result.drawn++;
+	}
+}
+
+static void
+runRingBench(bool use_ring, int num_txns, int tick_us, int draw_us)
+{
+	std::unique_ptr<PumpStatusSlot> slot(new PumpStatusSlot());
+	memset(static_cast<void*>(slot.get()), 0, sizeof(PumpStatusSlot));
+
+	RingBenchArgs bench;
+	bench.numTxns = num_txns;
+	bench.tickUs = tick_us;
+	bench.drawUs = draw_us;
+	bench.slot = slot.get();
+	bench.finished = false;
+	bench.publishNs.reserve(static_cast<size_t>(num_txns) * (TICKS_PER_TXN + 4));
+
+	RingBenchResult result;
+	result.approvedSeen.assign(num_txns, false);
+	result.doneSeen.assign(num_txns, false);
+	result.drawn = 0;
+	result.resyncs = 0;
+
+	CThread pump(runTransactions, ACTIVE, &bench);
+	if (use_ring)
+		readEvents(bench, result);
+	else
+		readLatest(bench, result);
+	pump.WaitForThread();
+
+	Percentiles<long long> publish = percentiles(bench.publishNs);
+	table.row(use_ring ? "Event ring" : "Latest record", draw_us,
+		std::count(result.approvedSeen.begin(), result.approvedSeen.end(), true),
+		std::count(result.doneSeen.begin(), result.doneSeen.end(), true), result.drawn, result.resyncs, publish.median,
+		publish.p99);
+}
+
+int
+main(int argc, char* argv[])
+{
+	const int num_txns = (argc > 1) ? atoi(argv[1]) : 100;
+	const int tick_us = (argc > 2) ? atoi(argv[2]) : 200;
+	const int draw_us[] = { 0, 1000, 5000 };
+
+	std::cout << num_txns << " transactions of " << TICKS_PER_TXN << " ticks, " << tick_us << " us a tick, a ring of "
+		<< PUMP_EVENT_RING_SIZE << " events" << std::endl;
+	table.row("Computer reads", "Draw (us)", "Approved", "Done", "Drawn", "Resyncs", "Publish med", "Publish p99");
+
+	for (int draw : draw_us) {
+		runRingBench(false, num_txns, tick_us, draw);
+		runRingBench(true, num_txns, tick_us, draw);
+	}
+	return 0;
+}
@@ -0,0 +1,117 @@
+/*
+ * Looking up the unit price of a fuel grade.
+ *
+ * Each lookup is what Customer::selectFuelGrade does: find the price of a random grade.
+ * It is timed against the unordered_map that FuelPrice used to keep in each process, and
+ * against the shared FuelPriceTable, read from its SeqLock while nothing changes the prices
+ * and again while another thread publishes a new price as fast as it can, the worst `cp`
+ * could ever do. The table is read by DEFAULT_NUM_PUMPS threads at once, the map by one, since it
+ * could not be read while being changed.
+ */
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "rt.h"
+#include "common.h"
+#include "bench_util.h"
+
+static const BenchTable table({ 36, 10 });
+
+static const int LOOKUPS = 10000000;
+
+struct ReaderArgs
+{
+	const SeqLock<FuelPriceTable>* prices;
+	int id;
+	float total;
+};
+
+UINT __stdcall
+readPrices(void* args)
+{
+	ReaderArgs* reader = static_cast<ReaderArgs*>(args);
+	std::mt19937 rng(reader->id);
+	float total = 0.0f;
+	for (int i = 0; i < LOOKUPS; i++) {
+		FuelGrade grade = intToFuelGrade(rng() % MAX_TANKS);
+		total += reader->prices->read().unitCostOf(grade);
+	}
+	reader->total = total;
+	return 0;
+}
+
+// nanoseconds per lookup over all DEFAULT_NUM_PUMPS readers, with a writer changing prices if `changing`
+static double
+runTableBench(bool changing)
+{
+	std::unique_ptr<SeqLock<FuelPriceTable>> prices(new SeqLock<FuelPriceTable>());
+	FuelPriceTable table = { 1, { 4.1f, 4.6f, 4.9f, 5.2f } };
+	prices->write(table);
+
+	std::atomic<bool> done(false);
+	std::thread writer;
+	if (changing) {
+		writer = std::thread([&] {
+			while (!done.load(std::memory_order_relaxed)) {
+				table.version++;
+				table.unitCost[table.version % MAX_TANKS] += 0.01f;
+				prices->write(table);
+			}
+		});
+	}
+
+	std::vector<ReaderArgs> readers(DEFAULT_NUM_PUMPS);
+	std::vector<std::unique_ptr<CThread>> threads;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < DEFAULT_NUM_PUMPS; i++) {
+		readers[i] = { prices.get(), i, 0.0f };
+		threads.emplace_back(new CThread(readPrices, ACTIVE, &readers[i]));
+	}
+	for (auto& thread : threads)
+		thread->WaitForThread();
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+	done = true;
+	if (writer.joinable())
+		writer.join();
+	return elapsed.count() / (static_cast<double>(LOOKUPS) * DEFAULT_NUM_PUMPS);
+}
+
+static double
+runMapBench()
+{
+	std::unordered_map<FuelGrade, float> prices;
+	prices[FuelGrade::Oct87] = 4.1f;
+	prices[FuelGrade::Oct89] = 4.6f;
+	prices[FuelGrade::Oct91] = 4.9f;
+	prices[FuelGrade::Oct94] = 5.2f;
+	prices[FuelGrade::Invalid] = 0.0f;
+
+	std::mt19937 rng(0);
+	volatile float total = 0.0f;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < LOOKUPS; i++) {
+		FuelGrade grade = intToFuelGrade(rng() % MAX_TANKS);
+		auto found = prices.find(grade);
+		if (found != prices.end())
+			total = total + found->second;
+	}
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / LOOKUPS;
+}
+
+int
+main()
+{
+	std::cout << LOOKUPS << " lookups per reader" << std::endl;
+	table.row("Prices", "Readers", "ns per lookup");
+	table.row("unordered_map", 1, decimals(runMapBench(), 1));
+	table.row("FuelPriceTable", DEFAULT_NUM_PUMPS, decimals(runTableBench(false), 1));
+	table.row("FuelPriceTable, prices changing", DEFAULT_NUM_PUMPS, decimals(runTableBench(true), 1));
+	return 0;
+}
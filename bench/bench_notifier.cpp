@@ -0,0 +1,125 @@
+/*
+ * CPU cost of customers waiting for their fill: polling against blocking.
+ *
+ * A pump thread publishes a dispense tick into a PumpStatusSlot every millisecond, and
+ * 100 customer threads wait until the received volume reaches the target, either by
+ * re-reading the slot in a loop (how Customer::getFuel used to wait) or by sleeping on the
+ * slot's ChangeNotifier between ticks. The process CPU time is reported for each, next
+ * to the wall time, so a figure close to wall time times the number of cores means the
+ * waiters were spinning.
+ */
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "rt.h"
+#include "common.h"
+#include "futex.h"
+#include "bench_util.h"
+
+static const BenchTable table({ 12, 14 });
+
+#ifndef _WIN32
+#include <ctime>
+#endif
+
+const int NUM_WAITERS = 100;
+
+static double
+processCpuSeconds()
+{
+#ifdef _WIN32
+	FILETIME creation, exit, kernel, user;
+	GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+	ULARGE_INTEGER k, u;
+	k.LowPart = kernel.dwLowDateTime; k.HighPart = kernel.dwHighDateTime;
+	u.LowPart = user.dwLowDateTime; u.HighPart = user.dwHighDateTime;
+	return (k.QuadPart + u.QuadPart) * 1e-7;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+struct NotifierBenchArgs
+{
+	PumpStatusSlot* slot;
+	int numTicks;
+	bool blocking;
+};
+
+UINT __stdcall
+pumpTicks(void* args)
+{
+	NotifierBenchArgs* bench = static_cast<NotifierBenchArgs*>(args);
+	PumpEvent tick;
+	memset(&tick, 0, sizeof(tick));
+	tick.type = PumpEventType::Tick;
+	tick.changed = PUMP_FIELD_VOLUME;
+
+	for (int i = 1; i <= bench->numTicks; i++) {
+		SLEEP(1);
+		tick.receivedMl = litresToMl(static_cast<float>(i));
+		bench->slot->events.push(tick);
+		bench->slot->changed.notify();
+	}
+	return 0;
+}
+
+UINT __stdcall
+waitForFill(void* args)
+{
+	NotifierBenchArgs* bench = static_cast<NotifierBenchArgs*>(args);
+	const float target = static_cast<float>(bench->numTicks);
+
+	CustomerRecordWire status;
+	while (true) {
+		uint32_t generation = bench->slot->changed.current();
+		bench->slot->read(status);
+		if (status.receivedVolume >= target)
+			break;
+		if (bench->blocking)
+			bench->slot->changed.waitForChange(generation);
+	}
+	return 0;
+}
+
+static void
+runNotifierBench(bool blocking, int num_ticks)
+{
+	// value-initialised, i.e. all zero like a freshly created data pool
+	std::unique_ptr<PumpStatusSlot> slot(new PumpStatusSlot());
+	NotifierBenchArgs args = { slot.get(), num_ticks, blocking };
+
+	double cpu_start = processCpuSeconds();
+	auto wall_start = std::chrono::steady_clock::now();
+
+	std::vector<std::unique_ptr<CThread>> waiters;
+	for (int i = 0; i < NUM_WAITERS; i++)
+		waiters.push_back(std::make_unique<CThread>(waitForFill, ACTIVE, &args));
+	CThread pump(pumpTicks, ACTIVE, &args);
+
+	pump.WaitForThread();
+	for (auto& waiter : waiters)
+		waiter->WaitForThread();
+
+	std::chrono::duration<double> wall = std::chrono::steady_clock::now() - wall_start;
+	double cpu = processCpuSeconds() - cpu_start;
+
+	table.row(blocking ? "Blocking" : "Polling", decimals(wall.count(), 3), decimals(cpu, 3));
+}
+
+int
+main(int argc, char* argv[])
+{
+	const int num_ticks = (argc > 1) ? atoi(argv[1]) : 1000;
+
+	std::cout << NUM_WAITERS << " waiters, " << num_ticks << " ticks of 1 ms" << std::endl;
+	table.row("Waiters", "Wall (s)", "CPU (s)");
+
+	runNotifierBench(false, num_ticks);
+	runNotifierBench(true, num_ticks);
+	return 0;
+}
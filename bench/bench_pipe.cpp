@@ -0,0 +1,86 @@
+/*
+ * Microbenchmark for CPipe/CTypedPipe throughput.
+ *
+ * A writer thread pushes fixed-size records through a CTypedPipe while the main thread
+ * reads them back, and the number of records per second is reported for pipelines
+ * holding 1, 16 and 1024 records. The record is the same size as a CustomerRecordWire so the
+ * numbers are representative of the pump pipes.
+ *
+ * The benchmark only uses the public CPipe interface, so the "before" figures are obtained
+ * by building this file against an older rt.cpp.
+ */
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include "rt.h"
+#include "common.h"
+
+struct BenchRecord
+{
+	char payload[sizeof(CustomerRecordWire)];
+};
+
+struct PipeBenchArgs
+{
+	CTypedPipe<BenchRecord>* pipe;
+	int numRecords;
+};
+
+UINT __stdcall
+pipeWriter(void* args)
+{
+	PipeBenchArgs* bench = static_cast<PipeBenchArgs*>(args);
+	BenchRecord record;
+	memset(&record, 0, sizeof(record));
+
+	for (int i = 0; i < bench->numRecords; i++) {
+		memcpy(record.payload, &i, sizeof(i));
+		bench->pipe->Write(&record);
+	}
+	return 0;
+}
+
+static double
+runPipeBench(UINT num_elements, int num_records)
+{
+	CTypedPipe<BenchRecord> pipe("BenchPipe" + std::to_string(num_elements), num_elements);
+	PipeBenchArgs args = { &pipe, num_records };
+	BenchRecord record;
+
+	auto start = std::chrono::steady_clock::now();
+
+	CThread writer(pipeWriter, ACTIVE, &args);
+	for (int i = 0; i < num_records; i++) {
+		pipe.Read(&record);
+
+		int seq = -1;
+		memcpy(&seq, record.payload, sizeof(seq));
+		if (seq != i) {
+			std::cerr << "Error: out of order record " << seq << ", expected " << i << std::endl;
+			break;
+		}
+	}
+	writer.WaitForThread();
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	return num_records / elapsed.count();
+}
+
+int
+main(int argc, char* argv[])
+{
+	const int num_records = (argc > 1) ? atoi(argv[1]) : 20000;
+	const UINT pipe_sizes[] = { 1, 16, 1024 };
+
+	std::cout << "CTypedPipe throughput, " << sizeof(BenchRecord) << "-byte records, "
+		<< num_records << " records per run" << std::endl;
+	std::cout << std::left << std::setw(20) << "Pipe size (records)" << "Records/sec" << std::endl;
+
+	for (UINT size : pipe_sizes) {
+		double rate = runPipeBench(size, num_records);
+		std::cout << std::left << std::setw(20) << size << std::fixed << std::setprecision(0) << rate << std::endl;
+	}
+	return 0;
+}
@@ -0,0 +1,224 @@
+/*
+ * What a flow tick costs on the pump channel: the whole record against a delta.
+ *
+ * A pump runs transactions of TICKS_PER_TXN ticks and, after each one, the Computer takes
+ * what was published and redraws the pump's status block. Both sides run on one thread,
+ * one transaction at a time, so each is timed on its own.
+ *
+ * It is run once the way the pump did it before, publishing the whole CustomerRecordWire
+ * after every tick, with the Computer converting each one back into a CustomerRecord,
+ * comparing it with the previous one and formatting the whole block when they differ, and
+ * once with the 12-byte PumpEvent, with the Computer copying only the fields the event has
+ * changed and formatting only their lines. Reported are the bytes the pump publishes per
+ * tick, the time per tick on each side, and the characters formatted per tick.
+ */
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include "rt.h"
+#include "common.h"
+#include "pump_controller.h"
+#include "bench_util.h"
+
+static const BenchTable table({ 16, 14, 12, 16 });
+
+static const int TICKS_PER_TXN = 14;	// 70 L at 5 L a tick
+static_assert(TICKS_PER_TXN + 1 <= PUMP_EVENT_BATCH, "a transaction's events are taken in one batch");
+
+// what a pump event looked like when it carried the whole record
+struct FullEvent
+{
+	PumpEventType type;
+	CustomerRecordWire record;
+};
+
+// a pump data pool with the whole record after every change, and one with deltas
+struct FullSlot
+{
+	SeqLock<CustomerRecordWire> record;
+	EventRing<FullEvent, PUMP_EVENT_RING_SIZE> events;
+};
+
+struct DeltaBenchResult
+{
+	double pumpNs;
+	double computerNs;
+	long long characters;
+	long long ticks;
+};
+
+static std::string
+formatLine(int row, const CustomerRecord& record)
+{
+	std::ostringstream out;
+	switch (row) {
+	case 1: out << "Name:                      " << record.name; break;
+	case 2: out << "Credit Card Number:        " << record.creditCardNumber; break;
+	case 3: out << "Fuel Grade:                " << fuelGradeToString(record.grade); break;
+	case 4: out << "Unit Cost ($/L):           " << record.unitCost << " (price list " << record.priceVersion << ")"; break;
+	case 5: out << "Requested Volume (L):      " << record.requestedVolume; break;
+	case 6: out << "Received Volume (L):       " << record.receivedVolume; break;
+	case 7: out << "Total Cost ($):            " << record.cost; break;
+	case 8: out << "Transaction Status:        " << txnStatusToString(record.txnStatus); break;
+	}
+	out << "          ";
+	return out.str();
+}
+
+static size_t
+formatBlock(const CustomerRecord& record)
+{
+	std::ostringstream out;
+	out << "--------------- Pump 0 Status ---------------\n";
+	for (int row = 1; row <= 8; row++)
+		out << formatLine(row, record) << "\n";
+	out << "---------------------------------------------\n";
+	return out.str().size();
+}
+
+static CustomerRecord
+benchCustomer()
+{
+	CustomerRecord customer;
+	customer.name = "Bench";
+	customer.creditCardNumber = "1234 5678 9012";
+	customer.grade = FuelGrade::Oct89;
+	customer.unitCost = 4.6f;
+	customer.requestedVolume = TICKS_PER_TXN * DEFAULT_FLOW_RATE;
+	customer.pumpId = 0;
+	return customer;
+}
+
+static double
+since(std::chrono::steady_clock::time_point start)
+{
+	return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+static DeltaBenchResult
+runFull(int num_txns)
+{
+	std::unique_ptr<FullSlot> slot(new FullSlot());
+	CustomerRecord customer = benchCustomer();
+	CustomerRecord data, prev_data;
+	CustomerRecordWire wire;
+	FullEvent batch[PUMP_EVENT_BATCH];
+	uint64_t next = 1;
+	DeltaBenchResult result = { 0, 0, 0, 0 };
+
+	auto publish = [&](PumpEventType type) {
+		toWire(customer, wire);
+		slot->record.write(wire);
+		FullEvent event;
+		event.type = type;
+		event.record = wire;
+		slot->events.push(event);
+	};
+
+	for (int i = 0; i < num_txns; i++) {
+		auto start = std::chrono::steady_clock::now();
+		customer.receivedVolume = 0;
+		customer.cost = 0;
+		customer.txnStatus = TxnStatus::Approved;
+		publish(PumpEventType::TxnStarted);
+		for (int tick = 1; tick <= TICKS_PER_TXN; tick++) {
+			customer.receivedVolume = static_cast<float>(tick * DEFAULT_FLOW_RATE);
+			customer.cost = customer.receivedVolume * customer.unitCost;
+			publish(PumpEventType::Tick);
+		}
+		result.pumpNs += since(start);
+
+		start = std::chrono::steady_clock::now();
+		bool overrun = false;
+		size_t count = slot->events.read(next, batch, PUMP_EVENT_BATCH, overrun);
+		for (size_t j = 0; j < count; j++) {
+			fromWire(batch[j].record, data);
+			if (!(prev_data == data)) {
+				prev_data = data;
+				result.characters += formatBlock(prev_data);
+			}
+		}
+		result.computerNs += since(start);
+		result.ticks += TICKS_PER_TXN;
+	}
+	return result;
+}
+
+static DeltaBenchResult
+runDelta(int num_txns)
+{
+	std::unique_ptr<PumpStatusSlot> slot(new PumpStatusSlot());
+	CustomerRecord customer = benchCustomer();
+	CustomerRecord data;
+	CustomerRecordWire wire;
+	PumpEventReader events(*slot);
+	DeltaBenchResult result = { 0, 0, 0, 0 };
+
+	auto publish = [&](PumpEventType type) {
+		PumpEvent event{};
+		event.type = type;
+		event.changed = PUMP_FIELD_VOLUME | PUMP_FIELD_COST;
+		event.status = static_cast<uint8_t>(customer.txnStatus);
+		event.receivedMl = litresToMl(customer.receivedVolume);
+		event.costMills = dollarsToMills(customer.cost);
+		if (type == PumpEventType::TxnStarted) {
+			event.changed = PUMP_FIELDS_ALL;
+			toWire(customer, wire);
+			slot->publish(event, &wire);
+		}
+		else
+			slot->publish(event, nullptr);
+	};
+
+	for (int i = 0; i < num_txns; i++) {
+		auto start = std::chrono::steady_clock::now();
+		customer.receivedVolume = 0;
+		customer.cost = 0;
+		customer.txnStatus = TxnStatus::Approved;
+		publish(PumpEventType::TxnStarted);
+		for (int tick = 1; tick <= TICKS_PER_TXN; tick++) {
+			customer.receivedVolume = static_cast<float>(tick * DEFAULT_FLOW_RATE);
+			customer.cost = customer.receivedVolume * customer.unitCost;
+			publish(PumpEventType::Tick);
+		}
+		result.pumpNs += since(start);
+
+		// PumpController::readEvents, with each event's lines formatted as printPumpData would
+		start = std::chrono::steady_clock::now();
+		events.apply(data, [&result](const CustomerRecord& record, uint8_t changed) {
+			if (changed == PUMP_FIELDS_ALL) {
+				result.characters += formatBlock(record);
+			}
+			else {
+				if (changed & PUMP_FIELD_VOLUME)
+					result.characters += formatLine(6, record).size();
+				if (changed & PUMP_FIELD_COST)
+					result.characters += formatLine(7, record).size();
+			}
+		});
+		result.computerNs += since(start);
+		result.ticks += TICKS_PER_TXN;
+	}
+	return result;
+}
+
+static void
+report(const char* name, size_t bytes, const DeltaBenchResult& result)
+{
+	table.row(name, bytes, decimals(result.pumpNs / result.ticks, 0), decimals(result.computerNs / result.ticks, 0),
+		decimals(static_cast<double>(result.characters) / result.ticks, 0));
+}
+
+int
+main(int argc, char* argv[])
+{
+	const int num_txns = (argc > 1) ? atoi(argv[1]) : 20000;
+
+	std::cout << num_txns << " transactions of " << TICKS_PER_TXN << " ticks" << std::endl;
+	table.row("Per tick", "Bytes/tick", "Pump (ns)", "Computer (ns)", "Chars drawn");
+
+	report("Whole record", sizeof(CustomerRecordWire) + sizeof(FullEvent), runFull(num_txns));
+	report("PumpEvent", sizeof(PumpEvent), runDelta(num_txns));
+	return 0;
+}
@@ -0,0 +1,187 @@
+/*
+ * A pump publishing its ticks to a Computer that is slow to draw them.
+ *
+ * One pump thread dispenses transactions of TICKS_PER_TXN ticks as fast as it can, and one
+ * Computer thread reads what the pump publishes, spends `draw` microseconds on each record it
+ * reads (a busy console, or a debugger), and archives every transaction that reaches Done.
+ *
+ * It is run once with the producer/consumer semaphore pair the pump used to go through for
+ * every record, so the pump cannot publish its next tick before the Computer has taken the
+ * previous one, and once with a latest-value SeqLock, as the PumpStatusSlot first had, and
+ * the DoneLane that replaced it. Reported are the time the pump took for all its transactions, the median and 99th
+ * percentile of one publish as seen by the pump, how many records the Computer drew, and how
+ * many transactions it archived, which has to be all of them.
+ */
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "rt.h"
+#include "common.h"
+#include "bench_util.h"
+
+static const BenchTable table({ 24, 10, 12, 14, 14, 8 });
+
+static const int TICKS_PER_TXN = 14;	// 70 L at 5 L a tick
+
+// the record the pump publishes, and what the Computer blocks on
+struct StatusChannel
+{
+	SeqLock<CustomerRecordWire> record;
+	ChangeNotifier changed;
+};
+
+struct StatusBenchArgs
+{
+	bool lockStep;
+	int numTxns;
+	int drawUs;
+	StatusChannel* slot;
+	DoneLane* doneLane;
+	CSemaphore* producer;
+	CSemaphore* consumer;
+	std::vector<long long> publishNs;
+	int drawn;
+	int archived;
+};
+
+static void
+spin(int us)
+{
+	auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(us);
+	while (std::chrono::steady_clock::now() < until)
+		;
+}
+
+static void
+publish(StatusBenchArgs* bench, const CustomerRecordWire& wire)
+{
+	auto start = std::chrono::steady_clock::now();
+	if (bench->lockStep) {
+		bench->consumer->Wait();
+		bench->slot->record.write(wire);
+		bench->producer->Signal();
+	}
+	else {
+		bench->slot->record.write(wire);
+		bench->slot->changed.notify();
+	}
+	bench->publishNs.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+UINT __stdcall
+pumpTicks(void* args)
+{
+	StatusBenchArgs* bench = static_cast<StatusBenchArgs*>(args);
+	CustomerRecordWire wire;
+	memset(&wire, 0, sizeof(wire));
+	strcpy(wire.name, "Bench");
+
+	for (int i = 0; i < bench->numTxns; i++) {
+		wire.pumpId = i;
+		wire.setTxnStatus(TxnStatus::Approved);
+		for (int tick = 1; tick <= TICKS_PER_TXN; tick++) {
+			wire.receivedVolume = tick * DEFAULT_FLOW_RATE;
+			publish(bench, wire);
+		}
+		wire.setTxnStatus(TxnStatus::Done);
+		if (!bench->lockStep)
+			bench->doneLane->Write(&wire);
+		publish(bench, wire);
+	}
+	return 0;
+}
+
+// the Computer's runPump(), for each way of publishing
+static void
+readLockStep(StatusBenchArgs& bench)
+{
+	CustomerRecordWire wire;
+	while (bench.archived < bench.numTxns) {
+		bench.producer->Wait();
+		bench.slot->record.read(wire);
+		bench.consumer->Signal();
+
+		spin(bench.drawUs);
+		bench.drawn++;
+		if (wire.txnStatus() == TxnStatus::Done)
+			bench.archived++;
+	}
+}
+
+static void
+readLatest(StatusBenchArgs& bench)
+{
+	CustomerRecordWire wire;
+	uint32_t read_sequence = 0;
+	while (bench.archived < bench.numTxns) {
+		while (true) {
+			uint32_t generation = bench.slot->changed.current();
+			if (bench.slot->record.getSequence() != read_sequence || bench.doneLane->TestForData() > 0)
+				break;
+			bench.slot->changed.waitForChange(generation);
+		}
+		read_sequence = bench.slot->record.getSequence();
+		bench.slot->record.read(wire);
+
+		while (bench.doneLane->TestForData() > 0) {
+			CustomerRecordWire done;
+			bench.doneLane->Read(&done);
+			bench.archived++;
+		}
+
+		spin(bench.drawUs);
+		bench.drawn++;
+	}
+}
+
+static void
+runStatusBench(bool lock_step, int num_txns, int draw_us)
+{
+	std::unique_ptr<StatusChannel> slot(new StatusChannel());
+	memset(static_cast<void*>(slot.get()), 0, sizeof(StatusChannel));
+	std::unique_ptr<DoneLane> done_lane(new DoneLane(lock_step ? "BenchStatusLaneA" : "BenchStatusLaneB", DONE_LANE_SIZE));
+	std::unique_ptr<CSemaphore> producer(new CSemaphore("BenchStatusPS", 0, 1));
+	std::unique_ptr<CSemaphore> consumer(new CSemaphore("BenchStatusCS", 1, 1));
+
+	StatusBenchArgs bench;
+	bench.lockStep = lock_step;
+	bench.numTxns = num_txns;
+	bench.drawUs = draw_us;
+	bench.slot = slot.get();
+	bench.doneLane = done_lane.get();
+	bench.producer = producer.get();
+	bench.consumer = consumer.get();
+	bench.publishNs.reserve(static_cast<size_t>(num_txns) * (TICKS_PER_TXN + 1));
+	bench.drawn = 0;
+	bench.archived = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	CThread pump(pumpTicks, ACTIVE, &bench);
+	if (lock_step)
+		readLockStep(bench);
+	else
+		readLatest(bench);
+	pump.WaitForThread();
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+	Percentiles<long long> publish = percentiles(bench.publishNs);
+	table.row(lock_step ? "Semaphore pair" : "SeqLock + DoneLane", draw_us, decimals(elapsed.count(), 1), publish.median,
+		publish.p99, bench.drawn, std::to_string(bench.archived) + "/" + std::to_string(num_txns));
+}
+
+int
+main(int argc, char* argv[])
+{
+	const int num_txns = (argc > 1) ? atoi(argv[1]) : 200;
+	const int draw_us[] = { 0, 100, 1000 };
+
+	std::cout << num_txns << " transactions of " << TICKS_PER_TXN << " ticks" << std::endl;
+	table.row("Channel", "Draw (us)", "Pump (ms)", "Publish med", "Publish p99", "Drawn", "Archived");
+
+	for (int draw : draw_us) {
+		runStatusBench(true, num_txns, draw);
+		runStatusBench(false, num_txns, draw);
+	}
+	return 0;
+}
@@ -0,0 +1,131 @@
+/*
+ * What drawing costs the threads that draw.
+ *
+ * DEFAULT_NUM_PUMPS threads redraw a pump status block (the 12 lines PumpController prints) as
+ * fast as they can, first the old way, holding a CMutex around MOVE_CURSOR and the
+ * std::cout lines, then by handing the block to the ScreenRenderer. The time each redraw
+ * keeps its thread busy is reported as the median and 99th percentile.
+ *
+ * The console is what makes the old way slow, so run this with stdout on a terminal; the
+ * results go to stderr and are printed once the screen has been drawn.
+ */
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <vector>
+#include "rt.h"
+#include "common.h"
+#include "screen_renderer.h"
+#include "bench_util.h"
+
+static const BenchTable table({ 20, 12, 14 });
+
+static const int BLOCK_HEIGHT = 12;
+
+struct DrawArgs
+{
+	bool useRenderer;
+	CMutex* windowMutex;
+	int redraws;
+	std::vector<std::vector<long long>> latencies;
+};
+
+struct DrawerArgs
+{
+	DrawArgs* bench;
+	int id;
+};
+
+static std::string
+statusBlock(int id, int redraw)
+{
+	std::ostringstream out;
+	out << "--------------- Pump " << id << " Status ---------------\n";
+	out << "Name:                      Customer" << redraw % 100 << "          \n";
+	out << "Credit Card Number:        1234 5678 " << 1000 + redraw % 9000 << "          \n";
+	out << "Fuel Grade:                Oct 89          \n";
+	out << "Unit Cost ($/L):           4.6          \n";
+	out << "Requested Volume (L):      60          \n";
+	out << "Received Volume (L):       " << redraw % 61 << "          \n";
+	out << "Total Cost ($):            " << (redraw % 61) * 4.6 << "          \n";
+	out << "Transaction Status:        Dispensing          \n";
+	out << "---------------------------------------------\n";
+	return out.str();
+}
+
+UINT __stdcall
+drawPump(void* args)
+{
+	DrawerArgs* drawer = static_cast<DrawerArgs*>(args);
+	DrawArgs* bench = drawer->bench;
+	std::vector<long long>& latencies = bench->latencies[drawer->id];
+	const int row = drawer->id * BLOCK_HEIGHT;
+
+	for (int i = 0; i < bench->redraws; i++) {
+		std::string block = statusBlock(drawer->id, i);
+
+		auto start = std::chrono::steady_clock::now();
+		if (bench->useRenderer) {
+			ScreenRenderer::get().print(0, row, block);
+		}
+		else {
+			bench->windowMutex->Wait();
+			MOVE_CURSOR(0, row);
+			std::cout << block << std::flush;
+			bench->windowMutex->Signal();
+		}
+		latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+	}
+	return 0;
+}
+
+static std::string
+runDrawBench(bool use_renderer, int redraws, CMutex& window_mutex)
+{
+	DrawArgs bench;
+	bench.useRenderer = use_renderer;
+	bench.windowMutex = &window_mutex;
+	bench.redraws = redraws;
+	bench.latencies.resize(DEFAULT_NUM_PUMPS);
+
+	std::vector<DrawerArgs> drawers(DEFAULT_NUM_PUMPS);
+	std::vector<std::unique_ptr<CThread>> threads;
+
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < DEFAULT_NUM_PUMPS; i++) {
+		drawers[i] = { &bench, i };
+		bench.latencies[i].reserve(redraws);
+		threads.emplace_back(new CThread(drawPump, ACTIVE, &drawers[i]));
+	}
+	for (auto& thread : threads)
+		thread->WaitForThread();
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	if (use_renderer)
+		ScreenRenderer::get().flush();
+
+	std::vector<long long> all;
+	for (auto& latencies : bench.latencies)
+		all.insert(all.end(), latencies.begin(), latencies.end());
+	Percentiles<long long> latency = percentiles(all);
+
+	return table.line(use_renderer ? "ScreenRenderer" : "CMutex + cout", decimals(elapsed.count(), 3), latency.median,
+		latency.p99) + "\n";
+}
+
+int
+main(int argc, char* argv[])
+{
+	const int redraws = (argc > 1) ? atoi(argv[1]) : 20000;
+	CMutex window_mutex("BenchScreenWindowMutex");
+
+	std::string results;
+	results += runDrawBench(false, redraws, window_mutex);
+	results += runDrawBench(true, redraws, window_mutex);
+
+	MOVE_CURSOR(0, DEFAULT_NUM_PUMPS * BLOCK_HEIGHT);
+	std::cout << std::flush;
+	std::cerr << DEFAULT_NUM_PUMPS << " threads, " << redraws << " redraws of a pump status block each\n"
+		<< table.line("Drawing", "Time (s)", "Median (ns)", "p99 (ns)") << "\n" << results;
+	return 0;
+}
@@ -0,0 +1,146 @@
+/*
+ * Stress test for the seqlock that publishes the pump status.
+ *
+ * One writer thread publishes a CustomerRecordWire in which every field is derived from
+ * the same counter, while 0, 4, 16 and 64 reader threads poll it as fast as they can, the
+ * way Customer::getFuel polls a pump. Each reader checks that all fields of every snapshot
+ * agree, so a torn record is counted as soon as one is seen. The writer's latency per
+ * update is reported as the median and 99th percentile, once for the SeqLock and once for
+ * the CReadersWritersMutex it replaced.
+ */
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "rt.h"
+#include "common.h"
+#include "seqlock.h"
+#include "bench_util.h"
+
+static const BenchTable table({ 10, 10, 14, 12, 16 });
+
+static void
+fillRecord(CustomerRecordWire& record, int32_t counter)
+{
+	memset(&record, 0, sizeof(record));
+	memset(record.name, 'a' + counter % 26, sizeof(record.name) - 1);
+	memset(record.creditCardNumber, '0' + counter % 10, sizeof(record.creditCardNumber) - 1);
+	record.requestedVolume = record.receivedVolume = record.unitCost = record.cost = static_cast<float>(counter);
+	record.nowTime = counter;
+	record.pumpId = counter;
+}
+
+static bool
+isConsistent(const CustomerRecordWire& record)
+{
+	int32_t counter = record.pumpId;
+	CustomerRecordWire expected;
+	fillRecord(expected, counter);
+	return memcmp(&record, &expected, sizeof(record)) == 0;
+}
+
+/*
+ * The two ways of publishing a record, behind the same interface.
+ */
+class SeqLockSlot
+{
+	SeqLock<CustomerRecordWire> slot = {};
+public:
+	static const char* name() { return "SeqLock"; }
+	void write(const CustomerRecordWire& record) { slot.write(record); }
+	void read(CustomerRecordWire& record) { slot.read(record); }
+};
+
+class RwMutexSlot
+{
+	CustomerRecordWire slot = {};
+	CReadersWritersMutex mutex;
+public:
+	RwMutexSlot() : mutex("BenchSeqLockRwMutex") {}
+	static const char* name() { return "RWMutex"; }
+	void write(const CustomerRecordWire& record) { mutex.WaitToWrite(); slot = record; mutex.DoneWriting(); }
+	void read(CustomerRecordWire& record) { mutex.WaitToRead(); record = slot; mutex.DoneReading(); }
+};
+
+template <class Slot>
+struct StressArgs
+{
+	Slot* slot;
+	std::atomic<bool> stop;
+	std::atomic<long long> reads;
+	std::atomic<long long> tornReads;
+};
+
+template <class Slot>
+UINT __stdcall
+pollingReader(void* args)
+{
+	StressArgs<Slot>* stress = static_cast<StressArgs<Slot>*>(args);
+	CustomerRecordWire record;
+	long long reads = 0, torn = 0;
+
+	while (!stress->stop.load(std::memory_order_relaxed)) {
+		stress->slot->read(record);
+		if (!isConsistent(record))
+			torn++;
+		reads++;
+	}
+
+	stress->reads += reads;
+	stress->tornReads += torn;
+	return 0;
+}
+
+template <class Slot>
+static void
+runStress(int num_readers, int num_writes)
+{
+	Slot slot;
+	StressArgs<Slot> args;
+	args.slot = &slot;
+	args.stop = false;
+	args.reads = 0;
+	args.tornReads = 0;
+
+	CustomerRecordWire record;
+	fillRecord(record, 0);
+	slot.write(record);
+
+	std::vector<std::unique_ptr<CThread>> readers;
+	for (int i = 0; i < num_readers; i++)
+		readers.push_back(std::make_unique<CThread>(pollingReader<Slot>, ACTIVE, &args));
+
+	std::vector<long long> latencies;
+	latencies.reserve(num_writes);
+	for (int i = 1; i <= num_writes; i++) {
+		fillRecord(record, i);
+		auto start = std::chrono::steady_clock::now();
+		slot.write(record);
+		latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	args.stop = true;
+	for (auto& reader : readers)
+		reader->WaitForThread();
+
+	Percentiles<long long> latency = percentiles(latencies);
+	table.row(Slot::name(), num_readers, args.reads.load(), args.tornReads.load(), latency.median, latency.p99);
+}
+
+int
+main(int argc, char* argv[])
+{
+	const int num_writes = (argc > 1) ? atoi(argv[1]) : 20000;
+	const int reader_counts[] = { 0, 4, 16, 64 };
+
+	std::cout << num_writes << " writes per run" << std::endl;
+	table.row("Slot", "Readers", "Reads", "Torn", "Median (ns)", "p99 (ns)");
+
+	for (int num_readers : reader_counts) {
+		runStress<SeqLockSlot>(num_readers, num_writes);
+		runStress<RwMutexSlot>(num_readers, num_writes);
+	}
+	return 0;
+}
@@ -0,0 +1,104 @@
+/*
+ * Throughput and latency of SpscTypedPipe compared with CTypedPipe.
+ *
+ * For each pipe type and size a writer thread sends timestamped records to the main
+ * thread. Throughput is the number of records per second over the whole run, and latency
+ * is the time from Write() being called to Read() returning the record, reported as the
+ * median and 99th percentile.
+ */
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "rt.h"
+#include "common.h"
+#include "spsc_pipe.h"
+#include "bench_util.h"
+
+static const BenchTable table({ 16, 10, 16, 14 });
+
+struct BenchRecord
+{
+	long long sentAt;		// steady_clock ticks when the record was written
+	int seq;
+	char payload[sizeof(CustomerRecordWire) - sizeof(long long) - sizeof(int)];
+};
+
+static long long
+nowTicks()
+{
+	return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+template <class Pipe>
+struct PipeBenchArgs
+{
+	Pipe* pipe;
+	int numRecords;
+};
+
+template <class Pipe>
+UINT __stdcall
+pipeWriter(void* args)
+{
+	PipeBenchArgs<Pipe>* bench = static_cast<PipeBenchArgs<Pipe>*>(args);
+	BenchRecord record;
+	memset(&record, 0, sizeof(record));
+
+	for (int i = 0; i < bench->numRecords; i++) {
+		record.seq = i;
+		record.sentAt = nowTicks();
+		bench->pipe->Write(&record);
+	}
+	return 0;
+}
+
+template <class Pipe>
+static void
+runPipeBench(const std::string& label, UINT num_elements, int num_records)
+{
+	Pipe pipe(label + std::to_string(num_elements), num_elements);
+	PipeBenchArgs<Pipe> args = { &pipe, num_records };
+	std::vector<long long> latencies;
+	latencies.reserve(num_records);
+	BenchRecord record;
+
+	auto start = std::chrono::steady_clock::now();
+
+	CThread writer(pipeWriter<Pipe>, ACTIVE, &args);
+	for (int i = 0; i < num_records; i++) {
+		pipe.Read(&record);
+		latencies.push_back(nowTicks() - record.sentAt);
+		if (record.seq != i) {
+			std::cerr << "Error: out of order record " << record.seq << ", expected " << i << std::endl;
+			break;
+		}
+	}
+	writer.WaitForThread();
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	Percentiles<long long> latency = percentiles(latencies);
+
+	// steady_clock ticks are converted to microseconds for display
+	const double tick_us = 1e6 * std::chrono::steady_clock::period::num / std::chrono::steady_clock::period::den;
+
+	table.row(label, num_elements, decimals(num_records / elapsed.count(), 0), decimals(latency.median * tick_us, 2),
+		decimals(latency.p99 * tick_us, 2));
+}
+
+int
+main(int argc, char* argv[])
+{
+	const int num_records = (argc > 1) ? atoi(argv[1]) : 20000;
+	const UINT pipe_sizes[] = { 1, 16, 1024 };
+
+	std::cout << sizeof(BenchRecord) << "-byte records, " << num_records << " records per run" << std::endl;
+	table.row("Pipe", "Size", "Records/sec", "Median (us)", "p99 (us)");
+
+	for (UINT size : pipe_sizes) {
+		runPipeBench<CTypedPipe<BenchRecord>>("CTypedPipe", size, num_records);
+		runPipeBench<SpscTypedPipe<BenchRecord>>("SpscTypedPipe", size, num_records);
+	}
+	return 0;
+}
@@ -0,0 +1,183 @@
+/*
+ * Several pumps dispensing from one tank.
+ *
+ * DEFAULT_NUM_PUMPS threads serve customers from the same tank as fast as they can, the way
+ * Pump::getFuel does without the flow tick sleeps, until the tank can no longer cover a
+ * request. The tank holds less than the customers ask for, so the pumps end up competing
+ * for the last of it.
+ *
+ * It is run once for the tank as it was, a float under a CMutex that the pump checked
+ * before dispensing and then drained DEFAULT_FLOW_RATE at a time, and once for the TankData that
+ * replaced it, where the whole request is reserved before dispensing. Reported are the time
+ * each tick took, the customers served, and those who were let start but ran the tank dry
+ * before getting what they asked for.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+#include "rt.h"
+#include "common.h"
+#include "bench_util.h"
+
+static const BenchTable table({ 16, 10, 14, 12, 10 });
+
+const float BENCH_TANK_LITRES = 2000000.0f;
+const int32_t BENCH_FLOW_RATE_ML = litresToMl(DEFAULT_FLOW_RATE);
+
+class MutexTank
+{
+	CMutex mutex;
+	float remainingVolume;
+public:
+	MutexTank() : mutex("BenchTankMutex"), remainingVolume(BENCH_TANK_LITRES) {}
+	static const char* name() { return "CMutex + float"; }
+
+	float readVolume()
+	{
+		mutex.Wait();
+		float volume = remainingVolume;
+		mutex.Signal();
+		return volume;
+	}
+
+	bool decrement()
+	{
+		bool dispensed = false;
+		mutex.Wait();
+		if (remainingVolume - DEFAULT_FLOW_RATE >= 0) {
+			dispensed = true;
+			remainingVolume -= DEFAULT_FLOW_RATE;
+		}
+		mutex.Signal();
+		return dispensed;
+	}
+
+	// the old Pump::getFuel: false if the customer was turned away
+	bool serve(float requested, float& received, std::vector<long long>& ticks)
+	{
+		if (readVolume() < requested)
+			return false;
+		do {
+			auto start = std::chrono::steady_clock::now();
+			bool dispensed = decrement();
+			ticks.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+			if (!dispensed)
+				break;
+			received += DEFAULT_FLOW_RATE;
+		} while (received < requested);
+		return true;
+	}
+};
+
+class AtomicTank
+{
+	TankData data;
+public:
+	AtomicTank()
+	{
+		data.capacityMl = litresToMl(BENCH_TANK_LITRES);
+		data.remainingMl.store(litresToMl(BENCH_TANK_LITRES));
+		data.availableMl.store(litresToMl(BENCH_TANK_LITRES));
+	}
+	static const char* name() { return "TankData"; }
+
+	bool serve(float requested, float& received, std::vector<long long>& ticks)
+	{
+		int32_t reserved_ml = litresToMl(requested);
+		if (!data.reserve(reserved_ml))
+			return false;
+		int32_t received_ml = 0;
+		while (received_ml < reserved_ml) {
+			int32_t tick_ml = std::min(BENCH_FLOW_RATE_ML, reserved_ml - received_ml);
+			auto start = std::chrono::steady_clock::now();
+			data.drain(tick_ml);
+			ticks.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+			received_ml += tick_ml;
+		}
+		received = mlToLitres(received_ml);
+		return true;
+	}
+};
+
+template <class Tank>
+struct TankArgs
+{
+	Tank* tank;
+	std::vector<std::vector<long long>> ticks;
+	std::atomic<int> served;
+	std::atomic<int> shortChanged;
+};
+
+template <class Tank>
+struct PumpArgs
+{
+	TankArgs<Tank>* bench;
+	int id;
+};
+
+template <class Tank>
+UINT __stdcall
+servePump(void* args)
+{
+	PumpArgs<Tank>* pump = static_cast<PumpArgs<Tank>*>(args);
+	TankArgs<Tank>* bench = pump->bench;
+	std::mt19937 rng(pump->id);
+	std::uniform_int_distribution<int> litres(MIN_LITERS, MAX_LITERS);
+
+	while (true) {
+		float requested = static_cast<float>(litres(rng));
+		float received = 0.0f;
+		if (!bench->tank->serve(requested, received, bench->ticks[pump->id]))
+			break;
+		bench->served++;
+		if (received < requested)
+			bench->shortChanged++;
+	}
+	return 0;
+}
+
+template <class Tank>
+static void
+runTankBench()
+{
+	std::unique_ptr<Tank> tank(new Tank());
+	TankArgs<Tank> bench;
+	bench.tank = tank.get();
+	bench.ticks.resize(DEFAULT_NUM_PUMPS);
+	bench.served = 0;
+	bench.shortChanged = 0;
+
+	std::vector<PumpArgs<Tank>> pumps(DEFAULT_NUM_PUMPS);
+	std::vector<std::unique_ptr<CThread>> threads;
+
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < DEFAULT_NUM_PUMPS; i++) {
+		pumps[i] = { &bench, i };
+		threads.emplace_back(new CThread(servePump<Tank>, ACTIVE, &pumps[i]));
+	}
+	for (auto& thread : threads)
+		thread->WaitForThread();
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	std::vector<long long> all;
+	for (auto& ticks : bench.ticks)
+		all.insert(all.end(), ticks.begin(), ticks.end());
+	Percentiles<long long> tick = percentiles(all);
+
+	table.row(Tank::name(), decimals(elapsed.count(), 3), tick.median, tick.p99, bench.served, bench.shortChanged);
+}
+
+int
+main()
+{
+	std::cout << DEFAULT_NUM_PUMPS << " pumps sharing a tank of " << static_cast<long>(BENCH_TANK_LITRES) << " litres" << std::endl;
+	table.row("Tank", "Time (s)", "Tick median", "Tick p99", "Served", "Ran dry");
+
+	runTankBench<MutexTank>();
+	runTankBench<AtomicTank>();
+	return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * End-to-end cost of one transaction on the customer/pump path, without the sleeps.
+ *
+ * A customer thread hands a CustomerRecord to a pump thread through a PumpPipe (toWire,
+ * Write, Read, fromWire), exactly as Customer::writePipe and Pump::readPipe do. The pump
+ * then dispenses the request in DEFAULT_FLOW_RATE ticks, publishing every tick as an event in
+ * a PumpStatusSlot, while the customer blocks on the slot's ChangeNotifier until it sees its
+ * own transaction marked Done. The time from the customer writing its record to it seeing
+ * Done is reported as the median and 99th percentile, next to the transaction rate.
+ */
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "rt.h"
+#include "common.h"
+#include "futex.h"
+#include "bench_util.h"
+
+static const BenchTable table({ 14, 16, 16 });
+
+struct TxnBenchArgs
+{
+	PumpPipe* pipe;
+	PumpStatusSlot* slot;
+	int numTxns;
+	float requestedVolume;
+};
+
+/*
+ * What Pump::sendTransactionInfo publishes: the whole record when the transaction starts, and
+ * a PumpEvent for every change.
+ */
+static void
+publish(PumpStatusSlot* slot, const CustomerRecord& customer, PumpEventType type, int txn)
+{
+	PumpEvent event{};
+	event.type = type;
+	event.changed = (type == PumpEventType::Tick) ? (PUMP_FIELD_VOLUME | PUMP_FIELD_COST) : PUMP_FIELD_STATUS;
+	event.status = static_cast<uint8_t>(customer.txnStatus);
+	event.receivedMl = litresToMl(customer.receivedVolume);
+	event.costMills = dollarsToMills(customer.cost);
+
+	if (type == PumpEventType::TxnStarted) {
+		event.changed = PUMP_FIELDS_ALL;
+		CustomerRecordWire record;
+		toWire(customer, record);
+		record.nowTime = txn + 1;		// lets the customer tell its transaction from the previous one
+		slot->publish(event, &record);
+	}
+	else
+		slot->publish(event, nullptr);
+}
+
+/*
+ * The pump half of the transaction: what Pump::main does between readPipe() and resetPump().
+ */
+UINT __stdcall
+pumpTxns(void* args)
+{
+	TxnBenchArgs* bench = static_cast<TxnBenchArgs*>(args);
+	CustomerRecordWire wire;
+	CustomerRecord customer;
+
+	for (int i = 0; i < bench->numTxns; i++) {
+		bench->pipe->Read(&wire);
+		fromWire(wire, customer);
+		customer.pumpId = 0;
+		customer.unitCost = 4.1f;
+		customer.txnStatus = TxnStatus::Approved;
+		publish(bench->slot, customer, PumpEventType::TxnStarted, i);
+
+		while (customer.receivedVolume < customer.requestedVolume) {
+			customer.receivedVolume = std::min(customer.receivedVolume + DEFAULT_FLOW_RATE, customer.requestedVolume);
+			customer.cost = customer.receivedVolume * customer.unitCost;
+			publish(bench->slot, customer, PumpEventType::Tick, i);
+		}
+
+		customer.txnStatus = TxnStatus::Done;
+		publish(bench->slot, customer, PumpEventType::Done, i);
+	}
+	return 0;
+}
+
+static void
+runTxnBench(int num_txns, float requested_volume)
+{
+	std::unique_ptr<PumpPipe> pipe(new PumpPipe("BenchTxnPipe", 1));
+	std::unique_ptr<PumpStatusSlot> slot(new PumpStatusSlot());
+	TxnBenchArgs args = { pipe.get(), slot.get(), num_txns, requested_volume };
+
+	std::vector<long long> latencies;
+	latencies.reserve(num_txns);
+
+	CustomerRecord customer;
+	customer.name = "Bench";
+	customer.creditCardNumber = "1234 5678 9012";
+	customer.grade = FuelGrade::Oct87;
+	customer.requestedVolume = requested_volume;
+	CustomerRecordWire wire;
+
+	auto start = std::chrono::steady_clock::now();
+	CThread pump(pumpTxns, ACTIVE, &args);
+
+	for (int i = 0; i < num_txns; i++) {
+		auto sent = std::chrono::steady_clock::now();
+		toWire(customer, wire);
+		pipe->Write(&wire);
+
+		// the customer's side of Customer::getFuel()
+		while (true) {
+			uint32_t generation = slot->changed.current();
+			CustomerRecordWire snapshot;
+			slot->read(snapshot);
+			if (snapshot.nowTime == i + 1 && snapshot.txnStatus() == TxnStatus::Done)
+				break;
+			slot->changed.waitForChange(generation);
+		}
+		latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - sent).count());
+	}
+	pump.WaitForThread();
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	Percentiles<long long> latency = percentiles(latencies);
+
+	table.row(requested_volume, decimals(num_txns / elapsed.count(), 0), latency.median, latency.p99);
+}
+
+int
+main(int argc, char* argv[])
+{
+	const int num_txns = (argc > 1) ? atoi(argv[1]) : 20000;
+	const float volumes[] = { DEFAULT_FLOW_RATE, 35.0f, 70.0f };
+
+	std::cout << num_txns << " transactions per run, " << DEFAULT_FLOW_RATE << " L per tick" << std::endl;
+	table.row("Volume (L)", "Txns/sec", "Median (ns)", "p99 (ns)");
+
+	for (float volume : volumes)
+		runTxnBench(num_txns, volume);
+	return 0;
+}
@@ -0,0 +1,165 @@
+/*
+ * Looking up a day of transactions with `pt` filters.
+ *
+ * A TxnStore is filled with a day of traffic spread evenly over 24 hours: random pumps,
+ * grades and cards, a few visits per card. Each query is then answered once by the
+ * TxnIndex and once by scanning the whole store, the way the plain history would have to,
+ * and the median time of each is reported next to the number of matches.
+ */
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+#include "rt.h"
+#include "common.h"
+#include "txn_index.h"
+#include "txn_journal.h"
+#include "txn_store.h"
+#include "bench_util.h"
+
+static const BenchTable table({ 34, 10, 16 });
+
+static const int REPEATS = 21;
+
+static int64_t
+midnightToday()
+{
+	std::time_t now = std::time(nullptr);
+	std::tm midnight = epochToTimestamp(static_cast<int64_t>(now));
+	midnight.tm_hour = 0;
+	midnight.tm_min = 0;
+	midnight.tm_sec = 0;
+	return timestampToEpoch(midnight);
+}
+
+static void
+fillStore(TxnStore& store, int num_txns, int num_cards, int64_t midnight)
+{
+	std::mt19937_64 rng(2024);
+	std::uniform_int_distribution<int> pump(0, DEFAULT_NUM_PUMPS - 1);
+	std::uniform_int_distribution<int> grade(0, MAX_TANKS - 1);
+	std::uniform_int_distribution<int> card(0, num_cards - 1);
+	std::uniform_int_distribution<int> jitter(0, 59);
+
+	CustomerRecordWire txn;
+	for (int i = 0; i < num_txns; i++) {
+		memset(&txn, 0, sizeof(txn));
+		int c = card(rng);
+		snprintf(txn.creditCardNumber, sizeof(txn.creditCardNumber), "%04d %04d %04d", 4000 + c % 1000, c / 1000, 1000 + c % 9000);
+		snprintf(txn.name, sizeof(txn.name), "Customer%d", c);
+		txn.pumpId = pump(rng);
+		txn.setGrade(intToFuelGrade(grade(rng)));
+		txn.setTxnStatus(TxnStatus::Archived);
+		txn.receivedVolume = 40.0f;
+		txn.cost = 80.0f;
+		// in about the order the pumps finish: a minute either way
+		txn.nowTime = midnight + static_cast<int64_t>(i) * 86400 / num_txns + jitter(rng) - 30;
+		store.append(txn);
+	}
+}
+
+/*
+ * What answering the query without an index costs: every transaction is read and checked.
+ */
+static size_t
+scanStore(const TxnStore& store, const TxnQuery& query, int64_t midnight)
+{
+	size_t found = 0;
+	CustomerRecordWire txn;
+	for (uint64_t i = 0; store.at(i, txn); i++) {
+		if (query.pumpId >= 0 && txn.pumpId != query.pumpId)
+			continue;
+		if (query.grade >= 0 && fuelGradeToInt(txn.grade()) != query.grade)
+			continue;
+		if (query.since >= 0 && txn.nowTime < midnight + query.since)
+			continue;
+		if (query.until >= 0 && txn.nowTime > midnight + query.until)
+			continue;
+		if (query.card[0] != '\0') {
+			std::string digits;
+			for (const char* c = txn.creditCardNumber; *c != '\0'; c++) {
+				if (*c != ' ')
+					digits.push_back(*c);
+			}
+			size_t length = strlen(query.card);
+			if (digits.size() < length || digits.compare(digits.size() - length, length, query.card) != 0)
+				continue;
+		}
+		found++;
+	}
+	return found;
+}
+
+template <class Lookup>
+static double
+medianMicroseconds(Lookup lookup, size_t& found)
+{
+	std::vector<double> times;
+	for (int i = 0; i < REPEATS; i++) {
+		auto start = std::chrono::steady_clock::now();
+		found = lookup();
+		times.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+	}
+	return percentiles(times).median;
+}
+
+int
+main(int argc, char* argv[])
+{
+	const int num_txns = (argc > 1) ? atoi(argv[1]) : 100000;
+	const int num_cards = num_txns / 4;
+	const int64_t midnight = midnightToday();
+
+	std::unique_ptr<TxnStore> store(new TxnStore());
+	fillStore(*store, num_txns, num_cards, midnight);
+
+	TxnHistory history(*store);
+	TxnIndex index(history);
+	auto start = std::chrono::steady_clock::now();
+	index.catchUp();
+	std::chrono::duration<double, std::milli> build = std::chrono::steady_clock::now() - start;
+
+	// a card that is in the store, by all twelve digits and by the last four
+	CustomerRecordWire sample;
+	store->at(num_txns / 2, sample);
+	std::string card;
+	for (const char* c = sample.creditCardNumber; *c != '\0'; c++) {
+		if (*c != ' ')
+			card.push_back(*c);
+	}
+
+	const char* filters[] = {
+		nullptr,
+		nullptr,
+		"pump=3",
+		"pump=3 since=10:00 until=11:00",
+		"grade=1 since=18:00",
+		"since=12:00 until=12:05",
+	};
+	std::string full = "card=" + card, ending = "card=" + card.substr(8);
+	filters[0] = full.c_str();
+	filters[1] = ending.c_str();
+
+	std::cout << num_txns << " transactions over one day, indexed in " << std::fixed << std::setprecision(1)
+		<< build.count() << " ms" << std::endl;
+	table.row("Query", "Matches", "Index (us)", "Scan (us)");
+
+	for (const char* filter : filters) {
+		TxnQuery query;
+		if (!parseTxnQuery(filter, query)) {
+			std::cout << "Cannot parse " << filter << std::endl;
+			return 1;
+		}
+
+		size_t indexed = 0, scanned = 0;
+		double index_us = medianMicroseconds([&] { return index.query(query, midnight).size(); }, indexed);
+		double scan_us = medianMicroseconds([&] { return scanStore(*store, query, midnight); }, scanned);
+		if (indexed != scanned)
+			std::cout << "Mismatch: the index found " << indexed << " and the scan " << scanned << std::endl;
+
+		table.row(filter, indexed, decimals(index_us, 1), decimals(scan_us, 1));
+	}
+	return 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * Archiving transactions while the history is being printed.
+ *
+ * DEFAULT_NUM_PUMPS writer threads archive transactions as fast as they can, the way the Computer's
+ * runPump threads do, while a reader keeps printing whatever is new, the way `pt` does (the
+ * printing itself is left out). This is run once for the TxnStore and once for the
+ * std::list under a CMutex that it replaced, whose reader had to std::advance past every
+ * transaction it had already printed. The writers' latency per append is reported as the
+ * median and 99th percentile, next to the time it took to archive everything.
+ */
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <vector>
+#include "rt.h"
+#include "common.h"
+#include "txn_store.h"
+#include "bench_util.h"
+
+static const BenchTable table({ 12, 12, 14, 14 });
+
+/*
+ * The two archives, behind the same interface.
+ */
+class ChunkedArchive
+{
+	TxnStore store;
+	TxnStore::Cursor cursor;
+public:
+	static const char* name() { return "TxnStore"; }
+	void append(const CustomerRecordWire& txn) { store.append(txn); }
+	size_t readNew()
+	{
+		CustomerRecordWire txn;
+		size_t read = 0;
+		while (store.read(cursor, txn))
+			read++;
+		return read;
+	}
+};
+
+class ListArchive
+{
+	std::list<CustomerRecordWire> txns;
+	CMutex mutex;
+	size_t lastSize = 0;
+public:
+	ListArchive() : mutex("BenchTxnStoreListMutex") {}
+	static const char* name() { return "std::list"; }
+	void append(const CustomerRecordWire& txn) { mutex.Wait(); txns.push_back(txn); mutex.Signal(); }
+	size_t readNew()
+	{
+		size_t read = 0;
+		mutex.Wait();
+		auto it = txns.begin();
+		std::advance(it, lastSize);
+		for (; it != txns.end(); ++it)
+			read++;
+		lastSize = txns.size();
+		mutex.Signal();
+		return read;
+	}
+};
+
+template <class Archive>
+struct ArchiveArgs
+{
+	Archive* archive;
+	int txnsPerWriter;
+	std::vector<std::vector<long long>> latencies;
+	std::atomic<int> writersDone;
+};
+
+template <class Archive>
+struct WriterArgs
+{
+	ArchiveArgs<Archive>* bench;
+	int id;
+};
+
+template <class Archive>
+UINT __stdcall
+archiveTxns(void* args)
+{
+	WriterArgs<Archive>* writer = static_cast<WriterArgs<Archive>*>(args);
+	ArchiveArgs<Archive>* bench = writer->bench;
+	std::vector<long long>& latencies = bench->latencies[writer->id];
+
+	CustomerRecordWire txn;
+	memset(&txn, 0, sizeof(txn));
+	txn.pumpId = writer->id;
+
+	for (int i = 0; i < bench->txnsPerWriter; i++) {
+		txn.nowTime = i;
+		auto start = std::chrono::steady_clock::now();
+		bench->archive->append(txn);
+		latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+	}
+	bench->writersDone++;
+	return 0;
+}
+
+template <class Archive>
+static void
+runArchiveBench(int txns_per_writer)
+{
+	std::unique_ptr<Archive> archive(new Archive());
+	ArchiveArgs<Archive> bench;
+	bench.archive = archive.get();
+	bench.txnsPerWriter = txns_per_writer;
+	bench.latencies.resize(DEFAULT_NUM_PUMPS);
+	bench.writersDone = 0;
+
+	std::vector<WriterArgs<Archive>> writers(DEFAULT_NUM_PUMPS);
+	std::vector<std::unique_ptr<CThread>> threads;
+
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < DEFAULT_NUM_PUMPS; i++) {
+		writers[i] = { &bench, i };
+		bench.latencies[i].reserve(txns_per_writer);
+		threads.emplace_back(new CThread(archiveTxns<Archive>, ACTIVE, &writers[i]));
+	}
+
+	size_t printed = 0;
+	while (bench.writersDone < DEFAULT_NUM_PUMPS)
+		printed += archive->readNew();
+	for (auto& thread : threads)
+		thread->WaitForThread();
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	printed += archive->readNew();
+
+	std::vector<long long> all;
+	for (auto& latencies : bench.latencies)
+		all.insert(all.end(), latencies.begin(), latencies.end());
+	Percentiles<long long> latency = percentiles(all);
+
+	table.row(Archive::name(), decimals(elapsed.count(), 3), latency.median, latency.p99, printed);
+}
+
+int
+main(int argc, char* argv[])
+{
+	const int txns_per_writer = (argc > 1) ? atoi(argv[1]) : 20000;
+
+	std::cout << DEFAULT_NUM_PUMPS << " writers, " << txns_per_writer << " transactions each, one reader printing new ones" << std::endl;
+	table.row("Archive", "Time (s)", "Median (ns)", "p99 (ns)", "Printed");
+
+	runArchiveBench<ChunkedArchive>(txns_per_writer);
+	runArchiveBench<ListArchive>(txns_per_writer);
+	return 0;
+}
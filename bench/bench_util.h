@@ -0,0 +1,84 @@
+#ifndef __BENCH_UTIL_H__
+#define __BENCH_UTIL_H__
+
+#include <algorithm>
+#include <initializer_list>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+ * What the benches report with: percentiles of the samples a run took, and a table printed
+ * a row per run.
+ */
+
+template <class T>
+struct Percentiles
+{
+	T median;
+	T p99;
+	T max;
+};
+
+// Sorts `samples` and takes their percentiles; all zero if there are none.
+template <class T>
+Percentiles<T>
+percentiles(std::vector<T>& samples)
+{
+	Percentiles<T> result = {};
+	if (samples.empty())
+		return result;
+
+	std::sort(samples.begin(), samples.end());
+	result.median = samples[samples.size() / 2];
+	result.p99 = samples[samples.size() * 99 / 100];
+	result.max = samples.back();
+	return result;
+}
+
+// `value` with `precision` digits after the point, for a column of the table
+inline std::string
+decimals(double value, int precision)
+{
+	std::ostringstream out;
+	out << std::fixed << std::setprecision(precision) << value;
+	return out.str();
+}
+
+/*
+ * Columns left-aligned and padded to their widths; the last one, which needs no width, is
+ * as wide as its text. The header and the rows go through the same table, e.g.
+ *
+ *   static const BenchTable table({ 16, 10 });
+ *   table.row("Pipe", "Size", "Records/sec");
+ *   table.row("SpscTypedPipe", 16, decimals(rate, 0));
+ */
+class BenchTable
+{
+private:
+	std::vector<int> widths;
+
+public:
+	BenchTable(std::initializer_list<int> widths) : widths(widths) {}
+
+	// the row, for a bench that cannot print it to std::cout straight away
+	template <class... Columns>
+	std::string line(const Columns&... columns) const
+	{
+		std::ostringstream out;
+		out << std::left;
+		size_t column = 0;
+		((out << std::setw(column < widths.size() ? widths[column] : 0) << columns, column++), ...);
+		return out.str();
+	}
+
+	template <class... Columns>
+	void row(const Columns&... columns) const
+	{
+		std::cout << line(columns...) << std::endl;
+	}
+};
+
+#endif // __BENCH_UTIL_H__
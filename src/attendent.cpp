@@ -4,12 +4,13 @@ using namespace std;
 
 Attendent::Attendent()
 {
-	pumpMutex = sharedResources.getPumpDataPooMutexlVec();
-	pumpDpData = sharedResources.getPumpDpDataPtrVec();
+	pumpStatus = sharedResources.getPumpStatusVec();
+	pumpData.resize(pumpStatus.size());
 	txnApprovedEvent = sharedResources.getTxnApprovedEventVec();
 
-	tankMutex = sharedResources.getTankDpDataMutexVec();
 	tankDpData = sharedResources.getTankDpDataVec();
+	tankChanges = sharedResources.getTankChanges();
+	flowRateMl = sharedResources.getConfig().flowRateMl();
 
 	pipe = sharedResources.getAttendentPipe();
 }
@@ -17,17 +18,13 @@ Attendent::Attendent()
 bool
 Attendent::approveTxn(int idx)
 {
-	pumpMutex[idx]->WaitToRead();
-	pumpData[idx] = *pumpDpData[idx];
-	pumpMutex[idx]->DoneReading();
+	pumpStatus[idx]->read(pumpData[idx]);
+
+	uint32_t not_approved = 0;
+	if (pumpData[idx].txnStatus() == TxnStatus::Pending && pumpData[idx].hasCustomer() &&
+		// The pump publishes the approved status itself, so the flag stops a second approval in the meantime.
+		pumpStatus[idx]->approval.compare_exchange_strong(not_approved, 1)) {
 
-	if (pumpData[idx].txnStatus == TxnStatus::Pending && pumpData[idx].name != "___Unknown___") {
-		
-		pumpMutex[idx]->WaitToWrite();
-		pumpDpData[idx]->txnStatus = TxnStatus::Approved;
-		assert(pumpDpData[idx]->txnStatus == TxnStatus::Approved);
-		pumpMutex[idx]->DoneWriting();
-		
 		txnApprovedEvent[idx]->Signal(); // Trigger the event in `waitForAuth` in `pump.cpp`
 
 		return true;
@@ -40,27 +37,36 @@ Attendent::approveTxn(int idx)
 void
 Attendent::printTxns()
 { 
-	static const Cmd command = Cmd::PrintTxn;
+	AttendentCommand command;
+	memset(&command, 0, sizeof(command));
+	command.cmd = Cmd::PrintTxn;
+	pipe->Write(&command);
+}
+
+void
+Attendent::queryTxns(const TxnQuery& query)
+{
+	AttendentCommand command;
+	memset(&command, 0, sizeof(command));
+	command.cmd = Cmd::QueryTxn;
+	command.query = query;
 	pipe->Write(&command);
 }
 
 bool
 Attendent::addFuelToTank(int idx)
 {
-	bool keep_filling = false;
-	tankMutex[idx]->Wait();
-	if (tankDpData[idx]->remainingVolume + FLOW_RATE <= TANK_CAPACITY) {
-		keep_filling = true;
-		tankDpData[idx]->remainingVolume += FLOW_RATE;
-	}
-	tankMutex[idx]->Signal();
-	return keep_filling;
+	int32_t added = tankDpData[idx]->fill(flowRateMl);
+	if (added > 0)
+		tankChanges->publish(idx);
+	// a partial tick means the tank is now full
+	return added == flowRateMl;
 }
 
 void
 Attendent::refillTank(int idx)
 {
 	while (addFuelToTank(idx)) {
-		SLEEP(1000);
+		SimClock::get().sleep(FLOW_TICK_MS);
 	};
 }
\ No newline at end of file
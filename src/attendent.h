@@ -7,22 +7,23 @@
 class Attendent
 {
 private:
-	std::vector<std::shared_ptr<CReadersWritersMutex>> pumpMutex;
-	std::vector<std::shared_ptr<CustomerRecord>> pumpDpData;
+	std::vector<std::shared_ptr<PumpStatusSlot>> pumpStatus;
 
 	std::vector<std::shared_ptr<CEvent>> txnApprovedEvent;
 
-	std::shared_ptr<CTypedPipe<Cmd>> pipe;
+	std::shared_ptr<CTypedPipe<AttendentCommand>> pipe;
 
-	CustomerRecord pumpData[NUM_PUMPS];
+	std::vector<CustomerRecordWire> pumpData;
 
-	std::vector<std::shared_ptr<CMutex>> tankMutex;
 	std::vector<std::shared_ptr<TankData>> tankDpData;
+	std::shared_ptr<TankChanges> tankChanges;
+	int32_t flowRateMl;
 
 public:
 	Attendent();
 	bool approveTxn(int idx);
 	void printTxns();
+	void queryTxns(const TxnQuery& query);
 	
 	bool addFuelToTank(int idx);
 	void refillTank(int idx);
@@ -0,0 +1,54 @@
+#include "command_pool.h"
+
+using namespace std;
+
+CommandPool::CommandPool(unsigned num_workers) :
+	stopping(false)
+{
+	for (unsigned i = 0; i < num_workers; i++)
+		workers.emplace_back(&CommandPool::work, this);
+}
+
+CommandPool::~CommandPool()
+{
+	{
+		lock_guard<mutex> lock(queueMutex);
+		stopping = true;
+		queued.clear();
+	}
+	workAvailable.notify_all();
+
+	for (thread& worker : workers)
+		worker.join();
+}
+
+future<void>
+CommandPool::submit(function<void()> command)
+{
+	packaged_task<void()> task(move(command));
+	future<void> done = task.get_future();
+	{
+		lock_guard<mutex> lock(queueMutex);
+		queued.push_back(move(task));
+	}
+	workAvailable.notify_one();
+	return done;
+}
+
+void
+CommandPool::work()
+{
+	while (true) {
+		packaged_task<void()> task;
+		{
+			unique_lock<mutex> lock(queueMutex);
+			workAvailable.wait(lock, [this] { return stopping || !queued.empty(); });
+			if (stopping)
+				return;
+			task = move(queued.front());
+			queued.pop_front();
+		}
+		// an exception goes into the command's future rather than out of the worker
+		task();
+	}
+}
@@ -0,0 +1,47 @@
+#ifndef __COMMAND_POOL_H__
+#define __COMMAND_POOL_H__
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * A fixed set of worker threads running attendant commands in the order they are submitted.
+ *
+ * Unlike a TaskPool, whose coroutines must not block their worker, a command may keep its
+ * worker for as long as it takes (a refill runs until the tank is full), so the pool has to
+ * have enough workers for the long commands that can be running at once and still leave
+ * some for the quick ones. Each command's future becomes ready when it has run, and holds
+ * whatever it threw.
+ *
+ * Commands still queued when the pool is destroyed are dropped, and their futures report
+ * std::future_errc::broken_promise; running ones are finished first.
+ */
+class CommandPool
+{
+private:
+	std::mutex queueMutex;
+	std::condition_variable workAvailable;
+	std::deque<std::packaged_task<void()>> queued;
+	bool stopping;
+	std::vector<std::thread> workers;
+
+	void work();
+
+public:
+	explicit CommandPool(unsigned num_workers);
+	~CommandPool();
+
+	CommandPool(const CommandPool&) = delete;
+	CommandPool& operator=(const CommandPool&) = delete;
+
+	std::future<void> submit(std::function<void()> command);
+
+	size_t size() const { return workers.size(); }
+};
+
+#endif // __COMMAND_POOL_H__
@@ -1,14 +1,19 @@
 #include <iostream>
 #include <thread>
 #include <sstream>
+#include <cstdlib>
+#include <cstring>
 #include "command_processor.h"
 
 using namespace std;
 
 #define DISPLAY_OUTPUT 0
 
-CommandProcessor::CommandProcessor(FuelPrice& fuelPrice, vector<unique_ptr<Pump>>& pumps)
-    : fuelPrice_(fuelPrice), pumps_(pumps)
+CommandProcessor::CommandProcessor(FuelPrice& fuelPrice, vector<unique_ptr<Pump>>& pumps, PumpDispatcher& dispatcher)
+    : fuelPrice_(fuelPrice), pumps_(pumps), dispatcher_(dispatcher),
+      customers(pumps, fuelPrice, dispatcher, customerTasks),
+      refills(sharedResources.getConfig().numTanks),
+      workers(sharedResources.getConfig().numTanks + COMMAND_WORKERS_BESIDES_REFILLS)
 {
     /**
      * This line adds an entry to the map. The key is the string `"OP"`, and
@@ -17,7 +22,7 @@ CommandProcessor::CommandProcessor(FuelPrice& fuelPrice, vector<unique_ptr<Pump>
      * The [this] in the lambda function's declaration is a capture clause that
      * allows the lambda function to access the current object's member functions
      * and variables. The lambda function can then be used just like any other
-     * function and passed as an argument to std::thread to run in a new thread.
+     * function and handed to the command workers to run.
      */
     command_map_int["OP"] = [this](int n) { this->openPump(n); };
 
@@ -36,10 +41,6 @@ CommandProcessor::CommandProcessor(FuelPrice& fuelPrice, vector<unique_ptr<Pump>
     commands_with_int_float.insert("CP");
 
     attendent = make_unique<Attendent>();
-
-    for (int i = 0; i < MAX_NUM_CUSTOMERS; i++) {
-        customers.emplace_back(make_unique<Customer>(pumps_, fuelPrice_));
-    }
 }
 
 void
@@ -55,45 +56,21 @@ CommandProcessor::openPump(int n)
         attendent->approveTxn(n); // execute a command
     } // Lock released here
 
-
-    std::lock_guard<std::mutex> lock(commandMutex);
-    commandCompleted = true;
-
-    /**
-     * This line notifies one thread that is waiting on the condition variable cv.
-     * This is part of the coordination between the main thread and the worker threads.
-     * When a worker thread finishes executing a command, it sets `commandCompleted` to
-     * true and calls cv.notify_one() to wake up the main thread, which is waiting for
-     * `commandCompleted` to become true.
-     */
-    cv.notify_one();
 }
 
 void
 CommandProcessor::generateCustomers(int n)
 {
-    static int i = 0;
-    static int max_count = 0;
     {
 #if DISPLAY_OUTPUT
         std::lock_guard<std::mutex> lock(outputMutex);
         std::cout << "Generating " << n << " customers ..." << std::endl;
 #endif
-        max_count += n;
-        for (; i < max_count; i++) {
-            if (i > MAX_NUM_CUSTOMERS)
-                cerr << "Error: Exceeded maximum number of customers" << endl;
-            else
-                customers[i]->Resume();
-        }
+        customers.generate(n);
     }
-
-    std::lock_guard<std::mutex> lock(commandMutex);
-    commandCompleted = true;
-    cv.notify_one();
 }
 
-vector<unique_ptr<Customer>>&
+CustomerPool&
 CommandProcessor::getCustomers()
 {
     return customers;
@@ -109,10 +86,18 @@ CommandProcessor::printTxn()
 #endif
         attendent->printTxns();
     }
+}
 
-    std::lock_guard<std::mutex> lock(commandMutex);
-    commandCompleted = true;
-    cv.notify_one();
+void
+CommandProcessor::queryTxn(TxnQuery query)
+{
+    {
+#if DISPLAY_OUTPUT
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::cout << "Looking up transactions: " << txnQueryToString(query) << " ..." << std::endl;
+#endif
+        attendent->queryTxns(query);
+    }
 }
 
 void
@@ -125,10 +110,6 @@ CommandProcessor::refillTank(int n)
 #endif
         attendent->refillTank(n);
     }
-
-    std::lock_guard<std::mutex> lock(commandMutex);
-    commandCompleted = true;
-    cv.notify_one();
 }
 
 void
@@ -141,236 +122,348 @@ CommandProcessor::changeUnitPrice(int grade, float price)
 #endif
         fuelPrice_.setFuelPrice(intToFuelGrade(grade), price);
     }
+}
 
-    std::lock_guard<std::mutex> lock(commandMutex);
-    commandCompleted = true;
-    cv.notify_one();
+std::shared_future<void>
+CommandProcessor::submit(const char* input, std::function<void()> command)
+{
+    std::shared_future<void> done = workers.submit(std::move(command)).share();
+    inFlight.emplace_back(input, done);
+    return done;
 }
 
+/*
+ * Forgets the commands that have finished, and says which of them failed.
+ */
 void
-CommandProcessor::run()
+CommandProcessor::reapFinished()
 {
-    while (true) {
-        std::string input, command;
-        int number = 0;
-
-        int grade = -1;
-        float price = 0.0f;
-        /**
-         * `lock` is an instance (a variable) of `std::unique_lock<std::mutex>`.
-         * This lock automatically locks the mutex `commandMutex` when it is created
-         * and unlocks it when it is destroyed. This is an example of RAII
-         * (Resource Acquisition Is Initialization), a common idiom in C++ where resource
-         * management (like locking and unlocking a mutex) is tied to the lifetime of an object..
-         * Here, the `lock` is protecting the `commandCompleted` variable. Only one thread can
-         * lock the mutex at a time.
-         */
-        std::unique_lock<std::mutex> lock(commandMutex); // Wait for the previous command to complete
-
-        /**
-         * Make the main thread wait until commandCompleted becomes true.
-         * The `&` in the lambda function's declaration is a capture clause
-         * that allows the lambda function to access all in-scope variables
-         * by reference. In this case, it allows the lambda function to access
-         * `commandCompleted`.
-         * The cv.wait() function takes a unique lock and a predicate as
-         * arguments, and it blocks the current thread until the condition
-         * variable cv is notified.
-         * Here, `lock` is the mutex that's being locked and unlocked around
-         * the condition variable cv.
-         * The `wait` function takes two arguments:
-         *  1. The unique lock (`lock`) which must be locked by the current thread.
-         *     This is required to ensure safe access to shared data.
-         *  2. A lambda function `([&] { return commandCompleted; })` that represents
-         *     the condition to be satisfied via the `cv` variable. This condition is
-         *     checked each time the wait function is signaled. The thread will only
-         *     proceed if the condition is satisfied; otherwise, it will go back to waiting.
-         */
-        cv.wait(lock, [&] { return commandCompleted; });
-
-        commandCompleted = false; // Set to false before starting next command
-
-        lock.unlock(); // This allows other threads to lock the mutex.
+    auto finished = [](const std::pair<std::string, std::shared_future<void>>& command) {
+        return command.second.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    };
+
+    for (auto& command : inFlight) {
+        if (!finished(command))
+            continue;
+        try {
+            command.second.get();
+        }
+        catch (const std::exception& e) {
 #if DISPLAY_OUTPUT
-        {
             std::lock_guard<std::mutex> lock(outputMutex);
-            std::cout << "[Command]: ";
-        }
+            std::cout << "\"" << command.first << "\" failed: " << e.what() << std::endl;
+#else
+            (void)e;
 #endif
+        }
+    }
+    inFlight.erase(std::remove_if(inFlight.begin(), inFlight.end(), finished), inFlight.end());
+}
 
-        char c;
-        while (true) {
-#ifdef _WIN32
-            c = _getch();
-#else
-            struct termios old_t, new_t;
-            tcgetattr(STDIN_FILENO, &old_t); // get current terminal info
-            new_t = old_t;
-            new_t.c_lflag &= ~ECHO; // disable echo
-            tcsetattr(STDIN_FILENO, TCSANOW, &new_t); // apply new terminal settings
-            c = getchar();
-            tcsetattr(STDIN_FILENO, TCSANOW, &old_t); // restore old terminal settings
+// Waits for every command handed to the workers so far.
+void
+CommandProcessor::waitForAll()
+{
+    for (auto& command : inFlight)
+        command.second.wait();
+    reapFinished();
+}
+
+/*
+ * The line is split where it lies: the command is the first two characters after any spaces,
+ * and the numbers are read straight off the rest, so a command costs no copies of its line.
+ */
+static bool
+parseInt(const char*& p, int& value)
+{
+    char* end;
+    long parsed = strtol(p, &end, 10);
+    if (end == p)
+        return false;
+    value = static_cast<int>(parsed);
+    p = end;
+    return true;
+}
+
+static bool
+parseFloat(const char*& p, float& value)
+{
+    char* end;
+    float parsed = strtof(p, &end);
+    if (end == p)
+        return false;
+    value = parsed;
+    p = end;
+    return true;
+}
+
+static const char*
+skipSpaces(const char* p)
+{
+    while (*p == ' ' || *p == '\t')
+        p++;
+    return p;
+}
+
+/*
+ * Waits for the simulated time `due`. In fast mode the clock only moves as the pumps and tanks
+ * sleep, so the script waits for them to get there, and moves the clock on itself only once
+ * nothing has moved it for FAST_IDLE_POLLS polls, i.e. when the station is idle.
+ */
+static void
+waitUntil(std::chrono::system_clock::time_point due)
+{
+    const int FAST_IDLE_POLLS = 20;
+    SimClock& clock = SimClock::get();
+    // the clock is read once, and a time already gone by is no wait at all rather than a huge one
+    auto sleepOutTheRest = [&clock, due]() {
+        const int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(due - clock.now()).count();
+        if (ms > 0)
+            clock.sleep(static_cast<UINT>(ms));
+    };
+
+    if (clock.getMode() != ClockMode::AsFastAsPossible) {
+        sleepOutTheRest();
+        return;
+    }
+
+    auto last = clock.now();
+    int idle_polls = 0;
+    while (last < due) {
+        SLEEP(1);
+        const auto now = clock.now();
+        if (now != last) {
+            last = now;
+            idle_polls = 0;
+        }
+        else if (++idle_polls == FAST_IDLE_POLLS) {
+            sleepOutTheRest();
+            return;
+        }
+    }
+}
+
+CommandResult
+CommandProcessor::execute(const char* line)
+{
+    int number = 0;
+
+    int grade = -1;
+    float price = 0.0f;
+
+    // `pt` followed by filters, e.g. `pt card=1234 since=10:00`
+    TxnQuery query;
+    bool has_query = false;
+
+    const char* p = skipSpaces(line);
+
+    // Check if the input string is too short
+    if (p[0] == '\0' || p[1] == '\0') {
+#if DISPLAY_OUTPUT
+        std::cout << "Invalid command size.\n";
 #endif
+        return CommandResult::Rejected;
+    }
 
-            if (c == '\n' || c == '\r') {
-                std::cout << std::endl;
-                break;
-            }
-            input.push_back(c);
+    // Commands are case-insensitive. Two characters fit in the string itself, so nothing is allocated.
+    const char name[2] = { static_cast<char>(::toupper(static_cast<unsigned char>(p[0]))),
+                           static_cast<char>(::toupper(static_cast<unsigned char>(p[1]))) };
+    const std::string command(name, 2);
+    const char* args = p + 2;
+
+    // Check if the command exists in our command map
+    if (commands_with_int.find(command) != commands_with_int.end()) {
+        if (*args == '\0') {
+#if DISPLAY_OUTPUT
+            std::cout << "This command requires a number.\n";
+#endif
+            return CommandResult::Rejected;
         }
 
-        // Check if the input string is too short
-        if (input.size() < 2) {
+        if (!parseInt(args, number)) {
 #if DISPLAY_OUTPUT
-            std::cout << "Invalid command size.\n";
+            std::cout << "Command should be followed by an integer number.\n";
 #endif
-            commandCompleted = true;
-            continue;
+            return CommandResult::Rejected;
         }
 
-        /**
-         * Split command and number from the input
-         * Extract the first two (non-empty) characters from the `input` string as the command.
-         * The `substr` function takes two arguments: the starting index and the
-         * length of the substring. In this case, it starts from index 0 and takes 2 characters.
-         */
-        command = input.substr(0, 2);
-        
-        /**
-         * Achieve case-insensitive command comparison by converting the command entered by the
-         * user to uppercase before processing it.
-         * This function applies `::toupper` to each character in the `command` string from
-         * beginning to end, storing the result in command from the beginning, effectively
-         * converting the entire string to uppercase.
-         */
-        std::transform(
-            command.begin(),    // iterator that denotes the beginning of the string
-            command.end(),      // iterator that denotes the end of the string
-            // Overwrite the original characters in the string with their uppercase counterparts,
-            // starting at the beginning of the `command` string
-            command.begin(),    // iterator that tells this funciton where to store the result.
-            /**
-             * `::toupper` is a function that converts a given character to uppercase if it is a
-             * lowercase letter; or, it returns the original character.
-             * The double colon (`::`) is the scope resolution operator. It is used here because
-             * `toupper` is in the global scope (not in a namespace or class).
-             */
-            ::toupper);
-
-        // Check if the command exists in our command map
-        if (commands_with_int.find(command) != commands_with_int.end()) {
-            if (input.size() < 3) {
+        // `rf` takes a tank number, `op` a pump number
+        const int count = (command == "RF") ? sharedResources.getConfig().numTanks : sharedResources.getConfig().numPumps;
+        if (command != "GC" && (number < 0 || number > count - 1)) {
 #if DISPLAY_OUTPUT
-                std::cout << "This command requires a number.\n";
+            std::cout << "Number must be the range of 0 to " << count - 1 << ".\n";
 #endif
-                commandCompleted = true;
-                continue;
-            }
+            return CommandResult::Rejected;
+        }
 
-            /**
-             * Create a stringstream `ss` from the rest of the `input` string (starting from index 2,
-             * which is the character after the command). The stringstream can then be used to extract
-             * the number following the command.
-             */
-            std::stringstream ss(input.substr(2));
-
-            /**
-             * In `ss >> number`, the extraction operator (`>>`) is used to extract an integer from the
-             * stringstream `ss` and store it in the variable `number`. This is similar to how you might
-             * use `std::cin >> number` to read an integer from the console.
-             * 
-             * When you use the extraction operator with a stringstream, the operator tries to interpret
-             * the sequence of characters stored in the stringstream `ss` as an integer and store it in
-             * the integer variable `number`.
-             * If it is able to do this, it returns a reference to the stringstream. This is considered
-             * a true value, meaning that if you use it in a condition like if (ss >> number), the
-             * condition will be true if the extraction was successful.
-             */
-            if (!(ss >> number)) {
+        if (command == "GC" && number < 1) {
 #if DISPLAY_OUTPUT
-                std::cout << "Command should be followed by an integer number.\n";
+            std::cout << "At least one customer must be generated each time.\n";
 #endif
-                commandCompleted = true;
-                continue;
-            }
+            return CommandResult::Rejected;
+        }
+    }
+    else if (commands_with_int_float.find(command) != commands_with_int_float.end()) {
+        if (strchr(line, ' ') == NULL) {
+#if DISPLAY_OUTPUT
+            std::cout << "Please enter a command followed by an integer and a float number separated by a space.\n";
+#endif
+            return CommandResult::Rejected;
+        }
 
-            if (command != "GC" && (number < 0 || number > NUM_PUMPS - 1)) {
+        if (!parseInt(args, grade) || !parseFloat(args, price)) {
 #if DISPLAY_OUTPUT
-                std::cout << "Number must be the range of 0 to " << NUM_PUMPS - 1 << ".\n";
+            std::cout << "The command must be followed by an integer and a float number.\n";
+            std::cout << "Grade = " << grade << "       Price = " << price << std::endl;
 #endif
-                commandCompleted = true;
-                continue;
-            }
+            return CommandResult::Rejected;
+        }
 
-            if (command == "GC" && number < 1) {
+        if (grade < 0 || grade > sharedResources.getConfig().numTanks - 1) {
 #if DISPLAY_OUTPUT
-                std::cout << "At least one customer must be generated each time.\n";
+            std::cout << "Fuel grade must be an integer in the range of 0 to " << sharedResources.getConfig().numTanks - 1 << std::endl;
 #endif
-                commandCompleted = true;
-                continue;
-            }
+            return CommandResult::Rejected;
         }
-        else if (commands_with_int_float.find(command) != commands_with_int_float.end()) {
-            std::size_t found = input.find(' ');
-            if (found == std::string::npos) {
+    }
+
+    else if (command == "PT" && *skipSpaces(args) != '\0') {
+        if (!parseTxnQuery(args, query)) {
 #if DISPLAY_OUTPUT
-                std::cout << "Please enter a command followed by an integer and a float number separated by a space.\n";
+            std::cout << "Filters are card=<last 4 or all 12 digits, grouped or not>, pump=#, grade=#, since=HH:MM and until=HH:MM.\n";
 #endif
-                commandCompleted = true;
-                continue;
-            }
+            return CommandResult::Rejected;
+        }
+        has_query = true;
+    }
 
-            std::stringstream ss(input.substr(2));
-            /**
-             * `>> grade >> price`: This attempts to extract values from the stringstream into the variables `grade` and `price`.
-             * The >> operator first tries to convert the next sequence of characters that could represent an int into an int
-             * value and store it into `grade`. Then it does the same for a float value and stores it into `price`.
-             * `if (!(ss >> grade >> price))`: This is checking whether the extraction operation was successful for both `grade`
-             * and `price`. If the operation fails (for example, because the next sequence of characters can't be converted into
-             * an int or a float, or because there aren't enough values left), then ss will be in a "fail" state, and when it's
-             * used in a boolean context (like in an if statement), it will evaluate to false.
-             */
-            if (!(ss >> grade >> price)) {
+    // Check if exit command was given
+    if (command == "EX") {
+        return CommandResult::Exit;
+    }
+
+    if (has_query) {
+        submit(line, [this, query]() { this->queryTxn(query); });
+    }
+    else if (command == "RF" && refills[number].valid() &&
+             refills[number].wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        // That tank is already being refilled; a second refill would only hold another worker.
+    }
+    else if (command_map_int.find(command) != command_map_int.end()) {
+        std::shared_future<void> done = submit(line, std::bind(command_map_int[command], number));
+        if (command == "RF")
+            refills[number] = done;
+    }
+    else if (command_map_void.find(command) != command_map_void.end()) {
+        submit(line, command_map_void[command]);
+    }
+    else if (command_map_int_float.find(command) != command_map_int_float.end()) {
+        submit(line, std::bind(command_map_int_float[command], grade, price));
+    }
+
+    else {
 #if DISPLAY_OUTPUT
-                std::cout << "The command must be followed by an integer and a float number.\n";
-                std::cout << "Grade = " << grade << "       Price = " << price << std::endl;
+        std::cout << "Invalid command entered\n";
 #endif
-                commandCompleted = true;
-                continue;
-            }
+        return CommandResult::Rejected;
+    }
+    return CommandResult::Accepted;
+}
+
+void
+CommandProcessor::run()
+{
+    std::string input;
+
+    while (true) {
+        input.clear();
+
+        // Whatever has finished since the previous command is collected; nothing waits for the rest.
+        reapFinished();
 
-            if (grade < 0 || grade > NUM_TANKS - 1) {
 #if DISPLAY_OUTPUT
-                std::cout << "Fuel grade must be an integer in the range of 0 to " << NUM_TANKS - 1 << std::endl;
+        {
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::cout << "[Command]: ";
+        }
 #endif
-                commandCompleted = true;
-                continue;
+
+        char c;
+        while (true) {
+#ifdef _WIN32
+            c = _getch();
+#else
+            struct termios old_t, new_t;
+            tcgetattr(STDIN_FILENO, &old_t); // get current terminal info
+            new_t = old_t;
+            new_t.c_lflag &= ~ECHO; // disable echo
+            tcsetattr(STDIN_FILENO, TCSANOW, &new_t); // apply new terminal settings
+            c = getchar();
+            tcsetattr(STDIN_FILENO, TCSANOW, &old_t); // restore old terminal settings
+#endif
+
+            if (c == '\n' || c == '\r') {
+                std::cout << std::endl;
+                break;
             }
+            input.push_back(c);
         }
 
-        // Check if exit command was given
-        if (command == "EX") {
+        if (execute(input.c_str()) == CommandResult::Exit)
             break;
-        }
+    }
+}
 
-        if (command_map_int.find(command) != command_map_int.end()) {
-            std::thread t(command_map_int[command], number);
-            t.detach();
-        }
-        else if (command_map_void.find(command) != command_map_void.end()) {
-            std::thread t(command_map_void[command]);
-            t.detach();
-        }
-        else if (command_map_int_float.find(command) != command_map_int_float.end()) {
-            std::thread t(command_map_int_float[command], grade, price);
-            t.detach();
+BatchReport
+CommandProcessor::runBatch(std::FILE* source)
+{
+    BatchReport report;
+    char line[MAX_COMMAND_LINE];
+    int line_number = 0;
+    const auto start = SimClock::get().now();
+
+    while (std::fgets(line, sizeof(line), source) != NULL) {
+        line_number++;
+        reapFinished();
+
+        size_t length = strlen(line);
+        if (length == sizeof(line) - 1 && line[length - 1] != '\n' && !std::feof(source)) {
+            // too long to be a command; the rest of it is dropped along with it
+            int c;
+            while ((c = std::fgetc(source)) != '\n' && c != EOF)
+                ;
+            report.rejectedLines.push_back(line_number);
+            continue;
         }
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+            line[--length] = '\0';
 
-        else {
-#if DISPLAY_OUTPUT
-            std::cout << "Invalid command entered\n";
-#endif
-            commandCompleted = true;
+        const char* p = skipSpaces(line);
+        if (*p == '\0' || *p == '#')
+            continue;
+
+        if (*p == '@') {
+            p++;
+            float at;
+            if (!parseFloat(p, at) || at < 0) {
+                report.rejectedLines.push_back(line_number);
+                continue;
+            }
+            waitUntil(start + std::chrono::milliseconds(static_cast<int64_t>(at * 1000)));
+            // a time on its own only waits, e.g. to let the last customers finish
+            if (*skipSpaces(p) == '\0')
+                continue;
         }
+
+        CommandResult result = execute(p);
+        if (result == CommandResult::Exit)
+            break;
+        if (result == CommandResult::Rejected)
+            report.rejectedLines.push_back(line_number);
+        else
+            report.commands++;
     }
+
+    waitForAll();
+    return report;
 }
@@ -1,17 +1,24 @@
 #ifndef __COMMAND_PROCESSOR_H__
 #define __COMMAND_PROCESSOR_H__
 
+#include <cstdio>
 #include <string>
 #include <memory>
 #include <map>
 #include <functional>
+#include <future>
 #include <mutex>
-#include <condition_variable>
+#include <deque>
+#include <vector>
 #include <set>
 #include "pump.h"
 #include "customer.h"
+#include "customer_pool.h"
 #include "attendent.h"
 #include "fuel_price.h"
+#include "pump_dispatcher.h"
+#include "task.h"
+#include "command_pool.h"
 
 #ifdef _WIN32
 #include <conio.h>
@@ -20,6 +27,27 @@
 #include <unistd.h>
 #endif
 
+// workers for anything but refills, when every tank is being refilled
+const unsigned COMMAND_WORKERS_BESIDES_REFILLS = 2;
+
+// longest line a command script may have, the newline included
+const size_t MAX_COMMAND_LINE = 256;
+
+// what became of one command line
+enum class CommandResult
+{
+    Accepted,
+    Rejected,
+    Exit
+};
+
+// how a command script went
+struct BatchReport
+{
+    int commands = 0;
+    std::vector<int> rejectedLines;
+};
+
 class CommandProcessor {
 private:
     // Map from commands to functions
@@ -29,29 +57,56 @@ private:
     std::set<std::string> commands_with_int;
     std::set<std::string> commands_with_int_float;
 
-    // Condition variable and mutexes for synchronization
-    std::condition_variable cv;
-
-    // `commandMutex` is used to ensure that only one command is processed at a time.
-    std::mutex commandMutex, outputMutex;
-    bool commandCompleted = true; // No command running at start
+    std::mutex outputMutex;
 
     std::unique_ptr<Attendent> attendent;
 
     FuelPrice& fuelPrice_;
     std::vector<std::unique_ptr<Pump>>& pumps_;
+    PumpDispatcher& dispatcher_;
 
-    std::vector<std::unique_ptr<Customer>> customers;
+    CustomerPool customers;
+
+    // Runs the customers' visits; declared after `customers` so its workers stop before the customers go.
+    TaskPool customerTasks;
+
+    // commands handed to `workers` that have not been seen to finish yet, with what was typed for them
+    std::deque<std::pair<std::string, std::shared_future<void>>> inFlight;
+
+    // the latest refill of each tank, so a second `rf` for a tank already refilling is not queued
+    std::vector<std::shared_future<void>> refills;
+
+    /*
+     * Runs the commands, so the next command can be typed while the previous one is still
+     * running. Declared last so its workers have stopped before anything they use goes.
+     */
+    CommandPool workers;
+
+    std::shared_future<void> submit(const char* input, std::function<void()> command);
+    void reapFinished();
+    void waitForAll();
+
+    // Checks one command line and hands it to `workers`; `line` ends at its NUL.
+    CommandResult execute(const char* line);
 
 public:
-    CommandProcessor(FuelPrice& fuelPrice, std::vector<std::unique_ptr<Pump>>& pumps);
+    CommandProcessor(FuelPrice& fuelPrice, std::vector<std::unique_ptr<Pump>>& pumps, PumpDispatcher& dispatcher);
     void openPump(int n);
     void changeUnitPrice(int grade, float price);
     void printTxn();
+    void queryTxn(TxnQuery query);
     void refillTank(int n);
     void generateCustomers(int n);
-    std::vector<std::unique_ptr<Customer>>& getCustomers();
+    CustomerPool& getCustomers();
     void run();
+
+    /*
+     * Runs the commands in `source` one line at a time, as if they had been typed: blank lines
+     * and lines starting with `#` are skipped, and a line starting with `@<seconds>` is not run
+     * before that much simulated time has passed since the script started. Returns at the end
+     * of `source` or at `ex`, once every command has finished.
+     */
+    BatchReport runBatch(std::FILE* source);
 };
 
 
@@ -2,13 +2,79 @@
 
 using namespace std;
 
+/*
+ * Holds nothing until main() has read the station configuration and called open(), so no
+ * global initialiser may copy handles out of it.
+ */
 SharedResources sharedResources;
 
+bool
+SharedResources::open(const StationConfig& requested)
+{
+    layoutDp = std::make_shared<CDataPool>("StationLayout", sizeof(StationLayout));
+    StationLayout* layout = static_cast<StationLayout*>(layoutDp->LinkDataPool());
+
+    uint32_t state = 0;
+    if (layout->state.compare_exchange_strong(state, LAYOUT_WRITING)) {
+        layout->config = requested;
+        layout->state.store(LAYOUT_PUBLISHED, std::memory_order_release);
+    }
+    else {
+        // the other process is writing its layout right now; it takes no time
+        while (layout->state.load(std::memory_order_acquire) != LAYOUT_PUBLISHED)
+            std::this_thread::yield();
+    }
+    config = layout->config;
+
+    for (int i = 0; i < config.numPumps; ++i) {
+        pumpThreadIds.push_back(i);
+    }
+
+    rndv = std::make_shared<CRendezvous>("PumpRendezvous",
+                                    config.numPumps +
+                                    // tank monitor thread of Computer
+                                    1 +
+                                    // main function thread of pump facility
+                                    1);
+    attendentPipe = std::make_shared<CTypedPipe<AttendentCommand>>("AttendentPipe", 1);
+
+    for (int i = 0; i < config.numTanks; i++) {
+        tankDps.emplace_back(std::make_shared<CDataPool>(getName("FuelTankDataPool", i, ""), sizeof(TankData)));
+        // the data pointer shares ownership with its data pool, so it is never deleted on its own
+        tankDpDataPtrs.emplace_back(tankDps[i], static_cast<TankData*>(tankDps[i]->LinkDataPool()));
+    }
+    tankChangesDp = std::make_shared<CDataPool>("TankChanges", sizeof(TankChanges));
+    tankChanges = std::shared_ptr<TankChanges>(tankChangesDp, static_cast<TankChanges*>(tankChangesDp->LinkDataPool()));
+
+    fuelPricesDp = std::make_shared<CDataPool>("FuelPrices", sizeof(SeqLock<FuelPriceTable>));
+    fuelPrices = std::shared_ptr<SeqLock<FuelPriceTable>>(fuelPricesDp, static_cast<SeqLock<FuelPriceTable>*>(fuelPricesDp->LinkDataPool()));
+
+    for (int i = 0; i < config.numPumps; i++) {
+        pumpDps.emplace_back(std::make_shared<CDataPool>(getName("PumpDataPool", i, ""), sizeof(PumpStatusSlot)));
+        pumpStatusSlots.emplace_back(pumpDps[i], static_cast<PumpStatusSlot*>(pumpDps[i]->LinkDataPool()));
+
+        doneLanes.emplace_back(std::make_shared<DoneLane>(getName("DoneLane", i, ""), DONE_LANE_SIZE));
+
+        pumpPipes.emplace_back(std::make_shared<PumpPipe>(getName("Pipe", i, ""), 1));
+
+        txnApprovedEvents.emplace_back(std::make_shared<CEvent>(getName("TxnApprovedByPump", i, "")));
+    }
+
+    return memcmp(&config, &requested, sizeof(StationConfig)) == 0;
+}
+
+bool
+SharedResources::shareClock()
+{
+    clockDp = std::make_shared<CDataPool>("SimClock", sizeof(SharedClockState));
+    return SimClock::get().share(static_cast<SharedClockState*>(clockDp->LinkDataPool()));
+}
+
 std::tm
 getTimestamp()
 {
-    // Get current time
-    auto now = std::chrono::system_clock::now();
+    // Get the current simulated time, which is the system time unless the clock is sped up
+    auto now = SimClock::get().now();
 
     /**
      * Convert the `time_point` object to a `time_t` object.
@@ -40,12 +106,13 @@ getTimestamp()
     return now_tm;
 }
 
-void
-printTimestamp(std::tm now_tm)
+std::string
+timestampToString(std::tm now_tm)
 {
-    // Print the timestamp in the `YYYY-MM-DD HH:MM:SS` format.
+    // Format the timestamp as `YYYY-MM-DD HH:MM:SS`.
     // now_tm.tm_year stores years since 1900, hence +1900 is used to get the current year.
-    std::cout << (now_tm.tm_year + 1900) << '-'
+    std::ostringstream out;
+    out << (now_tm.tm_year + 1900) << '-'
         // now_tm.tm_mon stores the months since January, ranging from 0 to 11. Therefore,
         // +1 is used to get the current month in the range 1 to 12.
         // std::setw(2) sets the field width to 2 characters for the next formatted output.
@@ -55,7 +122,181 @@ printTimestamp(std::tm now_tm)
         << std::setw(2) << std::setfill('0') << now_tm.tm_mday << ' '
         << std::setw(2) << std::setfill('0') << now_tm.tm_hour << ':'
         << std::setw(2) << std::setfill('0') << now_tm.tm_min << ':'
-        << std::setw(2) << std::setfill('0') << now_tm.tm_sec << std::endl;
+        << std::setw(2) << std::setfill('0') << now_tm.tm_sec;
+    return out.str();
+}
+
+int64_t
+timestampToEpoch(std::tm now_tm)
+{
+    // A record that has never been timestamped keeps tm_year at 0 (year 1900).
+    if (now_tm.tm_year == 0)
+        return 0;
+    now_tm.tm_isdst = -1;
+    return static_cast<int64_t>(std::mktime(&now_tm));
+}
+
+std::tm
+epochToTimestamp(int64_t epoch)
+{
+    std::tm now_tm = {};
+    if (epoch == 0)
+        return now_tm;
+
+    std::time_t now_c = static_cast<std::time_t>(epoch);
+    localtime_s(&now_tm, &now_c);
+    return now_tm;
+}
+
+/*
+ * Copies `source` into a fixed size wire buffer, truncating it if needed and
+ * zero filling the rest so that stale bytes never leak through the pipe.
+ */
+static void
+copyToWireString(char* destination, size_t size, const std::string& source)
+{
+    size_t length = source.length() < size - 1 ? source.length() : size - 1;
+    memcpy(destination, source.data(), length);
+    memset(destination + length, 0, size - length);
+}
+
+void
+toWire(const CustomerRecord& record, CustomerRecordWire& wire)
+{
+    copyToWireString(wire.name, sizeof(wire.name), record.name);
+    copyToWireString(wire.creditCardNumber, sizeof(wire.creditCardNumber), record.creditCardNumber);
+    wire.requestedVolume = record.requestedVolume;
+    wire.receivedVolume = record.receivedVolume;
+    wire.unitCost = record.unitCost;
+    wire.priceVersion = static_cast<uint16_t>(record.priceVersion);
+    wire.cost = record.cost;
+    wire.nowTime = timestampToEpoch(record.nowTime);
+    wire.pumpId = record.pumpId;
+    wire.gradeAndStatus = 0;
+    wire.setGrade(record.grade);
+    wire.setTxnStatus(record.txnStatus);
+}
+
+void
+fromWire(const CustomerRecordWire& wire, CustomerRecord& record)
+{
+    // assign() reuses the capacity the strings already have.
+    record.name.assign(wire.name, strnlen(wire.name, sizeof(wire.name)));
+    record.creditCardNumber.assign(wire.creditCardNumber, strnlen(wire.creditCardNumber, sizeof(wire.creditCardNumber)));
+    record.grade = wire.grade();
+    record.requestedVolume = wire.requestedVolume;
+    record.receivedVolume = wire.receivedVolume;
+    record.unitCost = wire.unitCost;
+    record.priceVersion = wire.priceVersion;
+    record.cost = wire.cost;
+    record.pumpId = wire.pumpId;
+    record.txnStatus = wire.txnStatus();
+    record.nowTime = epochToTimestamp(wire.nowTime);
+}
+
+// "HH:MM" or "HH:MM:SS" to seconds after midnight, -1 if it is neither
+static int32_t
+parseTimeOfDay(const std::string& text)
+{
+    int hours = 0, minutes = 0, seconds = 0;
+    char extra = 0;
+    int fields = sscanf(text.c_str(), "%d:%d:%d%c", &hours, &minutes, &seconds, &extra);
+    if (fields < 2 || fields > 3 || hours < 0 || hours > 23 || minutes < 0 || minutes > 59 || seconds < 0 || seconds > 59)
+        return -1;
+    return hours * 3600 + minutes * 60 + seconds;
+}
+
+static std::string
+timeOfDayToString(int32_t seconds)
+{
+    char text[16];
+    snprintf(text, sizeof(text), "%02d:%02d:%02d", seconds / 3600, seconds / 60 % 60, seconds % 60);
+    return text;
+}
+
+bool
+parseTxnQuery(const std::string& text, TxnQuery& query)
+{
+    memset(&query, 0, sizeof(query));
+    query.pumpId = -1;
+    query.grade = -1;
+    query.since = -1;
+    query.until = -1;
+
+    std::stringstream args(text);
+    std::string arg;
+    while (args >> arg) {
+        size_t equals = arg.find('=');
+        if (equals == std::string::npos)
+            return false;
+        std::string key = arg.substr(0, equals);
+        std::string value = arg.substr(equals + 1);
+        std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+
+        char* end = nullptr;
+        if (key == "card") {
+            // Card numbers are shown in groups of four, e.g. `card=1234 5678 9012`; the spaces are optional.
+            auto isDigits = [](const std::string& s) {
+                return !s.empty() && std::all_of(s.begin(), s.end(), [](char c) { return c >= '0' && c <= '9'; });
+            };
+            if (!isDigits(value))
+                return false;
+            std::string digits = value;
+            while (digits.size() < 12) {
+                std::streampos before = args.tellg();
+                std::string group;
+                if (!(args >> group) || !isDigits(group)) {
+                    // not part of the card number; leave it for the next filter
+                    args.clear();
+                    args.seekg(before);
+                    break;
+                }
+                digits += group;
+            }
+            if (digits.size() != 4 && digits.size() != 12)
+                return false;
+            memcpy(query.card, digits.c_str(), digits.size() + 1);
+        }
+        else if (key == "pump") {
+            query.pumpId = static_cast<int32_t>(strtol(value.c_str(), &end, 10));
+            if (value.empty() || *end != '\0' || query.pumpId < 0 || query.pumpId > MAX_PUMPS - 1)
+                return false;
+        }
+        else if (key == "grade") {
+            query.grade = static_cast<int32_t>(strtol(value.c_str(), &end, 10));
+            if (value.empty() || *end != '\0' || query.grade < 0 || query.grade > MAX_TANKS - 1)
+                return false;
+        }
+        else if (key == "since") {
+            if ((query.since = parseTimeOfDay(value)) < 0)
+                return false;
+        }
+        else if (key == "until") {
+            if ((query.until = parseTimeOfDay(value)) < 0)
+                return false;
+        }
+        else {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string
+txnQueryToString(const TxnQuery& query)
+{
+    std::string text;
+    if (query.card[0] != '\0')
+        text += std::string(" card=") + query.card;
+    if (query.pumpId >= 0)
+        text += " pump=" + std::to_string(query.pumpId);
+    if (query.grade >= 0)
+        text += " grade=" + std::to_string(query.grade);
+    if (query.since >= 0)
+        text += " since=" + timeOfDayToString(query.since);
+    if (query.until >= 0)
+        text += " until=" + timeOfDayToString(query.until);
+    return text.empty() ? "all" : text.substr(1);
 }
 
 std::string
@@ -100,6 +341,13 @@ fuelGradeToInt(FuelGrade grade)
     }
 }
 
+float
+FuelPriceTable::unitCostOf(FuelGrade grade) const
+{
+    int index = fuelGradeToInt(grade);
+    return (index >= 0) ? unitCost[index] : 0.0f;
+}
+
 FuelGrade
 intToFuelGrade(int id)
 {
@@ -15,6 +15,7 @@
  */
 #include <iostream>
 #include <sstream>
+#include <algorithm>
 #include <map>
 #include <cstdlib>
 #include <vector>
@@ -25,30 +26,54 @@
 #include <cmath>	// for std::fabs
 #include <thread>
 #include "rt.h"
+#include "spsc_pipe.h"
+#include "seqlock.h"
+#include "event_ring.h"
+#include "sim_clock.h"
+#include "station_config.h"
 #include <cassert>
 #include <random>
 #include <optional>
 #include <unordered_map>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
 
 // For storing and printing timestamps
 #include <iomanip>	// for input/output manipulations
 #include <chrono>	// for time utilities
 #include <ctime>	//for converting time to a string.
 
-const int NUM_TANKS = 4;
-const int NUM_PUMPS = 6;
+// most Customer objects alive at once; later customers reuse them (CustomerPool)
+const int MAX_NUM_CUSTOMERS = 20000;
+// only the first customers get a block on the PumpFacility screen
+const int MAX_DISPLAYED_CUSTOMERS = 100;
 
-const int MAX_NUM_CUSTOMERS = 100;
-
-const float TANK_CAPACITY = 500.0f;
-const float FLOW_RATE = 5.0f;
+const UINT FLOW_TICK_MS = 1000;	// simulated time taken to dispense or refill StationConfig::flowRate litres
 const float LOW_FUEL_VOLUME = 200.0f;
 
+// Tank volumes are kept in whole millilitres, which an atomic integer can hold exactly.
+constexpr int32_t ML_PER_LITRE = 1000;
+inline int32_t litresToMl(float litres) { return static_cast<int32_t>(std::lround(litres * ML_PER_LITRE)); }
+inline float mlToLitres(int32_t ml) { return static_cast<float>(ml) / ML_PER_LITRE; }
+
+// Costs on the pump channel are kept in whole mills (thousandths of a dollar).
+constexpr int32_t MILLS_PER_DOLLAR = 1000;
+inline int32_t dollarsToMills(float dollars) { return static_cast<int32_t>(std::lround(dollars * MILLS_PER_DOLLAR)); }
+inline float millsToDollars(int32_t mills) { return static_cast<float>(mills) / MILLS_PER_DOLLAR; }
+
+// range of the volume a customer asks for
+constexpr int MIN_LITERS = 5;
+constexpr int MAX_LITERS = 70;
+
 constexpr int TANK_UI_POSITION = 5;
-constexpr int PUMP_STATUS_POSITION = TANK_UI_POSITION + 6;
-constexpr int TXN_LIST_POSITION = PUMP_STATUS_POSITION + NUM_PUMPS * 12 + 2;
+constexpr int PUMP_STATUS_POSITION = TANK_UI_POSITION + MAX_TANKS + 2;
+// below the status blocks of all the pumps, so it depends on how many there are
+inline int txnListPosition(int num_pumps) { return PUMP_STATUS_POSITION + num_pumps * 12 + 2; }
 
-const int CUSTOMER_STATUS_POSITION = 12;
+const int CUSTOMER_STATUS_POSITION = 13;
+// PumpFacility: the line above the customer information banner, where a pump says why it dispensed nothing
+const int PUMP_NOTICE_POSITION = CUSTOMER_STATUS_POSITION - 3;
 
 /*
 	0 - Black
@@ -77,7 +102,12 @@ const int WHITE = 15;
 
 std::tm getTimestamp();
 
-void printTimestamp(std::tm now_tm);
+// `YYYY-MM-DD HH:MM:SS`
+std::string timestampToString(std::tm now_tm);
+
+// Conversions between the broken down local time used for display and seconds since the epoch.
+int64_t timestampToEpoch(std::tm now_tm);
+std::tm epochToTimestamp(int64_t epoch);
 
 // You don't need operator overloading for comparing enum class instances.
 enum class FuelGrade
@@ -92,16 +122,57 @@ enum class FuelGrade
 enum class Cmd
 {
 	PrintTxn,
+	QueryTxn,
 	Invalid
 };
+/*
+ * Contents of a tank's data pool, updated with atomic operations instead of a lock.
+ *
+ * A pump reserves the whole volume a customer asked for before it starts dispensing, so
+ * two pumps can never be promised the same fuel, and then drains its reservation a tick at
+ * a time. `availableMl` is what is left to reserve; `remainingMl` is what is physically in
+ * the tank, reserved or not, and is what the Computer shows.
+ */
 struct TankData
 {
-	// One cannot use float TANK_CAPACITY = 500.0f; to specify the default value
-	// because it is not supported by Visual Studio and thus uneffective.
-	float remainingVolume;
+	std::atomic<int32_t> remainingMl;
+	std::atomic<int32_t> availableMl;
+	int32_t capacityMl;			// set by the FuelTank before anybody else uses the tank
 	FuelGrade fuelGrade;
+
+	float remainingLitres() const { return mlToLitres(remainingMl.load(std::memory_order_acquire)); }
+
+	// Sets `ml` aside for one customer; false, with nothing set aside, if less than that is available.
+	bool reserve(int32_t ml)
+	{
+		int32_t available = availableMl.load(std::memory_order_relaxed);
+		do {
+			if (available < ml)
+				return false;
+		} while (!availableMl.compare_exchange_weak(available, available - ml, std::memory_order_acq_rel));
+		return true;
+	}
+
+	// Takes `ml` of a reservation out of the tank.
+	void drain(int32_t ml) { remainingMl.fetch_sub(ml, std::memory_order_acq_rel); }
+
+	// Adds up to `ml` without going over the capacity and returns how much went in.
+	int32_t fill(int32_t ml)
+	{
+		int32_t remaining = remainingMl.load(std::memory_order_relaxed);
+		int32_t added;
+		do {
+			added = std::min(ml, capacityMl - remaining);
+			if (added <= 0)
+				return 0;
+		} while (!remainingMl.compare_exchange_weak(remaining, remaining + added, std::memory_order_acq_rel));
+		availableMl.fetch_add(added, std::memory_order_acq_rel);
+		return added;
+	}
 };
 
+static_assert(std::atomic<int32_t>::is_always_lock_free, "TankData is shared between processes without a lock");
+
 enum class TxnStatus
 {
 	Approved,
@@ -119,6 +190,7 @@ struct CustomerRecord
 	float requestedVolume;
 	float receivedVolume;
 	float unitCost;
+	uint32_t priceVersion;		// version of the FuelPriceTable `unitCost` was taken from
 	float cost;
 	int pumpId;
 	TxnStatus txnStatus;
@@ -126,19 +198,20 @@ struct CustomerRecord
 
 	// Default member initializer
 	CustomerRecord() :
-		// default value of creditCardNumber cannot exceeds 4-digits in string format.
-		// Or, memcpy exception is thrown when trying to read/write this data.
 		grade(FuelGrade::Invalid),
 		requestedVolume(0.0f),
 		receivedVolume(0.0f),
 		unitCost(0.0f),
+		priceVersion(0),
 		cost(0.0f),
 		pumpId(-1),
 		txnStatus(TxnStatus::Pending)
 	{
-		// so far, the number of characters in any string cannot exceed 15. Or, the program fails.
+		// Strings longer than CustomerRecordWire allows are truncated when the record is sent to another thread or process.
 		creditCardNumber = "0000 0000 0000";
 		name = "___Unknown___";
+		nowTime = std::tm();
+		nowTime.tm_mday = 1;
 		nowTime.tm_year = 0; // year 1900, because tm_year is years since 1900
 
 		// Important: ensure that the time is valid. The `mktime` function
@@ -152,6 +225,7 @@ struct CustomerRecord
 		requestedVolume = 0.0f;
 		receivedVolume = 0.0f;
 		unitCost = 0.0f;
+		priceVersion = 0;
 		cost = 0.0f;
 		pumpId = -1;
 		txnStatus = TxnStatus::Pending;
@@ -159,6 +233,8 @@ struct CustomerRecord
 		creditCardNumber = "0000 0000 0000";
 		name = "___Unknown___";
 
+		nowTime = std::tm();
+		nowTime.tm_mday = 1;
 		nowTime.tm_year = 0;
 		std::mktime(&nowTime);
 	}
@@ -173,6 +249,7 @@ struct CustomerRecord
 				std::fabs(requestedVolume - other.requestedVolume) < epsilon &&
 				std::fabs(receivedVolume - other.receivedVolume) < epsilon &&
 				std::fabs(unitCost - other.unitCost) < epsilon &&
+				priceVersion == other.priceVersion &&
 				std::fabs(cost - other.cost) < epsilon &&
 				pumpId == other.pumpId &&
 				txnStatus == other.txnStatus &&
@@ -188,6 +265,7 @@ struct CustomerRecord
 				std::fabs(requestedVolume - other.requestedVolume) > epsilon ||
 				std::fabs(receivedVolume - other.receivedVolume) > epsilon ||
 				std::fabs(unitCost - other.unitCost) > epsilon ||
+				priceVersion != other.priceVersion ||
 				std::fabs(cost - other.cost) > epsilon ||
 				pumpId != other.pumpId ||
 				txnStatus != other.txnStatus ||
@@ -195,6 +273,277 @@ struct CustomerRecord
 	}
 };
 
+/*
+ * Fixed-layout copy of a CustomerRecord for pipes and data pools.
+ *
+ * A CustomerRecord owns two std::strings, so copying its bytes into a pipe or a data pool
+ * copies pointers that are meaningless to the reader (and only happened to work for strings
+ * short enough to live inside the std::string object). Everything that crosses a thread or
+ * process boundary through shared memory uses this struct instead: the strings are stored
+ * inline, the fuel grade and transaction status share one byte and the time is stored as
+ * seconds since the epoch.
+ */
+const int WIRE_NAME_SIZE = 16;	// including the terminating '\0'
+const int WIRE_CARD_SIZE = 16;	// "dddd dddd dddd" plus the terminating '\0'
+
+struct CustomerRecordWire
+{
+	char name[WIRE_NAME_SIZE];
+	char creditCardNumber[WIRE_CARD_SIZE];
+	float requestedVolume;
+	float receivedVolume;
+	float unitCost;
+	float cost;
+	int64_t nowTime;			// seconds since the epoch, 0 if the transaction has not been timestamped
+	int32_t pumpId;
+	uint8_t gradeAndStatus;		// FuelGrade in the low nibble, TxnStatus in the high nibble
+	uint16_t priceVersion;		// low 16 bits of CustomerRecord::priceVersion, in what used to be padding
+
+	FuelGrade grade() const { return static_cast<FuelGrade>(gradeAndStatus & 0x0f); }
+	TxnStatus txnStatus() const { return static_cast<TxnStatus>(gradeAndStatus >> 4); }
+
+	void setGrade(FuelGrade grade)
+	{
+		gradeAndStatus = static_cast<uint8_t>((gradeAndStatus & 0xf0) | (static_cast<int>(grade) & 0x0f));
+	}
+
+	void setTxnStatus(TxnStatus status)
+	{
+		gradeAndStatus = static_cast<uint8_t>((gradeAndStatus & 0x0f) | (static_cast<int>(status) << 4));
+	}
+
+	bool hasCustomer() const { return strcmp(name, "___Unknown___") != 0; }
+};
+
+static_assert(std::is_trivially_copyable<CustomerRecordWire>::value,
+	"CustomerRecordWire is copied byte by byte through pipes and data pools");
+
+// Neither conversion allocates: the wire strings are copied into the existing std::string buffers.
+void toWire(const CustomerRecord& record, CustomerRecordWire& wire);
+void fromWire(const CustomerRecordWire& wire, CustomerRecord& record);
+
+/*
+ * Filter for `pt` with arguments, e.g. `pt card=1234 pump=3 grade=1 since=10:00 until=12:30`.
+ * Every field left at its "any" value matches every transaction.
+ */
+struct TxnQuery
+{
+	char card[WIRE_CARD_SIZE];	// digits only: the last four or all twelve; "" for any card
+	int32_t pumpId;				// -1 for any pump
+	int32_t grade;				// fuelGradeToInt(), -1 for any grade
+	int32_t since;				// seconds after midnight, -1 for no lower bound
+	int32_t until;				// seconds after midnight, inclusive, -1 for no upper bound
+};
+
+// Parses the arguments after `pt`; false if any of them is not understood.
+bool parseTxnQuery(const std::string& text, TxnQuery& query);
+std::string txnQueryToString(const TxnQuery& query);
+
+/*
+ * What the attendant sends the Computer; `query` is only used by Cmd::QueryTxn.
+ */
+struct AttendentCommand
+{
+	Cmd cmd;
+	TxnQuery query;
+};
+
+/*
+ * What happened at a pump, in the order it happened.
+ */
+enum class PumpEventType : uint8_t
+{
+	None,			// all-zero bytes; never published
+	TxnStarted,		// a customer's details have reached the pump
+	Approved,		// the attendant approved the transaction
+	Tick,			// one more flow tick was dispensed
+	Done,			// the transaction has finished, with or without fuel
+	Reset			// the pump is free for the next customer
+};
+
+// The parts of a pump's status an event can change, as bits of PumpEvent::changed.
+const uint8_t PUMP_FIELD_STATUS = 0x01;
+const uint8_t PUMP_FIELD_VOLUME = 0x02;
+const uint8_t PUMP_FIELD_COST = 0x04;
+const uint8_t PUMP_FIELD_DETAILS = 0x08;	// the customer's name, card, grade, unit cost and requested volume
+const uint8_t PUMP_FIELDS_ALL = 0x0f;
+
+/*
+ * One change at a pump, in 12 bytes. The status, volume and cost are always those just after
+ * the change, so the newest event alone tells a reader where the transaction has got to;
+ * `changed` says which of them, if any, are different from the previous event. The volume is
+ * in millilitres and the cost in mills, so neither is rounded on the way.
+ *
+ * TxnStarted and Reset change the customer's details as well, which are too big to go with
+ * every event and are published once in PumpDetails instead.
+ */
+struct PumpEvent
+{
+	PumpEventType type;
+	uint8_t changed;		// PUMP_FIELD_* bits
+	uint8_t status;			// TxnStatus
+	int32_t receivedMl;
+	int32_t costMills;
+
+	TxnStatus txnStatus() const { return static_cast<TxnStatus>(status); }
+};
+
+/*
+ * The whole record of the pump's customer as it was when the pump published the TxnStarted
+ * or Reset event numbered `event`.
+ */
+struct PumpDetails
+{
+	uint64_t event;
+	CustomerRecordWire record;
+};
+
+const uint32_t PUMP_EVENT_RING_SIZE = 64;	// a little over four 70 L transactions at 5 L a tick
+typedef EventRing<PumpEvent, PUMP_EVENT_RING_SIZE> PumpEventRing;
+
+/*
+ * Contents of a pump data pool.
+ *
+ * The pump is the only writer of `details` and `events`, and never waits for a reader of
+ * either. When a transaction starts or the pump is reset it publishes the customer's whole
+ * record in the older of the two `details`, so a transaction's details are still there
+ * after the reset that follows it; after that, and after every other change, it appends an
+ * event to `events`. The customer and the attendant only want the newest status, which
+ * `read` puts together from the details and the newest event. The Computer follows `events`
+ * so it sees every transition, and when it has fallen so far behind that some have been
+ * written over, it starts again from `read`. It can block on `changed` instead of polling.
+ *
+ * The ring can lose events, so transactions that reach Done are also sent down the pump's
+ * DoneLane, which the Computer drains, so none of them is lost or archived twice. The one
+ * thing another thread needs to tell the pump is that the transaction has been approved,
+ * and that goes through `approval`, which the attendant sets and the pump clears.
+ */
+struct PumpStatusSlot
+{
+	SeqLock<PumpDetails> details[2];
+	PumpEventRing events;
+	ChangeNotifier changed;				// notified by the pump after every event
+	std::atomic<uint32_t> approval;		// 1 once the attendant has approved the current customer
+	uint32_t nextDetails;				// which of `details` the pump writes next; only the pump uses it
+
+	// Only the pump calls this, before it publishes anything: both details hold `record`.
+	void initDetails(const CustomerRecordWire& record)
+	{
+		PumpDetails initial;
+		initial.event = 0;
+		initial.record = record;
+		for (auto& copy : details)
+			copy.write(initial);
+		nextDetails = 0;
+	}
+
+	/*
+	 * Only the pump calls this. `record`, when there is one, is the customer's whole record:
+	 * it goes into the older of the two details before the event goes out, so whoever sees
+	 * the event can also get them. Then everybody waiting on `changed` is woken.
+	 */
+	void publish(const PumpEvent& event, const CustomerRecordWire* record)
+	{
+		if (record != nullptr) {
+			PumpDetails published;
+			published.event = events.getPublished() + 1;	// the pump is the only writer of the ring
+			published.record = *record;
+			details[nextDetails].write(published);
+			nextDetails ^= 1;
+		}
+		events.push(event);
+		changed.notify();
+	}
+
+	// The details published with the event numbered `event`; false if they have been written over since.
+	bool readDetails(uint64_t event, PumpDetails& out) const
+	{
+		for (const auto& copy : details) {
+			copy.read(out);
+			if (out.event == event)
+				return true;
+		}
+		return false;
+	}
+
+	/*
+	 * The pump's status as of the newest event, whose number it returns (0 before the first).
+	 * The details are read after the event and taken only if they are not newer than it.
+	 */
+	uint64_t read(CustomerRecordWire& wire) const
+	{
+		PumpEvent event{};
+		PumpDetails copies[2];
+		while (true) {
+			uint64_t number = events.readLatest(event);
+			details[0].read(copies[0]);
+			details[1].read(copies[1]);
+			const PumpDetails& current = (copies[1].event > copies[0].event) ? copies[1] : copies[0];
+			if (current.event > number)
+				continue;
+
+			wire = current.record;
+			if (number > 0) {
+				wire.setTxnStatus(event.txnStatus());
+				wire.receivedVolume = mlToLitres(event.receivedMl);
+				wire.cost = millsToDollars(event.costMills);
+			}
+			return number;
+		}
+	}
+};
+
+/*
+ * Lets the Computer wait for the tanks instead of polling them.
+ *
+ * Whoever changes a tank's TankData, or the price of its grade, calls `publish` afterwards,
+ * which bumps that tank's version and notifies `changed`. A monitor remembers the version of
+ * each tank it has drawn and blocks on `changed` until any of them moves, so one thread can watch
+ * all the tanks. All-zero bytes are a valid initial state.
+ */
+struct TankChanges
+{
+	std::atomic<uint32_t> versions[MAX_TANKS];
+	ChangeNotifier changed;
+
+	void publish(int tank)
+	{
+		versions[tank].fetch_add(1, std::memory_order_release);
+		changed.notify();
+	}
+};
+
+/*
+ * The unit prices of all the fuel grades, indexed by fuelGradeToInt(). Tank i holds grade i,
+ * so there is one price per tank the station can have.
+ *
+ * The table lives in the "FuelPrices" data pool as a SeqLock<FuelPriceTable>, so every
+ * process reads the same prices and a reader always gets all of them from the same change.
+ * `version` goes up by one with each change; 0 means nothing has been published yet.
+ */
+struct FuelPriceTable
+{
+	uint32_t version;
+	float unitCost[MAX_TANKS];
+
+	// 0 for FuelGrade::Invalid
+	float unitCostOf(FuelGrade grade) const;
+};
+
+/*
+ * Completed transactions on their way from a pump to the Computer, DONE_LANE_SIZE at most.
+ * A pump only waits on it if the Computer is that many transactions behind.
+ */
+typedef SpscTypedPipe<CustomerRecordWire> DoneLane;
+const UINT DONE_LANE_SIZE = 16;
+
+/*
+ * Pipe used by customers to hand their details to a pump. Each pump pipe has a single reader
+ * (the pump) and its writers are serialised by the pump assignment, so the lock-free
+ * single-producer/single-consumer pipe is used rather than a CTypedPipe.
+ */
+typedef SpscTypedPipe<CustomerRecordWire> PumpPipe;
+
 /***********************************************
  *                                             *
  *           Function Prototypes               *
@@ -230,79 +579,55 @@ void createAndAdd(std::std::vector<std::std::shared_ptr<T>>& vec, Args&&... args
 class SharedResources
 {
 private:
-	std::shared_ptr<CMutex> pumpWindowMutex;
-	std::shared_ptr<CMutex> computerWindowMutex;
-
-	std::shared_ptr<CTypedPipe<Cmd>> attendentPipe;
-	std::vector<std::shared_ptr<CTypedPipe<CustomerRecord>>> pumpPipes;
+	std::shared_ptr<CTypedPipe<AttendentCommand>> attendentPipe;
+	std::vector<std::shared_ptr<PumpPipe>> pumpPipes;
 
 	std::shared_ptr<CRendezvous> rndv;
 	std::vector<std::shared_ptr<CEvent>> txnApprovedEvents;
 
 	std::vector<std::shared_ptr<CDataPool>> tankDps;
 	std::vector<std::shared_ptr<TankData>> tankDpDataPtrs;
-	std::vector<std::shared_ptr<CMutex>> tankDpDataMutexes;
 
-	std::vector<std::shared_ptr<CDataPool>> pumpDps;
-	std::vector<std::shared_ptr<CustomerRecord>> pumpDpDataPtrs;
-	std::vector<std::shared_ptr<CReadersWritersMutex>> pumpDpDataMutexes;
+	std::shared_ptr<CDataPool> tankChangesDp;
+	std::shared_ptr<TankChanges> tankChanges;
 
-	std::vector<std::shared_ptr<CSemaphore>> producers, consumers;
+	std::shared_ptr<CDataPool> fuelPricesDp;
+	std::shared_ptr<SeqLock<FuelPriceTable>> fuelPrices;
 
-	std::vector<int> tankThreadIds;
-	std::vector<int> pumpThreadIds;
+	std::vector<std::shared_ptr<CDataPool>> pumpDps;
+	std::vector<std::shared_ptr<PumpStatusSlot>> pumpStatusSlots;
 
-public:
-	SharedResources() {
+	std::vector<std::shared_ptr<DoneLane>> doneLanes;
 
-		for (int i = 0; i < NUM_TANKS; ++i) {
-			tankThreadIds.push_back(i);
-		}
+	std::vector<int> pumpThreadIds;
 
-		for (int i = 0; i < NUM_PUMPS; ++i) {
-			pumpThreadIds.push_back(i);
-		}
+	std::shared_ptr<CDataPool> layoutDp;
+	StationConfig config;
 
-		pumpWindowMutex = std::make_shared<CMutex>("PumpScreenMutex");
-		computerWindowMutex = std::make_shared<CMutex>("ComputerWindowMutex");
-		rndv = std::make_shared<CRendezvous>("PumpRendezvous",
-										NUM_PUMPS +
-										// readTank threads of Computer
-										NUM_TANKS +
-										// main function thread of pump facility
-										1);
-		attendentPipe = std::make_shared<CTypedPipe<Cmd>>("AttendentPipe", 1);
-		
-		
-
-		for (int i = 0; i < NUM_TANKS; i++) {
-			tankDpDataMutexes.emplace_back(std::make_shared<CMutex>(getName("FuelTankDataPoolMutex", i, "")));
-			tankDps.emplace_back(std::make_shared<CDataPool>(getName("FuelTankDataPool", i, ""), sizeof(TankData)));
-			tankDpDataPtrs.emplace_back(static_cast<TankData*>(tankDps[i]->LinkDataPool()));
-		}
+	std::shared_ptr<CDataPool> clockDp;
 
-		for (int i = 0; i < NUM_PUMPS; i++) {
-			pumpDpDataMutexes.emplace_back(std::make_shared<CReadersWritersMutex>(getName("PumpDataPoolMutex", i, "")));
-			pumpDps.emplace_back(std::make_shared<CDataPool>(getName("PumpDataPool", i, ""), sizeof(CustomerRecord)));
-			pumpDpDataPtrs.emplace_back(static_cast<CustomerRecord*>(pumpDps[i]->LinkDataPool()));
-
-			// semaphore with initial value 0 and max value 1
-			producers.emplace_back(std::make_shared<CSemaphore>(getName("PS", i, ""), 0, 1));
-			// semaphore with initial value 1 and max value 1
-			consumers.emplace_back(std::make_shared<CSemaphore>(getName("CS", i, ""), 1, 1));
+public:
+	/*
+	 * Creates, or links to, everything the two processes share, sized by the layout the first
+	 * of them published. Must be called once, before anything else uses the shared resources.
+	 * Returns false if that layout is not `requested`, i.e. the other process was started with
+	 * different options and this one now runs with getConfig() instead.
+	 */
+	bool open(const StationConfig& requested);
 
-			pumpPipes.emplace_back(std::make_shared<CTypedPipe<CustomerRecord>>(getName("Pipe", i, ""), 1));
+	const StationConfig& getConfig() const { return config; }
 
-			txnApprovedEvents.emplace_back(std::make_shared<CEvent>(getName("TxnApprovedByPump", i, "")));
-		}
-	}
+	/*
+	 * Puts this process's SimClock on the clock in the "SimClock" data pool, so both processes
+	 * time stamp transactions on the same simulated time. Returns false if the other process
+	 * got there first with a different --clock, which this one now runs on instead.
+	 */
+	bool shareClock();
 
 	auto getTankDpDataVec() const { return tankDpDataPtrs; }
-	auto getTankDpDataMutexVec() const { return tankDpDataMutexes; }
 	auto getPumpPipeVec() const { return pumpPipes; }
 	auto getTxnApprovedEventVec() const { return txnApprovedEvents; }
-	auto getPumpDataPooMutexlVec() const { return pumpDpDataMutexes; }
-	auto getPumpDpDataPtrVec() const { return pumpDpDataPtrs; }
+	auto getPumpStatusVec() const { return pumpStatusSlots; }
 
 	/**
 	 * In the context of multithreaded programming, returning by value (i.e., making a copy) ensures that
@@ -314,25 +639,22 @@ public:
 	 */
 	std::shared_ptr<TankData> getTankDpDataPtr(int n) const { return tankDpDataPtrs[n]; }
 
-	std::shared_ptr<CMutex> getTankDpMutex(int n) const { return tankDpDataMutexes[n]; }
-	std::shared_ptr<CMutex> getPumpWindowMutex() const { return pumpWindowMutex; }
-	std::shared_ptr<CMutex> getComputerWindowMutex() const { return computerWindowMutex; }
+	std::shared_ptr<TankChanges> getTankChanges() const { return tankChanges; }
+
+	std::shared_ptr<SeqLock<FuelPriceTable>> getFuelPrices() const { return fuelPrices; }
 
 	
 	std::shared_ptr<CRendezvous> getRndv() const { return rndv; }
-	std::shared_ptr<CTypedPipe<Cmd>> getAttendentPipe() const { return attendentPipe; }
+	std::shared_ptr<CTypedPipe<AttendentCommand>> getAttendentPipe() const { return attendentPipe; }
 
-	auto getPumpDpDataMutex(int n) const { return pumpDpDataMutexes[n]; }
-	std::shared_ptr<CustomerRecord> getPumpDpDataPtr(int n) const { return pumpDpDataPtrs[n]; }
+	std::shared_ptr<PumpStatusSlot> getPumpStatus(int n) const { return pumpStatusSlots[n]; }
 
-	std::shared_ptr<CSemaphore> getProducer(int n) const { return producers[n]; }
-	std::shared_ptr<CSemaphore> getConsumer(int n) const { return consumers[n]; }
+	std::shared_ptr<DoneLane> getDoneLane(int n) const { return doneLanes[n]; }
 
-	std::shared_ptr<CTypedPipe<CustomerRecord>> getPumpPipe(int n) const { return pumpPipes[n]; }
+	std::shared_ptr<PumpPipe> getPumpPipe(int n) const { return pumpPipes[n]; }
 
 	std::shared_ptr<CEvent> getTxnApprovedEvent(int n) const { return txnApprovedEvents[n]; }
 
-	std::vector<int>& getTankThreadIds() { return tankThreadIds; }
 	std::vector<int>& getPumpThreadIds() { return pumpThreadIds; }
 
 };
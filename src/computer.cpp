@@ -1,6 +1,8 @@
 #include "fuel_price.h"
 #include "computer.h"
 #include "pump_controller.h"
+#include "txn_journal.h"
+#include "screen_renderer.h"
 
 using namespace std;
 /**
@@ -8,27 +10,46 @@ using namespace std;
  * declared inside the implementation file.
  */
 
-list<CustomerRecord> txnList;
+// this run's transactions; the history puts whatever an earlier run journalled in front of them
+TxnStore txnStore;
+TxnHistory txnHistory(txnStore);
+TxnListPrinter txnPrinter(txnHistory);
 
-unique_ptr<CMutex> txnListMutex = make_unique<CMutex>("TransactionListMutex");
-TxnListPrinter txnPrinter(txnList);
+// for `pt` with filters; only the printTxnHistory thread uses it
+TxnIndex txnIndex(txnHistory);
 
-vector<shared_ptr<TankData>> tankDpData;
-vector<shared_ptr<CMutex>> tankDpMutex;
+// matches listed by a query, the newest ones if there are more
+const int QUERY_ROWS = 20;
 
-shared_ptr<CMutex> windowMutex = sharedResources.getComputerWindowMutex();
+/*
+ * Durable copy of every archived transaction, one file per simulated day, opened once the
+ * clock (and so the date) is set up. The pump threads take journalMutex to append, and the
+ * first of them to archive a transaction on a new day switches to that day's file.
+ */
+mutex journalMutex;
+shared_ptr<TxnJournal> txnJournal;
+tm journalDay;
 
-vector<float> tankReadingsPercent(NUM_TANKS, 0.0f);
-vector<float> tankReadings(NUM_TANKS, 0.0f);
+vector<shared_ptr<TankData>> tankDpData;
+shared_ptr<TankChanges> tankChanges;
+shared_ptr<SeqLock<FuelPriceTable>> fuelPrices;
 
-shared_ptr<CTypedPipe<Cmd>> attendentPipe;
+ScreenRenderer& screen = ScreenRenderer::get();
+
+shared_ptr<CTypedPipe<AttendentCommand>> attendentPipe;
 
 vector<unique_ptr<CThread>> readPumpThreads;
 
 vector<unique_ptr<PumpController>> pumpController;
-vector<unique_ptr<CThread>> readTankThreads;
+unique_ptr<CThread> tankMonitorThread;
+
+// how often a tank that is running low flashes
+const int TANK_FLASH_MS = 500;
 
-shared_ptr<CRendezvous> rndv = sharedResources.getRndv();
+shared_ptr<CRendezvous> rndv;
+
+// first row of the transaction history, below the status blocks of however many pumps there are
+int txnListTop = 0;
 
 /***********************************************
  *                                             *
@@ -38,68 +59,78 @@ shared_ptr<CRendezvous> rndv = sharedResources.getRndv();
 
 vector<unique_ptr<CThread>> transactionThreads;
 
-TxnListPrinter::TxnListPrinter(list<CustomerRecord>& lst) : lst(&lst) {}
+TxnListPrinter::TxnListPrinter(const TxnHistory& history) : history(&history) {}
 
 void
 TxnListPrinter::printNew()
 {
-	static int count = 0;
-	static size_t last_size = 0;
 	const int offset = 12;
-	
-	txnListMutex->Wait();
-	if (lst->size() == 0)
-		cout << "Cannot print txn because list size is 0." << endl;
-
-	if (last_size < lst->size()) {
-		auto it = lst->begin();
-		advance(it, last_size);
-
-		while (it != lst->end()) {
-			printTxn(*it, count * offset + TXN_LIST_POSITION, count);
-			++it;
-			++count;
-		}
+	CustomerRecordWire wire;
+	CustomerRecord txn;
 
-		last_size = lst->size();
+	if (history->size() == 0)
+		screen.print(0, txnListTop, "Cannot print txn because list size is 0.");
+
+	// Only the transactions archived since the last call are visited, without stopping the archiving.
+	while (true) {
+		int count = static_cast<int>(cursor.position());
+		int position = count * offset + txnListTop;
+		if (position + offset > SCREEN_MAX_ROWS) {
+			// The screen ends here; the rest can still be looked up.
+			if (history->size() > static_cast<uint64_t>(count)) {
+				ostringstream notice;
+				notice << "History truncated: transactions " << count << " to " << history->size() - 1
+					<< " are not shown, use `pt` filters to list them.";
+				screen.print(0, position, notice.str(), 12);
+			}
+			break;
+		}
+		if (!history->read(cursor, wire))
+			break;
+		fromWire(wire, txn);
+		printTxn(txn, position, count);
 	}
-	txnListMutex->Signal();
+}
+
+void
+TxnListPrinter::restart()
+{
+	cursor = TxnHistory::Cursor();
 }
 
 void
 setupComputer()
 {
-	vector<int>& tankThreadIds = sharedResources.getTankThreadIds();
 	vector<int>& pumpThreadIds = sharedResources.getPumpThreadIds();
+	const int num_pumps = sharedResources.getConfig().numPumps;
+
+	rndv = sharedResources.getRndv();
+	txnListTop = txnListPosition(num_pumps);
 
-	tankDpMutex = sharedResources.getTankDpDataMutexVec();
 	tankDpData = sharedResources.getTankDpDataVec();
+	tankChanges = sharedResources.getTankChanges();
+	fuelPrices = sharedResources.getFuelPrices();
 
-	for (int i = 0; i < NUM_TANKS; ++i) {
-		// Make read tank threads active at creation time can avoid UI being garbled.
-		// The vector `tankThreadIds` must be a global variable so that it does not get
-		// destroyed when it goes out of scopt.
-		readTankThreads.emplace_back(make_unique<CThread>(readTank, ACTIVE, &tankThreadIds[i]));
-	}
+	// Only the journal's tail is recovered; the day's earlier transactions are read from it when shown.
+	journalDay = getTimestamp();
+	txnJournal = make_shared<TxnJournal>(dailyJournalPath(journalDay));
+	txnHistory.startWith(txnJournal);
 
-	
-	for (int i = 0; i < NUM_PUMPS; ++i) {
-		pumpThreadIds.push_back(i);
-	}
+	// Make the tank monitor thread active at creation time can avoid UI being garbled.
+	tankMonitorThread = make_unique<CThread>(monitorTanks, ACTIVE, nullptr);
 
-	for (int i = 0; i < NUM_PUMPS; ++i) {
+	
+	for (int i = 0; i < num_pumps; ++i) {
 		pumpController.emplace_back(make_unique<PumpController>(i));
 		readPumpThreads.emplace_back(make_unique<CThread>(runPump, ACTIVE, &pumpThreadIds[i]));
 	}
 
 	attendentPipe = sharedResources.getAttendentPipe();
 
-	windowMutex->Wait();
-	MOVE_CURSOR(0, 0);
-	cout << "--------------------------------------------------------------------------------" << endl;
-	cout << "                           Gas Station Computer (GSC)                           " << endl;
-	cout << "--------------------------------------------------------------------------------" << endl;
-	windowMutex->Signal();
+	screen.print(0, 0,
+		"--------------------------------------------------------------------------------\n"
+		"                           Gas Station Computer (GSC)                           \n"
+		"--------------------------------------------------------------------------------");
 }
 
 void exitComputer()
@@ -107,57 +138,137 @@ void exitComputer()
 	for (const auto& t : transactionThreads) {
 		t->WaitForThread();
 	}
-	for (const auto& t : readTankThreads) {
-		t->WaitForThread();
-	}
+	tankMonitorThread->WaitForThread();
 	for (const auto& t : readPumpThreads) {
 		t->WaitForThread();
 	}
+	{
+		lock_guard<mutex> lock(journalMutex);
+		txnJournal->flush();
+	}
+
+	// the last frame, before main() writes to the console itself
+	screen.flush();
 }
 
 void
 printTxn(const CustomerRecord& record, int position, int txn_id)
 {
-	windowMutex->Wait();
-	MOVE_CURSOR(0, position);
-	cout << "--------------- Pump " << record.pumpId << " Transaction " << txn_id  << " --------------- \n";
+	ostringstream out;
+	out << "--------------- Pump " << record.pumpId << " Transaction " << txn_id  << " --------------- \n";
 	/*
-	* For some reason, there are some residual characters on the DOS window that were printed from previous calls
+	* For some reason, there are some residual characters on the screen that were printed from previous calls
 	* of this function, leanding to some puzzling characters printed in the furture calls of this function
 	* (e.g., waitoved, N/A 85, etc.).
 	* To resolve this problem, we can print use empty string " " to overwrite those residual characters.
 	*/
 	if (record.name == "___Unknown___") {
-		cout << "Name:                      " << "N/A             " << "\n";
-		cout << "Credit Card Number:        " << "N/A             " << "\n";
-		cout << "Fuel Grade:                " << "N/A             " << "\n";
-		cout << "Unit Cost ($/L):           " << "N/A             " << "\n";
-		cout << "Requested Volume (L):      " << "N/A             " << "\n";
-		cout << "Received Volume (L):       " << "N/A             " << "\n";
-		cout << "Total Cost ($):            " << "N/A             " << "\n";
-		cout << "Transaction Status:        " << "N/A             " << "\n";
+		out << "Name:                      " << "N/A             " << "\n";
+		out << "Credit Card Number:        " << "N/A             " << "\n";
+		out << "Fuel Grade:                " << "N/A             " << "\n";
+		out << "Unit Cost ($/L):           " << "N/A                             " << "\n";
+		out << "Requested Volume (L):      " << "N/A             " << "\n";
+		out << "Received Volume (L):       " << "N/A             " << "\n";
+		out << "Total Cost ($):            " << "N/A             " << "\n";
+		out << "Transaction Status:        " << "N/A             " << "\n";
 	}
 	else {
-		cout << "Name:                      " << record.name                         << "          " << "\n";
-		cout << "Credit Card Number:        " << record.creditCardNumber             << "          " << "\n";
-		cout << "Fuel Grade:                " << fuelGradeToString(record.grade)     << "          " << "\n";
-		cout << "Unit Cost ($/L):           " << record.unitCost                     << "          " << "\n";
-		cout << "Requested Volume (L):      " << record.requestedVolume              << "          " << "\n";
-		cout << "Received Volume (L):       " << record.receivedVolume               << "          " << "\n";
-		cout << "Total Cost ($):            " << record.cost                         << "          " << "\n";
-		cout << "Transaction Status:        " << txnStatusToString(record.txnStatus) << "          " << "\n";
-		cout << "Pump ID:                   " << record.pumpId                       << "          " << "\n";
+		out << "Name:                      " << record.name                         << "          " << "\n";
+		out << "Credit Card Number:        " << record.creditCardNumber             << "          " << "\n";
+		out << "Fuel Grade:                " << fuelGradeToString(record.grade)     << "          " << "\n";
+		out << "Unit Cost ($/L):           " << record.unitCost << " (price list " << record.priceVersion << ")" << "          " << "\n";
+		out << "Requested Volume (L):      " << record.requestedVolume              << "          " << "\n";
+		out << "Received Volume (L):       " << record.receivedVolume               << "          " << "\n";
+		out << "Total Cost ($):            " << record.cost                         << "          " << "\n";
+		out << "Transaction Status:        " << txnStatusToString(record.txnStatus) << "          " << "\n";
+		out << "Pump ID:                   " << record.pumpId                       << "          " << "\n";
 		if (record.nowTime.tm_year == 0) {
-			cout << "Time:                                              " << "\n";
+			out << "Time:                                              " << "\n";
 		}
 		else {
-			cout << "Time:                      ";
-			printTimestamp(record.nowTime);
+			out << "Time:                      " << timestampToString(record.nowTime) << "\n";
 		}
 	}
-	cout << "----------------------------------------------------\n";
-	cout << "\n";
-	windowMutex->Signal();
+	out << "----------------------------------------------------\n";
+	screen.print(0, position, out.str());
+}
+
+/*
+ * Lists the transactions matching `query` in place of the transaction history: a banner
+ * with the query, how many matched and how long the lookup took, then one line per match.
+ * `rows_on_screen` lines from the previous query are blanked if this one has fewer.
+ * Returns the number of lines printed under the banner.
+ */
+int
+printTxnQuery(const TxnQuery& query, int rows_on_screen)
+{
+	tm midnight = getTimestamp();
+	midnight.tm_hour = 0;
+	midnight.tm_min = 0;
+	midnight.tm_sec = 0;
+
+	auto start = chrono::steady_clock::now();
+	vector<uint32_t> ids = txnIndex.query(query, timestampToEpoch(midnight));
+	chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+
+	size_t first = (ids.size() > QUERY_ROWS) ? ids.size() - QUERY_ROWS : 0;
+	vector<string> lines;
+
+	ostringstream row;
+	row << left << setw(7) << "Txn" << setw(5) << "Pump" << setw(9) << "Grade" << setw(16) << "Card"
+		<< setw(16) << "Name" << setw(8) << "Litres" << setw(9) << "Cost ($)" << "Time";
+	lines.push_back(row.str());
+
+	CustomerRecordWire txn;
+	for (size_t i = first; i < ids.size(); i++) {
+		if (!txnHistory.at(ids[i], txn))
+			continue;
+		tm time = epochToTimestamp(txn.nowTime);
+		char clock[16] = "";
+		if (txn.nowTime != 0)
+			snprintf(clock, sizeof(clock), "%02d:%02d:%02d", time.tm_hour, time.tm_min, time.tm_sec);
+
+		row.str("");
+		row << left << setfill(' ') << setw(7) << ids[i] << setw(5) << txn.pumpId << setw(9) << fuelGradeToString(txn.grade())
+			<< setw(16) << txn.creditCardNumber << setw(16) << txn.name << fixed << setprecision(1) << setw(8) << txn.receivedVolume
+			<< setprecision(2) << setw(9) << txn.cost << clock;
+		lines.push_back(row.str());
+	}
+
+	ostringstream banner;
+	banner << "Transactions " << txnQueryToString(query) << ": " << ids.size() << " found in " << fixed
+		<< setprecision(3) << elapsed.count() << " ms";
+	if (ids.size() > QUERY_ROWS)
+		banner << ", newest " << QUERY_ROWS << " shown";
+
+	ostringstream out;
+	out << "--------------------------------------------------------------------------------\n";
+	out << left << setw(80) << banner.str() << "\n";
+	out << "--------------------------------------------------------------------------------\n";
+	for (const string& line : lines)
+		out << setw(80) << line << "\n";
+	for (int i = static_cast<int>(lines.size()); i < rows_on_screen; i++)
+		out << setw(80) << "" << "\n";
+	screen.print(0, txnListTop - 3, out.str());
+
+	return static_cast<int>(lines.size());
+}
+
+/*
+ * Appends `txn` to the journal of the day it was archived on, starting that day's file if
+ * it is the first. The previous day's journal is committed and closed once nothing else
+ * holds it (the history keeps the one it started with).
+ */
+void
+journalTxn(const CustomerRecord& txn)
+{
+	lock_guard<mutex> lock(journalMutex);
+	if (txn.nowTime.tm_year != journalDay.tm_year || txn.nowTime.tm_yday != journalDay.tm_yday) {
+		txnJournal->flush();
+		journalDay = txn.nowTime;
+		txnJournal = make_shared<TxnJournal>(dailyJournalPath(journalDay));
+	}
+	txnJournal->append(txn);
 }
 
 void
@@ -165,29 +276,34 @@ writeTxnToPipe(const unique_ptr<PumpController>& pump_ctrl)
 {
 	pump_ctrl->addTimestamp();
 
-	CustomerRecord txn = pump_ctrl->getData();
-
-	if (txn.txnStatus == TxnStatus::Done) {
+	// Every finished transaction comes down the pump's Done lane once, however many records the display skipped.
+	CustomerRecord txn;
+	while (pump_ctrl->readFinished(txn)) {
+		txn.nowTime = pump_ctrl->getData().nowTime;
 		txn.txnStatus = TxnStatus::Archived;
-		pump_ctrl->archiveData();
 
-		txnListMutex->Wait();
-		txnList.push_back(txn);
-		txnListMutex->Signal();
+		CustomerRecordWire wire;
+		toWire(txn, wire);
+		PERR(txnStore.append(wire), "Transaction store is full");
+
+		journalTxn(txn);
 	}
+
+	if (pump_ctrl->getData().txnStatus == TxnStatus::Done)
+		pump_ctrl->archiveData();
 }
 
 UINT __stdcall
 runPump(void* args)
 {
 	int id = *(int*)(args);
-	assert(id >= 0 && id <= NUM_PUMPS - 1);
+	assert(id >= 0 && id <= sharedResources.getConfig().numPumps - 1);
 
 	pumpController[id]->printPumpStatus(pumpController[id]->getData());
 
 	while (true) {
 
-		pumpController[id]->readData();
+		pumpController[id]->readEvents();
 
 		writeTxnToPipe(pumpController[id]);
 
@@ -200,24 +316,36 @@ runPump(void* args)
 UINT __stdcall
 printTxnHistory(void* args)
 {
-	Cmd cmd = Cmd::Invalid;
+	AttendentCommand command;
 	bool executedOnce = false;
 
-	while (true) {
-		attendentPipe->Read(&cmd);
+	// lines a query has put where the history goes
+	int queryRows = 0;
 
-		if (cmd == Cmd::PrintTxn) {
+	while (true) {
+		attendentPipe->Read(&command);
+
+		if (command.cmd == Cmd::PrintTxn) {
+			if (queryRows > 0) {
+				// Draw the whole history again over the query's lines.
+				for (int i = 0; i < queryRows; i++)
+					screen.print(0, txnListTop + i, string(80, ' '));
+				queryRows = 0;
+				executedOnce = false;
+				txnPrinter.restart();
+			}
 			if (!executedOnce) {
-				windowMutex->Wait();
-				MOVE_CURSOR(0, TXN_LIST_POSITION - 3);
-				cout << "--------------------------------------------------------------------------------" << endl;
-				cout << "                           Transaction History                                  " << endl;
-				cout << "--------------------------------------------------------------------------------" << endl;
-				windowMutex->Signal();
+				screen.print(0, txnListTop - 3,
+					"--------------------------------------------------------------------------------\n"
+					"                           Transaction History                                  \n"
+					"--------------------------------------------------------------------------------");
 				executedOnce = true;
 			}
 			txnPrinter.printNew();
 		}
+		else if (command.cmd == Cmd::QueryTxn) {
+			queryRows = printTxnQuery(command.query, queryRows);
+		}
 	}
 	return 0;
 }
@@ -238,72 +366,97 @@ printTxnHistory(void* args)
  * print out debug info. We can just use the print statement without branch
  * conditionsfor debugging.
  *******************************************************************************************/
-UINT __stdcall
-readTank(void* args)
+/*
+ * Draws the bar of one tank holding `reading` litres. A tank below LOW_FUEL_VOLUME is drawn
+ * in red while `flash_on` and in the default colour otherwise.
+ */
+static void
+drawTank(int tank_id, FuelGrade grade, float unit_cost, float reading, bool flash_on)
 {
-	int tank_id = *(int*)(args);
-	assert(tank_id >= 0 && tank_id <= 3);
-	TankData tank_data;
-	
 	static const int maxBarLength = 14;
 	static const char barChar = '#';
-	static bool flash_red = false;
-	static bool toggle = true;
+
+	const float capacity = sharedResources.getConfig().tankCapacity;
+
+	float percent = reading / capacity * 100;
+	// Calculate the length of the bar based on the fuel level
+	int bar_length = (int)(reading / capacity * maxBarLength);
+
+	int colour = 7;	// TEXT_COLOUR()'s default
+	if (percent > 75) {
+		colour = GREEN;
+	}
+	else if (reading >= LOW_FUEL_VOLUME) {
+		colour = YELLOW;
+	}
+	else if (flash_on) {
+		colour = RED;
+	}
+
+	// Draw the bar
+	ostringstream out;
+	out << "Tank " << tank_id << " (" << fuelGradeToString(grade) << " $" << fixed << setprecision(2) << unit_cost << "/L): [";
+	for (int i = 0; i < bar_length; ++i) {
+		out << barChar;
+	}
+	for (int i = bar_length; i < maxBarLength; ++i) {
+		out << " ";
+	}
+
+	// Dispensing leaves fractions of a litre, so round rather than print every digit.
+	out << "] " << fixed << setprecision(0) << percent << "% " << "(" << setprecision(1) << reading << " Liters)          ";
+	screen.print(0, TANK_UI_POSITION + tank_id, out.str(), colour);
+}
+
+/*
+ * Watches all the tanks from one thread. It sleeps until a tank publishes a change, then
+ * redraws the tanks whose version has moved; while any tank is low it also wakes every
+ * TANK_FLASH_MS to flash those tanks.
+ */
+UINT __stdcall
+monitorTanks(void* args)
+{
+	const int num_tanks = sharedResources.getConfig().numTanks;
+	uint32_t drawn[MAX_TANKS] = {};
+	bool low[MAX_TANKS] = {};
+	bool first_pass = true;
+	bool flash_on = true;
+
 	rndv->Wait();
 
+	auto next_flash = chrono::steady_clock::now() + chrono::milliseconds(TANK_FLASH_MS);
 	while (true) {
-		tankDpMutex[tank_id]->Wait();
-		tank_data = *tankDpData[tank_id];
-		tankDpMutex[tank_id]->Signal();
-
-		if (tankReadings[tank_id] != tank_data.remainingVolume || tankReadings[tank_id] < LOW_FUEL_VOLUME) {
-			tankReadings[tank_id] = tank_data.remainingVolume;
-
-			
-			tankReadingsPercent[tank_id] = tankReadings[tank_id] / TANK_CAPACITY * 100;
-			// Calculate the length of the bar based on the fuel level
-			int bar_length = (int)(tankReadings[tank_id] / TANK_CAPACITY * maxBarLength);
-		
-			if (tankReadings[tank_id] < LOW_FUEL_VOLUME) {
-				flash_red = true;
-			}
-			else {
-				flash_red = false;
-			}
+		// Taken before looking at the versions, so a change published while drawing is not missed.
+		uint32_t generation = tankChanges->changed.current();
 
-			windowMutex->Wait();
-			MOVE_CURSOR(0, TANK_UI_POSITION + tank_id); // Move the cursor to the appropriate location on the screen
-			if (tankReadingsPercent[tank_id] > 75) {
-				TEXT_COLOUR(GREEN);
-			}
-			if (tankReadingsPercent[tank_id] <= 75 && tankReadings[tank_id] >= LOW_FUEL_VOLUME) {
-				TEXT_COLOUR(YELLOW);
-			}
-			if (flash_red) {
-				if (toggle) {
-					TEXT_COLOUR(RED);
-				}
-				else {
-					TEXT_COLOUR();
-				}
-				toggle = !toggle;
-			}
+		bool flash_due = chrono::steady_clock::now() >= next_flash;
+		if (flash_due) {
+			flash_on = !flash_on;
+			next_flash = chrono::steady_clock::now() + chrono::milliseconds(TANK_FLASH_MS);
+		}
 
-			// Draw the bar
-			cout << "Tank " << tank_id << " (" << fuelGradeToString(static_cast<FuelGrade>(tank_data.fuelGrade)) << "): [";
-			for (int i = 0; i < bar_length; ++i) {
-				cout << barChar;
-			}
-			for (int i = bar_length; i < maxBarLength; ++i) {
-				cout << " ";
+		// a `cp` publishes the tank of its grade, so the prices are read with the levels
+		FuelPriceTable prices = fuelPrices->read();
+
+		bool any_low = false;
+		for (int i = 0; i < num_tanks; i++) {
+			uint32_t version = tankChanges->versions[i].load(memory_order_acquire);
+			if (first_pass || version != drawn[i] || (flash_due && low[i])) {
+				float reading = tankDpData[i]->remainingLitres();
+				drawn[i] = version;
+				low[i] = reading < LOW_FUEL_VOLUME;
+				drawTank(i, tankDpData[i]->fuelGrade, prices.unitCost[i], reading, flash_on);
 			}
+			any_low = any_low || low[i];
+		}
+		first_pass = false;
 
-			cout << "] " << tankReadingsPercent[tank_id] << "% " << "(" << tankReadings[tank_id] << " Liters)          " << endl;
-			fflush(stdout);
-			TEXT_COLOUR();
-			windowMutex->Signal();
-			SLEEP(500);
+		DWORD timeout = INFINITE;
+		if (any_low) {
+			auto until_flash = chrono::duration_cast<chrono::milliseconds>(next_flash - chrono::steady_clock::now()).count();
+			timeout = (until_flash > 0) ? static_cast<DWORD>(until_flash) : 0;
 		}
+		tankChanges->changed.waitForChange(generation, timeout);
 	}
 	return 0;
-}
\ No newline at end of file
+}
@@ -4,7 +4,8 @@
 #include "rt.h"
 #include "common.h"
 #include "pump_controller.h"
-#include <list>
+#include "txn_store.h"
+#include "txn_index.h"
 
 /**
  * To avoid linker tools error LNK2005/LNK1169 (i.e., symbol was defined more than once.),
@@ -13,10 +14,12 @@
  */
 void setupComputer();
 void printTxn(const CustomerRecord& record, int position, int txn_id);
+int printTxnQuery(const TxnQuery& query, int rows_on_screen);
 void exitComputer();
+void journalTxn(const CustomerRecord& txn);
 void writeTxnToPipe(const std::unique_ptr<PumpController>& pump_ctrl);
 
-UINT __stdcall readTank(void* args);
+UINT __stdcall monitorTanks(void* args);
 UINT __stdcall printTxnHistory(void* args);
 UINT __stdcall runPump(void* args);
 
@@ -25,22 +28,24 @@ class TxnListPrinter
 private:
 	/**
 	 * Using a smart pointer would not be better here.
-	 * This class does not own the std::list it's printing. It's just given a address reference to it.
-	 * Thus, it's not this class's responsibility to delete the std::list when it's done.
-	 * This is the responsibility of whoever owns the std::list that is passed to the class's constructor.
+	 * This class does not own the history it's printing. It's just given a address reference to it.
+	 * Thus, it's not this class's responsibility to delete the history when it's done.
+	 * This is the responsibility of whoever owns the history that is passed to the class's constructor.
 	 * It's considered good practice to use raw pointers or references when you want to merely observe
 	 * an object (i.e., you don't need to control its lifetime).
-	 * The reference to the std::list tells users of the ListPrinter class that the class will use the std::list
-	 * but won't manage its memory.
 	 */
-	std::list<CustomerRecord>* lst;
-	
-	std::unique_ptr<CMutex> mutex;
+	const TxnHistory* history;
+
+	// where the previous call stopped; only this printer's thread moves it
+	TxnHistory::Cursor cursor;
 
 public:
-	TxnListPrinter(std::list<CustomerRecord>& lst);
+	TxnListPrinter(const TxnHistory& history);
 
 	void printNew();
+
+	// Prints everything again on the next call, e.g. after something else drew over the list.
+	void restart();
 };
 
 #endif // __COMPUTER_H__
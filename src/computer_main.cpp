@@ -1,6 +1,18 @@
 #include "computer.h"
 
-int main(void) {
+int main(int argc, char* argv[]) {
+
+	// The --clock option only counts if the Computer starts first; otherwise it runs on the PumpFacility's clock.
+	if (!SimClock::get().configureFromArgs(argc, argv))
+		return 1;
+
+	StationConfig config = StationConfig::defaults();
+	if (!config.configureFromArgs(argc, argv))
+		return 1;
+	if (!sharedResources.open(config))
+		std::cout << "Using the PumpFacility's layout: " << sharedResources.getConfig().toString() << std::endl;
+	if (!sharedResources.shareClock())
+		std::cout << "Using the PumpFacility's clock: " << SimClock::get().toString() << std::endl;
 
 	setupComputer();
 
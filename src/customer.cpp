@@ -1,72 +1,63 @@
 #include "customer.h"
+#include "customer_pool.h"
 #include <cstdlib>
 #include <random>
 #include <cmath>
 
 using namespace std;
 
-constexpr int MIN_LITERS = 5;
-constexpr int MAX_LITERS = 70;
+ChangeNotifier Customer::changes;
+
 
 /*
 * Receive fuel should not happen after returning the pump hose. Need to fix this.
 */
-Customer::Customer(vector<unique_ptr<Pump>>& pumps, FuelPrice& fuelPrice)
-    : pumpId(-1), pumps_(pumps), fuelPrice_(fuelPrice)
+Customer::Customer(vector<unique_ptr<Pump>>& pumps, FuelPrice& fuelPrice, PumpDispatcher& dispatcher, TaskPool& pool, CustomerPool& home)
+    : pumpId(-1), dispatcher_(dispatcher), pool_(pool), home_(home), fuelPrice_(fuelPrice), pumps_(pumps)
 {
-    windowMutex = sharedResources.getPumpWindowMutex();
     pipe = sharedResources.getPumpPipeVec();
-    txnApprovedEvent = sharedResources.getTxnApprovedEventVec();
-    
-    data.name = getRandomName();
-    data.requestedVolume = getRandomFloat(MIN_LITERS, MAX_LITERS);
-    data.txnStatus = TxnStatus::Pending;
-    status = CustomerStatus::Null;
-    pumpEnquiryMutex = make_unique<CMutex>("PumpEnquiryMutex");
+
+    renew();
 }
 
-int
-Customer::getAvailPumpId()
+void
+Customer::renew()
 {
-    while (true) {
-        pumpEnquiryMutex->Wait();
-        for (int i = 0; i < NUM_PUMPS; i++) {
-            if ( !pumps_[i]->isBusy() ) {
-                // Own the pump so that it cannot be shared by others.
-                pumps_[i]->setBusy();
-                data.pumpId = i;
-                pumpEnquiryMutex->Signal();
-                assert(pumps_[i]->isBusy() == true);
-                return i;
-            }
-        }
-        pumpEnquiryMutex->Signal();
-    }
+    pumpId = -1;
+    pumpStatus.reset();
+
+    data.resetToDefault();
+    data.name = getRandomName();
+    data.requestedVolume = getRandomFloat(MIN_LITERS, MAX_LITERS);
+    data.txnStatus = TxnStatus::Pending;
+    setStatus(CustomerStatus::Null);
 }
 
 void
-Customer::arriveAtPump()
+Customer::arriveAtPump(int pump_id)
 {
-    status = CustomerStatus::WaitForPump;
-
-    pumpId = getAvailPumpId();
+    // Own the pump so that it cannot be shared by others.
+    assert(pumps_[pump_id]->isBusy() == false);
+    pumps_[pump_id]->setBusy();
+    pumpId = pump_id;
+    data.pumpId = pump_id;
 
-    pumpDpMutex = sharedResources.getPumpDpDataMutex(pumpId);
+    pumpStatus = sharedResources.getPumpStatus(pumpId);
 
-    status = CustomerStatus::ArriveAtPump;
+    setStatus(CustomerStatus::ArriveAtPump);
 }
 
 void
 Customer::swipeCreditCard()
 {
     data.creditCardNumber = getRandomCreditCardNumber();
-    status = CustomerStatus::SwipeCreditCard;
+    setStatus(CustomerStatus::SwipeCreditCard);
 }
 
 void
 Customer::removeGasHose()
 {
-    status = CustomerStatus::RemoveGasHose;
+    setStatus(CustomerStatus::RemoveGasHose);
 }
 
 void
@@ -75,36 +66,51 @@ Customer::selectFuelGrade()
     data.grade = getRandomFuelGrade();
     //data.grade = FuelGrade::Oct87;
 
-    status = CustomerStatus::SelectFuelGrade;
+    setStatus(CustomerStatus::SelectFuelGrade);
     
     assert(fuelGradeToInt(data.grade) >= 0 && fuelGradeToInt(data.grade) <= 3);
 
-    data.unitCost = fuelPrice_.getUnitCost(data.grade);
+    // The customer pays the price on the pump when the grade is picked, whatever `cp` does meanwhile.
+    FuelPriceTable prices = fuelPrice_.snapshot();
+    data.unitCost = prices.unitCostOf(data.grade);
+    data.priceVersion = prices.version;
+    publish();
 
     writePipe(&data);
 }
 
-void
-Customer::getFuel()
+/*
+ * True once the pump has published the attendant's approval. The pump also reports Done
+ * straight away when it cannot serve the request, which ends the wait as well.
+ */
+bool
+Customer::isApproved()
 {
-    status = CustomerStatus::WaitForAuth;
-
-    txnApprovedEvent[pumpId]->Wait();
-    
-    status = CustomerStatus::GetFuel;
-
-    do {
-        pumpDpMutex->WaitToRead();
-        data.receivedVolume = pumps_[pumpId]->getReceivedVolume();
-        data.cost = pumps_[pumpId]->getTotalCost();
-        pumpDpMutex->DoneReading();
-    } while (data.receivedVolume < data.requestedVolume);
+    CustomerRecordWire status;
+    pumpStatus->read(status);
+    TxnStatus txn_status = status.txnStatus();
+    return txn_status == TxnStatus::Approved || txn_status == TxnStatus::Done;
+}
 
-    data.nowTime = getTimestamp();
+/*
+ * Takes in the pump's latest dispense tick; true once the transaction is complete.
+ */
+bool
+Customer::receiveFuel()
+{
+    CustomerRecordWire snapshot;
+    pumpStatus->read(snapshot);
+    data.receivedVolume = snapshot.receivedVolume;
+    data.cost = snapshot.cost;
+    publish();
+
+    // The whole request is reserved before the first tick, so the pump either fills it exactly
+    // or, when the tank cannot cover it, publishes Done straight away with nothing dispensed.
+    return data.receivedVolume >= data.requestedVolume || snapshot.txnStatus() == TxnStatus::Done;
 }
 
 void
-Customer::writePipe(CustomerRecord* customer)
+Customer::writePipe(const CustomerRecord* customer)
 {
     assert(pumpId != -1);
     assert(pumps_[pumpId]->isBusy() == true);
@@ -116,19 +122,23 @@ Customer::writePipe(CustomerRecord* customer)
      * then it may not be necessary to mutex here. Verify the mutex is truly necessary later on.
      */
 
-    pipe[pumpId]->Write(customer);
+    CustomerRecordWire wire;
+    toWire(*customer, wire);
+    pipe[pumpId]->Write(&wire);
 }
 
 void
 Customer::returnGasHose()
 {
-    status = CustomerStatus::ReturnGasHose;
+    setStatus(CustomerStatus::ReturnGasHose);
+    // lets the pump move on to the next customer
+    pumps_[pumpId]->returnHose();
 }
 
 void
 Customer::driveAway()
 {
-    status = CustomerStatus::DriveAway;
+    setStatus(CustomerStatus::DriveAway);
 }
 
 string
@@ -170,12 +180,8 @@ Customer::getRandomName()
 }
 
 /*
- * The pipeline read and write cannot work properly if 
- * the string variable representing credit card number
- * is too long (more than exactly 15 digits). Four digits can ensure that bank card string
- * can be passed to other threads through CPipe properply and
- * can be assigned to the dereferenced data pool pointer without causing the memcpy exception.
- * However, the CDataPool cannot handle string variables in a deterministic way.
+ * The card number is sent to the pump as part of a CustomerRecordWire,
+ * which holds at most WIRE_CARD_SIZE - 1 characters.
  */
 string
 Customer::getRandomCreditCardNumber()
@@ -203,7 +209,7 @@ Customer::getRandomFuelGrade()
 {
     random_device rd;
     mt19937 rng(rd());
-    uniform_int_distribution<int> dist(0, NUM_TANKS - 1);
+    uniform_int_distribution<int> dist(0, sharedResources.getConfig().numTanks - 1);
 
     int randomValue = dist(rng);
     assert(randomValue >= 0 && randomValue <= 3);
@@ -219,17 +225,52 @@ Customer::getRandomFloat(float min, float max) {
     return round(dis(gen) * 1000) / 1000;  // Generate and return a random float
 }
 
-int
-Customer::main(void)
+void
+Customer::arrive()
+{
+    visit().start(pool_);
+}
+
+Task
+Customer::visit()
 {
-    arriveAtPump();
+    setStatus(CustomerStatus::WaitForPump);
+    arriveAtPump(co_await dispatcher_.acquire(pool_));
+
     swipeCreditCard();
     removeGasHose();
     selectFuelGrade();
-    getFuel();
+
+    /*
+     * Park until the pump publishes something new instead of polling its data pool.
+     * The generation is taken before the check so that a change published in between is not missed.
+     */
+    TaskNotifier& pump_changes = pumps_[pumpId]->getStatusNotifier();
+
+    setStatus(CustomerStatus::WaitForAuth);
+    while (true) {
+        uint32_t generation = pump_changes.current();
+        if (isApproved())
+            break;
+        co_await pump_changes.waitForChange(generation, pool_);
+    }
+
+    setStatus(CustomerStatus::GetFuel);
+    while (true) {
+        uint32_t generation = pump_changes.current();
+        if (receiveFuel())
+            break;
+        co_await pump_changes.waitForChange(generation, pool_);
+    }
+
+    data.nowTime = getTimestamp();
+    publish();
+
     returnGasHose();
     driveAway();
-    return 0;
+
+    // Another visit may start on this object as soon as it is back in the pool.
+    home_.recycle(*this);
 }
 
 string
@@ -255,14 +296,44 @@ Customer::customerStatusToString(const CustomerStatus& status) const
     return status_to_string.at(status);
 }
 
-CustomerRecord &
+CustomerRecord
 Customer::getData()
 {
-    return data;
+    lock_guard<mutex> lock(shownMutex);
+    return shown;
+}
+
+void
+Customer::setStatus(CustomerStatus new_status)
+{
+    status = new_status;
+    publish();
+}
+
+/*
+ * Copies the record and status for the display thread and wakes it. The visit changes `data`
+ * on whichever pool worker runs it, so the display only ever reads this copy.
+ */
+void
+Customer::publish()
+{
+    {
+        lock_guard<mutex> lock(shownMutex);
+        shown = data;
+        shownStatus = status;
+    }
+    changes.notify();
+}
+
+ChangeNotifier&
+Customer::getChangeNotifier()
+{
+    return changes;
 }
 
 string
 Customer::getStatusString()
 {
-    return customerStatusToString(status);
+    lock_guard<mutex> lock(shownMutex);
+    return customerStatusToString(shownStatus);
 }
\ No newline at end of file
@@ -1,12 +1,23 @@
 #ifndef __CUSTOMER_H__
 #define __CUSTOMER_H__
 
+#include <mutex>
 #include "rt.h"
 #include "common.h"
 #include "fuel_price.h"
 #include "pump.h"
-
-class Customer : public ActiveClass {
+#include "task.h"
+
+class CustomerPool;
+
+/*
+ * A customer's visit, from queueing for a pump to driving away, runs as a Task on the
+ * CommandProcessor's TaskPool rather than on a thread of its own. Waiting for a pump and
+ * for the pump's progress parks the task, so any number of customers can be on the
+ * forecourt at once without a stack each. When the visit is over the customer goes back to
+ * its CustomerPool to be reused.
+ */
+class Customer {
 private:
 	enum class CustomerStatus
 	{
@@ -24,50 +35,64 @@ private:
 
 	CustomerStatus status;
 
+	// notified whenever any customer's status or record changes, for the display thread
+	static ChangeNotifier changes;
+
 	int pumpId;
 
-	std::unique_ptr<CMutex> pumpEnquiryMutex;
+	PumpDispatcher& dispatcher_;
+
+	TaskPool& pool_;
+
+	CustomerPool& home_;
 
 	CustomerRecord data;
 
-	FuelPrice& fuelPrice_;
+	// what the display thread sees of `data` and `status`, as of the last publish()
+	std::mutex shownMutex;
+	CustomerRecord shown;
+	CustomerStatus shownStatus;
 
-	std::vector<std::shared_ptr<CEvent>> txnApprovedEvent;
+	FuelPrice& fuelPrice_;
 
 	std::vector<std::unique_ptr<Pump>>& pumps_;
 
-	std::vector<std::shared_ptr<CTypedPipe<CustomerRecord>>> pipe;
-
-	// to protect DOS window from being shared by multiple threads at the same time
-	std::shared_ptr<CMutex> windowMutex;
+	std::vector<std::shared_ptr<PumpPipe>> pipe;
 
-	// to protect data pointer pointing to the data in the pump data pool
-	std::shared_ptr<CReadersWritersMutex> pumpDpMutex;
+	// data pool of the pump this customer is using, read without locking
+	std::shared_ptr<PumpStatusSlot> pumpStatus;
 
 	std::string getRandomName();
 	std::string getRandomCreditCardNumber();
 	FuelGrade getRandomFuelGrade();
 	float getRandomFloat(float min, float max);
-	void writePipe(CustomerRecord* customer);
-	int getAvailPumpId();
-	
+	void writePipe(const CustomerRecord* customer);
 
-	void arriveAtPump();
+	void arriveAtPump(int pump_id);
 	void swipeCreditCard();
 	void removeGasHose();
 	void selectFuelGrade();
-	void getFuel();
+	bool isApproved();
+	bool receiveFuel();
 	void returnGasHose();
 	void driveAway();
 	std::string customerStatusToString(const CustomerStatus& status) const;
-	// To trigger the this function, the declaration must be exactly
-	// in this form, including the `void` keyword.
-	int main(void); 
+	void setStatus(CustomerStatus new_status);
+	void publish();
+	Task visit();
 
 public:
-	Customer(std::vector<std::unique_ptr<Pump>>& pumps, FuelPrice& fuelPrice);
-	CustomerRecord& getData();
+	Customer(std::vector<std::unique_ptr<Pump>>& pumps, FuelPrice& fuelPrice, PumpDispatcher& dispatcher, TaskPool& pool, CustomerPool& home);
+
+	// Gives the customer a new random identity for its next visit.
+	void renew();
+
+	// Sends the customer onto the forecourt; returns once the visit is queued on the pool.
+	void arrive();
+	// Copies of what was last published; safe to call from the display thread.
+	CustomerRecord getData();
 	std::string getStatusString();
+	static ChangeNotifier& getChangeNotifier();
 
 };
 
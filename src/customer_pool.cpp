@@ -0,0 +1,52 @@
+#include "customer_pool.h"
+
+using namespace std;
+
+CustomerPool::CustomerPool(vector<unique_ptr<Pump>>& pumps, FuelPrice& fuelPrice, PumpDispatcher& dispatcher, TaskPool& tasks)
+	: pumps_(pumps), fuelPrice_(fuelPrice), dispatcher_(dispatcher), tasks_(tasks), numCustomers(0), waitingToArrive(0)
+{
+	customers.reserve(MAX_NUM_CUSTOMERS);
+}
+
+void
+CustomerPool::generate(int n)
+{
+	vector<Customer*> arriving;
+	{
+		lock_guard<mutex> lock(poolMutex);
+		for (int i = 0; i < n; i++) {
+			if (!idle.empty()) {
+				arriving.push_back(idle.back());
+				idle.pop_back();
+			}
+			else if (customers.size() < MAX_NUM_CUSTOMERS) {
+				customers.emplace_back(make_unique<Customer>(pumps_, fuelPrice_, dispatcher_, tasks_, *this));
+				numCustomers.store(customers.size(), memory_order_release);
+				arriving.push_back(customers.back().get());
+			}
+			else {
+				waitingToArrive++;
+			}
+		}
+	}
+
+	for (Customer* customer : arriving)
+		customer->arrive();
+}
+
+void
+CustomerPool::recycle(Customer& customer)
+{
+	customer.renew();
+
+	{
+		lock_guard<mutex> lock(poolMutex);
+		if (waitingToArrive == 0) {
+			idle.push_back(&customer);
+			return;
+		}
+		waitingToArrive--;
+	}
+
+	customer.arrive();
+}
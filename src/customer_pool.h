@@ -0,0 +1,50 @@
+#ifndef __CUSTOMER_POOL_H__
+#define __CUSTOMER_POOL_H__
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "customer.h"
+#include "task.h"
+
+/*
+ * Owns the Customer objects and reuses them, so customers can be generated indefinitely
+ * while at most MAX_NUM_CUSTOMERS of them exist.
+ *
+ * A customer that drives away hands itself back through `recycle()`, which gives it a new
+ * random identity. It is then sent straight back onto the forecourt if a generated customer
+ * is still waiting for an object, or kept until the next `generate()`. New objects are only
+ * created while every existing one is on the forecourt.
+ *
+ * The objects never move or go away once created, so the display thread can read the first
+ * `size()` of them while others are being added.
+ */
+class CustomerPool
+{
+private:
+	std::vector<std::unique_ptr<Pump>>& pumps_;
+	FuelPrice& fuelPrice_;
+	PumpDispatcher& dispatcher_;
+	TaskPool& tasks_;
+
+	std::mutex poolMutex;
+	std::vector<std::unique_ptr<Customer>> customers;		// reserved up front, never reallocated
+	std::atomic<size_t> numCustomers;
+	std::vector<Customer*> idle;
+	uint64_t waitingToArrive;								// generated, but every object was in use
+
+public:
+	CustomerPool(std::vector<std::unique_ptr<Pump>>& pumps, FuelPrice& fuelPrice, PumpDispatcher& dispatcher, TaskPool& tasks);
+
+	// Sends `n` new customers onto the forecourt, or as many as there are objects for and the rest later.
+	void generate(int n);
+
+	// Called by a customer that has driven away; must be the last thing its visit does.
+	void recycle(Customer& customer);
+
+	size_t size() const { return numCustomers.load(std::memory_order_acquire); }
+	Customer& at(size_t i) { return *customers[i]; }
+};
+
+#endif // __CUSTOMER_POOL_H__
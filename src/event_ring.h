@@ -0,0 +1,101 @@
+#ifndef __EVENT_RING_H__
+#define __EVENT_RING_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "seqlock.h"
+
+/*
+ * The last N events published by one writer, for any number of readers that each keep their
+ * own place in it.
+ *
+ * Every event is numbered; the first one published is 1. The writer never waits: the event
+ * numbered s goes into slot s % N whether or not every reader has got past the one it
+ * replaces. Each slot is a SeqLock holding the event together with its number, so a reader
+ * can tell an event it wanted from a newer one written over it. A reader that has fallen more
+ * than N events behind finds out from `read` that it has missed some, and has to catch up
+ * some other way, e.g. from a snapshot of the writer's state, before carrying on from
+ * `getPublished() + 1`.
+ *
+ * Like SeqLock, the ring lives in a CDataPool, so all-zero bytes are an empty ring.
+ *
+ * Only one thread may call `push()` at a time.
+ */
+template <class T, uint32_t N>
+class EventRing
+{
+	static_assert(N > 0 && (N & (N - 1)) == 0, "The ring size must be a power of two");
+
+private:
+	struct Entry
+	{
+		uint64_t sequence;
+		T value;
+	};
+
+	std::atomic<uint64_t> published;	// number of the newest event, 0 before the first
+	SeqLock<Entry> slots[N];
+
+public:
+	static const uint32_t SIZE = N;
+
+	// Publishes `value` and returns its number. Must only be called by the single writer.
+	uint64_t push(const T& value)
+	{
+		Entry entry;
+		entry.sequence = published.load(std::memory_order_relaxed) + 1;
+		entry.value = value;
+		slots[entry.sequence % N].write(entry);
+		published.store(entry.sequence, std::memory_order_release);
+		return entry.sequence;
+	}
+
+	uint64_t getPublished() const { return published.load(std::memory_order_acquire); }
+
+	// Copies the newest event into `value` and returns its number, or returns 0 if there is none yet.
+	uint64_t readLatest(T& value) const
+	{
+		while (true) {
+			const uint64_t head = getPublished();
+			if (head == 0)
+				return 0;
+			Entry entry;
+			if (slots[head % N].tryRead(entry) && entry.sequence == head) {
+				value = entry.value;
+				return head;
+			}
+			// the writer has lapped the ring while it was being read; look again
+		}
+	}
+
+	/*
+	 * Copies up to `max` events, starting with the one numbered `next`, into `out` and moves
+	 * `next` past them. Returns how many were copied. `overrun` is set if the event numbered
+	 * `next` has already been written over; the events before it have still been copied.
+	 */
+	size_t read(uint64_t& next, T* out, size_t max, bool& overrun) const
+	{
+		const uint64_t head = getPublished();
+		size_t count = 0;
+
+		overrun = false;
+		while (count < max && next <= head) {
+			if (head - next >= N) {
+				overrun = true;
+				break;
+			}
+			// A slot the writer is busy in is being given a newer event than `next`.
+			Entry entry;
+			if (!slots[next % N].tryRead(entry) || entry.sequence != next) {
+				overrun = true;
+				break;
+			}
+			out[count++] = entry.value;
+			next++;
+		}
+		return count;
+	}
+};
+
+#endif // __EVENT_RING_H__
@@ -0,0 +1,270 @@
+#include "forecourt_sim.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include "common.h"
+
+using namespace std;
+
+int64_t
+ForecourtStats::waitPercentile(double fraction) const
+{
+	uint64_t waited = 0;
+	for (uint64_t count : waitHistogram)
+		waited += count;
+
+	uint64_t wanted = static_cast<uint64_t>(ceil(fraction * waited));
+	uint64_t seen = 0;
+	for (size_t s = 0; s < waitHistogram.size(); s++) {
+		seen += waitHistogram[s];
+		if (seen >= wanted && seen > 0)
+			return static_cast<int64_t>(s);
+	}
+	return 0;
+}
+
+ForecourtSim::ForecourtSim(const ForecourtConfig& cfg) :
+	config(cfg),
+	rng(cfg.seed),
+	interArrival(cfg.arrivalsPerHour / 3600000.0),
+	authDelay(cfg.meanAuthMs > 0 ? 1.0 / cfg.meanAuthMs : 1.0),
+	gradeDist(0, (cfg.numTanks > 0 ? cfg.numTanks : MAX_TANKS) - 1),
+	volumeDist(static_cast<float>(MIN_LITERS), static_cast<float>(MAX_LITERS)),
+	nextSeq(0),
+	nowMs(0),
+	endMs(static_cast<int64_t>(cfg.hours * 3600000.0))
+{
+	if (config.numPumps <= 0)
+		config.numPumps = DEFAULT_NUM_PUMPS;
+	if (config.numTanks <= 0)
+		config.numTanks = MAX_TANKS;
+
+	pumps.resize(config.numPumps);
+	tanks.assign(config.numTanks, TankState{ DEFAULT_TANK_CAPACITY });
+
+	stats.pumpBusyMs.assign(config.numPumps, 0);
+	stats.pumpCustomers.assign(config.numPumps, 0);
+	stats.tanks.resize(config.numTanks);
+}
+
+void
+ForecourtSim::schedule(int64_t time_ms, EventType type, int32_t index)
+{
+	events.push(Event{ time_ms, nextSeq++, type, index });
+}
+
+void
+ForecourtSim::run()
+{
+	auto wallStart = chrono::steady_clock::now();
+
+	if (config.arrivalsPerHour > 0)
+		schedule(static_cast<int64_t>(interArrival(rng)), EventType::Arrival, -1);
+
+	while (!events.empty() && events.top().timeMs <= endMs) {
+		Event event = events.top();
+		events.pop();
+		nowMs = event.timeMs;
+		stats.events++;
+
+		switch (event.type) {
+		case EventType::Arrival:
+			arrive();
+			break;
+		case EventType::StartDispensing:
+			startDispensing(event.index);
+			break;
+		case EventType::LeavePump:
+			leavePump(event.index);
+			break;
+		case EventType::DeliveryArrives:
+			deliveryArrives(event.index);
+			break;
+		case EventType::RefillDone:
+			refillDone(event.index);
+			break;
+		}
+	}
+
+	// Close the intervals that are still open when the scenario ends.
+	nowMs = endMs;
+	for (int i = 0; i < config.numPumps; i++) {
+		if (pumps[i].busy)
+			stats.pumpBusyMs[i] += endMs - pumps[i].busySinceMs;
+	}
+	for (int i = 0; i < config.numTanks; i++) {
+		if (tanks[i].lowSinceMs >= 0)
+			stats.tanks[i].lowMs += endMs - tanks[i].lowSinceMs;
+	}
+
+	stats.simulatedMs = endMs;
+	stats.wallSeconds = chrono::duration<double>(chrono::steady_clock::now() - wallStart).count();
+}
+
+void
+ForecourtSim::arrive()
+{
+	stats.arrived++;
+	if (config.maxCustomers == 0 || stats.arrived < config.maxCustomers)
+		schedule(nowMs + static_cast<int64_t>(interArrival(rng)), EventType::Arrival, -1);
+
+	Visit visit{ nowMs, gradeDist(rng), volumeDist(rng) };
+
+	// PumpDispatcher::acquire: the first free pump, else the end of the queue
+	for (int i = 0; i < config.numPumps; i++) {
+		if (!pumps[i].busy) {
+			seat(i, visit);
+			return;
+		}
+	}
+	waiting.push_back(visit);
+}
+
+void
+ForecourtSim::seat(int pump_id, const Visit& visit)
+{
+	PumpState& pump = pumps[pump_id];
+	pump.busy = true;
+	pump.visit = visit;
+	pump.dispensed = 0.0f;
+	pump.busySinceMs = nowMs;
+
+	int64_t waitMs = nowMs - visit.arrivalMs;
+	size_t bucket = static_cast<size_t>(waitMs / 1000);
+	if (bucket >= stats.waitHistogram.size())
+		stats.waitHistogram.resize(bucket + 1, 0);
+	stats.waitHistogram[bucket]++;
+	stats.totalWaitMs += static_cast<double>(waitMs);
+	stats.maxWaitMs = max(stats.maxWaitMs, waitMs);
+	stats.pumpCustomers[pump_id]++;
+
+	// swipe the card, remove the hose, select the grade, then wait for the attendant
+	int64_t authMs = config.meanAuthMs > 0 ? static_cast<int64_t>(authDelay(rng)) : 0;
+	schedule(nowMs + config.handlingMs / 2 + authMs, EventType::StartDispensing, pump_id);
+}
+
+void
+ForecourtSim::startDispensing(int pump_id)
+{
+	PumpState& pump = pumps[pump_id];
+	TankState& tank = tanks[pump.visit.grade];
+	int64_t leaveMs = nowMs + (config.handlingMs - config.handlingMs / 2);
+
+	// FuelTank::reserve: only a tank that cannot cover the whole request turns the customer away
+	if (tank.volume < pump.visit.requestedVolume) {
+		stats.tanks[pump.visit.grade].stockOuts++;
+		schedule(leaveMs, EventType::LeavePump, pump_id);
+		return;
+	}
+
+	// Pump::getFuel dispenses exactly the request, DEFAULT_FLOW_RATE a tick with a partial last tick.
+	int ticks = static_cast<int>(ceil(pump.visit.requestedVolume / DEFAULT_FLOW_RATE));
+	pump.dispensed = pump.visit.requestedVolume;
+
+	tank.volume -= pump.dispensed;
+	tank.reserved += pump.dispensed;
+	stats.tanks[pump.visit.grade].litresSold += pump.dispensed;
+	stats.served++;
+	checkLowLevel(pump.visit.grade);
+
+	schedule(leaveMs + static_cast<int64_t>(ticks) * FLOW_TICK_MS, EventType::LeavePump, pump_id);
+}
+
+void
+ForecourtSim::leavePump(int pump_id)
+{
+	PumpState& pump = pumps[pump_id];
+	tanks[pump.visit.grade].reserved -= pump.dispensed;
+	stats.pumpBusyMs[pump_id] += nowMs - pump.busySinceMs;
+	pump.busy = false;
+
+	// PumpDispatcher::release: the head of the queue
+	if (!waiting.empty()) {
+		Visit next = waiting.front();
+		waiting.pop_front();
+		seat(pump_id, next);
+	}
+}
+
+void
+ForecourtSim::checkLowLevel(int tank_id)
+{
+	TankState& tank = tanks[tank_id];
+	if (tank.volume >= LOW_FUEL_VOLUME)
+		return;
+
+	if (tank.lowSinceMs < 0)
+		tank.lowSinceMs = nowMs;
+	if (!tank.deliveryOrdered) {
+		tank.deliveryOrdered = true;
+		schedule(nowMs + config.deliveryDelayMs, EventType::DeliveryArrives, tank_id);
+	}
+}
+
+void
+ForecourtSim::deliveryArrives(int tank_id)
+{
+	TankState& tank = tanks[tank_id];
+	stats.tanks[tank_id].deliveries++;
+
+	// the attendant refills at DEFAULT_FLOW_RATE per tick, up to what fits next to the fuel still being dispensed
+	float space = DEFAULT_TANK_CAPACITY - tank.reserved - tank.volume;
+	int64_t ticks = static_cast<int64_t>(ceil(max(space, 0.0f) / DEFAULT_FLOW_RATE));
+	schedule(nowMs + ticks * FLOW_TICK_MS, EventType::RefillDone, tank_id);
+}
+
+void
+ForecourtSim::refillDone(int tank_id)
+{
+	TankState& tank = tanks[tank_id];
+	tank.volume = DEFAULT_TANK_CAPACITY - tank.reserved;
+	tank.deliveryOrdered = false;
+
+	if (tank.lowSinceMs >= 0) {
+		stats.tanks[tank_id].lowMs += nowMs - tank.lowSinceMs;
+		tank.lowSinceMs = -1;
+	}
+}
+
+void
+ForecourtSim::printReport(ostream& out) const
+{
+	uint64_t stockOuts = 0;
+	for (const TankStats& tank : stats.tanks)
+		stockOuts += tank.stockOuts;
+	uint64_t seated = 0;
+	for (uint64_t count : stats.pumpCustomers)
+		seated += count;
+
+	out << fixed << setprecision(1);
+	out << "Simulated " << stats.simulatedMs / 3600000.0 << " h with seed " << config.seed << ", "
+		<< config.numPumps << " pumps, " << config.arrivalsPerHour << " arrivals/h" << endl;
+	out << "Customers: " << stats.arrived << " arrived, " << stats.served << " fuelled, "
+		<< stockOuts << " turned away by a stock-out, "
+		<< stats.arrived - stats.served - stockOuts << " still on the forecourt at the end" << endl;
+
+	out << "Queue wait (s): mean " << (seated ? stats.totalWaitMs / seated / 1000.0 : 0.0)
+		<< ", p50 " << stats.waitPercentile(0.50) << ", p95 " << stats.waitPercentile(0.95)
+		<< ", p99 " << stats.waitPercentile(0.99) << ", max " << stats.maxWaitMs / 1000.0 << endl;
+
+	out << endl << left << setw(8) << "Pump" << setw(12) << "Customers" << "Utilisation" << endl;
+	for (int i = 0; i < config.numPumps; i++) {
+		out << setw(8) << i << setw(12) << stats.pumpCustomers[i]
+			<< (stats.simulatedMs ? 100.0 * stats.pumpBusyMs[i] / stats.simulatedMs : 0.0) << " %" << endl;
+	}
+
+	out << endl << setw(8) << "Tank" << setw(12) << "Sold (L)" << setw(12) << "Stock-outs"
+		<< setw(12) << "Deliveries" << "Below " << LOW_FUEL_VOLUME << " L" << endl;
+	for (int i = 0; i < config.numTanks; i++) {
+		const TankStats& tank = stats.tanks[i];
+		out << setw(8) << i << setw(12) << tank.litresSold << setw(12) << tank.stockOuts
+			<< setw(12) << tank.deliveries
+			<< (stats.simulatedMs ? 100.0 * tank.lowMs / stats.simulatedMs : 0.0) << " % of the time" << endl;
+	}
+
+	out << endl << "Run time " << setprecision(3) << stats.wallSeconds << " s: " << stats.events << " events, "
+		<< setprecision(0) << (stats.wallSeconds > 0 ? stats.arrived / stats.wallSeconds : 0.0)
+		<< " customers/s" << endl;
+	out << right << defaultfloat;
+}
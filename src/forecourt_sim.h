@@ -0,0 +1,172 @@
+#ifndef __FORECOURT_SIM_H__
+#define __FORECOURT_SIM_H__
+
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <queue>
+#include <random>
+#include <vector>
+
+/*
+ * Discrete-event model of the forecourt, for capacity studies over whole days.
+ *
+ * PumpFacility runs every customer as a task on a thread pool and moves through real (or
+ * SimClock) time, which makes a run nondeterministic and bounds it by MAX_NUM_CUSTOMERS.
+ * ForecourtSim runs the same life cycle on one thread as a sequence of events on a
+ * priority queue, ordered by simulated time, with every random choice drawn from a single
+ * seeded generator, so a run is reproducible from its seed and costs microseconds per
+ * customer regardless of how much simulated time it covers.
+ *
+ * The model follows the real processes:
+ *
+ *   arrival            the customer takes a free pump, else joins the end of the queue
+ *                      (PumpDispatcher::acquire)
+ *   at the pump        swiping the card, lifting the hose and selecting the grade, then
+ *                      waiting for the attendant to authorise the transaction
+ *   dispensing         only if the grade's tank holds the requested volume (FuelTank::reserve),
+ *                      exactly the requested volume, DEFAULT_FLOW_RATE a FLOW_TICK_MS tick
+ *                      and whatever is left in the last one (Pump::getFuel);
+ *                      otherwise the customer drives away without fuel (a stock-out). The
+ *                      volume is taken from the tank when dispensing starts, so two pumps
+ *                      never both count on the same fuel
+ *   leaving            returning the hose and driving off, then the pump goes to the head of
+ *                      the queue (PumpDispatcher::release)
+ *
+ * A tank that drops below LOW_FUEL_VOLUME orders a delivery; the tanker arrives
+ * deliveryDelayMs later and refills the tank at DEFAULT_FLOW_RATE per tick, as the attendant does.
+ */
+struct ForecourtConfig
+{
+	uint64_t seed = 1;
+	double hours = 24.0;				// simulated time to run for
+	uint64_t maxCustomers = 0;			// stop generating arrivals after this many (0: no limit)
+	double arrivalsPerHour = 60.0;		// mean rate of the Poisson arrival process
+	int numPumps = 0;					// 0: DEFAULT_NUM_PUMPS
+	int numTanks = 0;					// 0: MAX_TANKS
+	uint32_t handlingMs = 60000;		// card, hose, grade, returning the hose and driving off
+	uint32_t meanAuthMs = 10000;		// mean (exponential) time for the attendant to approve
+	uint32_t deliveryDelayMs = 30 * 60 * 1000;	// from ordering fuel to the tanker arriving
+};
+
+struct TankStats
+{
+	double litresSold = 0.0;
+	uint64_t stockOuts = 0;				// customers sent away because the tank could not serve them
+	uint64_t deliveries = 0;
+	int64_t lowMs = 0;					// simulated time spent below LOW_FUEL_VOLUME
+};
+
+struct ForecourtStats
+{
+	uint64_t arrived = 0;
+	uint64_t served = 0;
+	uint64_t events = 0;
+	int64_t simulatedMs = 0;
+	double wallSeconds = 0.0;
+
+	// time from arriving to reaching a pump, in whole seconds: waitHistogram[s] customers waited s seconds
+	std::vector<uint64_t> waitHistogram;
+	double totalWaitMs = 0.0;
+	int64_t maxWaitMs = 0;
+
+	std::vector<int64_t> pumpBusyMs;
+	std::vector<uint64_t> pumpCustomers;
+	std::vector<TankStats> tanks;
+
+	// the smallest wait, in seconds, that at least `fraction` of the customers did not exceed
+	int64_t waitPercentile(double fraction) const;
+};
+
+class ForecourtSim
+{
+private:
+	enum class EventType : uint8_t
+	{
+		Arrival,
+		StartDispensing,		// the attendant has authorised the transaction
+		LeavePump,
+		DeliveryArrives,
+		RefillDone
+	};
+
+	struct Event
+	{
+		int64_t timeMs;
+		uint64_t seq;			// breaks ties in scheduling order, so runs are deterministic
+		EventType type;
+		int32_t index;			// pump or tank
+	};
+
+	struct LaterEvent
+	{
+		bool operator()(const Event& a, const Event& b) const
+		{
+			return a.timeMs != b.timeMs ? a.timeMs > b.timeMs : a.seq > b.seq;
+		}
+	};
+
+	struct Visit
+	{
+		int64_t arrivalMs;
+		int grade;
+		float requestedVolume;
+	};
+
+	struct PumpState
+	{
+		bool busy = false;
+		Visit visit;
+		float dispensed = 0.0f;
+		int64_t busySinceMs = 0;
+	};
+
+	struct TankState
+	{
+		float volume;
+		float reserved = 0.0f;			// promised to transactions that are still dispensing
+		bool deliveryOrdered = false;
+		int64_t lowSinceMs = -1;
+	};
+
+	ForecourtConfig config;
+	ForecourtStats stats;
+
+	std::mt19937_64 rng;
+	std::exponential_distribution<double> interArrival;
+	std::exponential_distribution<double> authDelay;
+	std::uniform_int_distribution<int> gradeDist;
+	std::uniform_real_distribution<float> volumeDist;
+
+	std::priority_queue<Event, std::vector<Event>, LaterEvent> events;
+	uint64_t nextSeq;
+	int64_t nowMs;
+	int64_t endMs;
+
+	std::vector<PumpState> pumps;
+	std::deque<Visit> waiting;			// the forecourt's one queue, in arrival order
+	std::vector<TankState> tanks;
+
+	void schedule(int64_t time_ms, EventType type, int32_t index);
+
+	void arrive();
+	void seat(int pump_id, const Visit& visit);
+	void startDispensing(int pump_id);
+	void leavePump(int pump_id);
+	void deliveryArrives(int tank_id);
+	void refillDone(int tank_id);
+
+	void checkLowLevel(int tank_id);
+
+public:
+	explicit ForecourtSim(const ForecourtConfig& cfg);
+
+	// Runs the whole scenario; the results are in getStats().
+	void run();
+
+	const ForecourtStats& getStats() const { return stats; }
+
+	void printReport(std::ostream& out) const;
+};
+
+#endif // __FORECOURT_SIM_H__
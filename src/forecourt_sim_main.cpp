@@ -0,0 +1,64 @@
+/*
+ * ForecourtSim: runs a forecourt scenario through the discrete-event model in forecourt_sim.h
+ * and prints queue waits, pump utilisation and tank stock-outs.
+ *
+ *   ForecourtSim [--seed=N] [--hours=H] [--rate=ARRIVALS_PER_HOUR] [--customers=N]
+ *                [--pumps=N] [--tanks=N] [--handling=S] [--auth=S] [--delivery=MIN]
+ */
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include "forecourt_sim.h"
+
+using namespace std;
+
+// If `arg` is `prefix` followed by a number, stores the number in `value`.
+static bool
+parseOption(const char* arg, const char* prefix, double& value)
+{
+	size_t length = strlen(prefix);
+	if (strncmp(arg, prefix, length) != 0)
+		return false;
+
+	char* end = nullptr;
+	value = strtod(arg + length, &end);
+	return end != arg + length && *end == '\0' && value >= 0;
+}
+
+int
+main(int argc, char* argv[])
+{
+	ForecourtConfig config;
+
+	for (int i = 1; i < argc; i++) {
+		double value;
+		if (parseOption(argv[i], "--seed=", value))
+			config.seed = static_cast<uint64_t>(value);
+		else if (parseOption(argv[i], "--hours=", value))
+			config.hours = value;
+		else if (parseOption(argv[i], "--rate=", value))
+			config.arrivalsPerHour = value;
+		else if (parseOption(argv[i], "--customers=", value))
+			config.maxCustomers = static_cast<uint64_t>(value);
+		else if (parseOption(argv[i], "--pumps=", value) && value >= 1)
+			config.numPumps = static_cast<int>(value);
+		else if (parseOption(argv[i], "--tanks=", value) && value >= 1)
+			config.numTanks = static_cast<int>(value);
+		else if (parseOption(argv[i], "--handling=", value))
+			config.handlingMs = static_cast<uint32_t>(value * 1000);
+		else if (parseOption(argv[i], "--auth=", value))
+			config.meanAuthMs = static_cast<uint32_t>(value * 1000);
+		else if (parseOption(argv[i], "--delivery=", value))
+			config.deliveryDelayMs = static_cast<uint32_t>(value * 60000);
+		else {
+			cout << "Usage: " << argv[0] << " [--seed=N] [--hours=H] [--rate=ARRIVALS_PER_HOUR] [--customers=N]" << endl
+				<< "       [--pumps=N] [--tanks=N] [--handling=SECONDS] [--auth=SECONDS] [--delivery=MINUTES]" << endl;
+			return 1;
+		}
+	}
+
+	ForecourtSim sim(config);
+	sim.run();
+	sim.printReport(cout);
+	return 0;
+}
@@ -2,43 +2,56 @@
 
 using namespace std;
 
-optional<float>
-FuelPrice::findFuelPrice(FuelGrade grade)
+FuelPrice::FuelPrice()
+	: prices(sharedResources.getFuelPrices())
 {
-	if (fuelData.find(grade) != fuelData.end()) {
-		return fuelData[grade]; // Error occurs here if `const` is used for this function
-	}
-	else {
-		// Return nullopt when no value is found for the grade
-		return nullopt;
-	}
+	if (prices->read().version != 0)
+		return;
+
+	FuelPriceTable table = {};
+	table.version = 1;
+	table.unitCost[fuelGradeToInt(FuelGrade::Oct87)] = 4.1f;
+	table.unitCost[fuelGradeToInt(FuelGrade::Oct89)] = 4.6f;
+	table.unitCost[fuelGradeToInt(FuelGrade::Oct91)] = 4.9f;
+	table.unitCost[fuelGradeToInt(FuelGrade::Oct94)] = 5.2f;
+	prices->write(table);
+	for (int i = 0; i < sharedResources.getConfig().numTanks; i++)
+		sharedResources.getTankChanges()->publish(i);
 }
 
 void
 FuelPrice::setFuelPrice(FuelGrade grade, float price)
 {
-	if (fuelData.find(grade) != fuelData.end()) {
-		fuelData[grade] = price;
-	}
-	else {
+	int index = fuelGradeToInt(grade);
+	if (index < 0) {
 		// throw an exception of type invalid_argument with the message "Invalid FuelGrade".
 		throw invalid_argument("Invalid FuelGrade");
 	}
+
+	{
+		lock_guard<mutex> lock(writeMutex);
+		FuelPriceTable table = prices->read();
+		table.unitCost[index] = price;
+		table.version++;
+		prices->write(table);
+	}
+	// the Computer shows each tank's price next to its level
+	sharedResources.getTankChanges()->publish(index);
+}
+
+FuelPriceTable
+FuelPrice::snapshot() const
+{
+	return prices->read();
 }
 
 float
 FuelPrice::getTotalCost(float volume, FuelGrade grade)
 {
 	float cost = 0;
-	auto fuel_price = findFuelPrice(grade);
-	if (fuel_price.has_value()) {
-		if (*fuel_price > 0 && volume > 0) {
-			// Access the value inside the optional using the * operator
-			cost = *fuel_price * volume;
-		}
-	}
-	else {
-		cerr << "Error: Cannot find the price info on the fuel grade " << fuelGradeToString(grade) << endl;
+	float unit_cost = getUnitCost(grade);
+	if (unit_cost > 0 && volume > 0) {
+		cost = unit_cost * volume;
 	}
 	return cost;
 }
@@ -46,12 +59,9 @@ FuelPrice::getTotalCost(float volume, FuelGrade grade)
 float
 FuelPrice::getUnitCost(FuelGrade grade)
 {
-	optional<float> unit_cost = findFuelPrice(grade);
-	if (unit_cost) {
-		return  *unit_cost;
-	}
-	else {
+	if (fuelGradeToInt(grade) < 0) {
 		cout << "No valid unit price found for the given fuel grade." << endl;
+		return 0.0f;
 	}
-	return 0.0f;
-}
\ No newline at end of file
+	return snapshot().unitCostOf(grade);
+}
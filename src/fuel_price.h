@@ -2,33 +2,34 @@
 #define __FUEL_PRICE_H__
 
 #include "common.h"
-#include <unordered_map>
+#include <memory>
+#include <mutex>
 
+/*
+ * The station's fuel prices, kept in the shared FuelPriceTable so that a `cp` typed at the
+ * PumpFacility is seen by every process. Anyone may read the prices without locking; only
+ * the PumpFacility changes them.
+ */
 class FuelPrice
 {
 private:
-	// Unordered map to hold FuelGrade -> float mappings
-	std::unordered_map<FuelGrade, float> fuelData;
-	// Function to get the float value associated with a FuelGrade
-	std::optional<float> findFuelPrice(FuelGrade grade);
+	std::shared_ptr<SeqLock<FuelPriceTable>> prices;
+	// the SeqLock allows one writer at a time, and a change is a read-modify-write of the table
+	std::mutex writeMutex;
 
 public:
-	FuelPrice()
-	{
-		// Initialize all FuelGrade values with some default float value
-		fuelData[FuelGrade::Oct87] = 4.1f;
-		fuelData[FuelGrade::Oct89] = 4.6f;
-		fuelData[FuelGrade::Oct91] = 4.9f;
-		fuelData[FuelGrade::Oct94] = 5.2f;
-		fuelData[FuelGrade::Invalid] = 0.0f;
-	}
+	// Publishes the default prices unless another run of the PumpFacility has already published some.
+	FuelPrice();
 
 	// Function to set the float value associated with a FuelGrade
 	void setFuelPrice(FuelGrade grade, float price);
 
+	// All the prices from one version of the table.
+	FuelPriceTable snapshot() const;
+
 	float getTotalCost(float volume, FuelGrade grade);
 
 	float getUnitCost(FuelGrade grade);
 };
 
-#endif // __FUEL_PRICE_H__
\ No newline at end of file
+#endif // __FUEL_PRICE_H__
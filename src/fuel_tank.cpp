@@ -3,10 +3,9 @@
 
 using namespace std;
 
-FuelTank::FuelTank(int id) : id_(id)
+FuelTank::FuelTank(int id) : id_(id), flowRateMl(sharedResources.getConfig().flowRateMl())
 {
-	windowMutex = sharedResources.getPumpWindowMutex();
-	mutex = sharedResources.getTankDpMutex(id_);
+	changes = sharedResources.getTankChanges();
 	/**
 	 * data.reset(static_cast<TankData*>(dataPool->LinkDataPool()));
 	 * The reset() function releases the currently managed pointer (if any) and takes
@@ -15,66 +14,52 @@ FuelTank::FuelTank(int id) : id_(id)
 	 */
 	data = sharedResources.getTankDpDataPtr(id_);
 
-	data->remainingVolume = TANK_CAPACITY; // All tanks are initially full.
+	// All tanks are initially full.
+	data->capacityMl = sharedResources.getConfig().tankCapacityMl();
+	data->remainingMl.store(data->capacityMl);
+	data->availableMl.store(data->capacityMl);
 	data->fuelGrade = intToFuelGrade(id_);
 	fuelGrade = intToFuelGrade(id_);
+	changes->publish(id_);
 }
 
 float
 FuelTank::readVolume() const
 {
-	mutex->Wait();
-	float remaining_fuel = data->remainingVolume;
-	mutex->Signal();
-	return remaining_fuel;
-}
-
-bool
-FuelTank::checkRemainingVolume()
-{
-	bool enough_fuel = false;
-	if (this->readVolume() >= FLOW_RATE)
-		enough_fuel = true;
-	else
-		cout << "No enough fuel in the tank." << endl;
-	return enough_fuel;
+	return data->remainingLitres();
 }
 
 void
 FuelTank::refillTank()
 {
-	while (increment()) {
-		cout << "Refilling ..." << endl;
-	};
-	cout << "Tank " << id_ << " has been refilled." << endl;
+	// The Computer's tank bar shows the refill; nothing here may write the console past the ScreenRenderer.
+	while (increment())
+		;
 }
 
 bool
 FuelTank::increment()
 {
-	bool keep_filling = false;
-	mutex->Wait();
-	if (data->remainingVolume + FLOW_RATE <= TANK_CAPACITY) {
-		keep_filling = true;
-		data->remainingVolume += FLOW_RATE;
-	}
-	mutex->Signal();
-	SLEEP(1000);
+	int32_t added = data->fill(flowRateMl);
+	if (added > 0)
+		changes->publish(id_);
+	bool keep_filling = added == flowRateMl;
+	SimClock::get().sleep(FLOW_TICK_MS);
 	return keep_filling;
 }
 
 bool
-FuelTank::decrement()
+FuelTank::reserve(int32_t ml)
+{
+	return data->reserve(ml);
+}
+
+void
+FuelTank::dispense(int32_t ml)
 {
-	bool keep_dispensing = false;
-	mutex->Wait();
-	if (data->remainingVolume - FLOW_RATE >= 0) {
-		keep_dispensing = true;
-		data->remainingVolume = data->remainingVolume - FLOW_RATE;
-	}
-	mutex->Signal();
-	SLEEP(1000);
-	return keep_dispensing;
+	data->drain(ml);
+	changes->publish(id_);
+	SimClock::get().sleep(FLOW_TICK_MS);
 }
 
 FuelGrade
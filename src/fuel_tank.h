@@ -19,11 +19,11 @@ class FuelTank
 {
 private:
 	std::shared_ptr<TankData> data;
-	std::shared_ptr<CMutex> mutex;
-	std::shared_ptr<CMutex> windowMutex;
+	std::shared_ptr<TankChanges> changes;
 
 	int id_;
 	FuelGrade fuelGrade;
+	int32_t flowRateMl;
 
 
 public:
@@ -31,9 +31,12 @@ public:
 	float readVolume() const;
 
 	void refillTank();
-	bool checkRemainingVolume();
 	bool increment();
-	bool decrement();
+
+	// Sets `ml` aside for one customer; false if the tank cannot cover all of it.
+	bool reserve(int32_t ml);
+	// Dispenses `ml` of a reservation, which takes a flow tick.
+	void dispense(int32_t ml);
 	FuelGrade getFuelGrade();
 };
 #endif // !__FUEL_TANK_H__
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "futex.h"
+#include <chrono>
+
+#ifdef _WIN32
+#pragma comment(lib, "Synchronization.lib")
+#else
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <ctime>
+#endif
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex words must be plain 32-bit integers");
+
+#ifdef _WIN32
+
+void
+futexWait(std::atomic<uint32_t>* word, uint32_t expected, DWORD timeout)
+{
+	DWORD slice = (timeout < FUTEX_POLL_SLICE) ? timeout : FUTEX_POLL_SLICE;
+	WaitOnAddress(reinterpret_cast<volatile VOID*>(word), &expected, sizeof(expected), slice);
+}
+
+void
+futexWakeOne(std::atomic<uint32_t>* word)
+{
+	WakeByAddressSingle(reinterpret_cast<PVOID>(word));
+}
+
+void
+futexWakeAll(std::atomic<uint32_t>* word)
+{
+	WakeByAddressAll(reinterpret_cast<PVOID>(word));
+}
+
+#else
+
+void
+futexWait(std::atomic<uint32_t>* word, uint32_t expected, DWORD timeout)
+{
+	struct timespec ts;
+	struct timespec* pts = NULL;
+
+	if (timeout != INFINITE) {
+		ts.tv_sec = timeout / 1000;
+		ts.tv_nsec = (timeout % 1000) * 1000000L;
+		pts = &ts;
+	}
+	// EAGAIN (the word already changed), EINTR and ETIMEDOUT all simply return to the caller.
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, pts, NULL, 0);
+}
+
+void
+futexWakeOne(std::atomic<uint32_t>* word)
+{
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+void
+futexWakeAll(std::atomic<uint32_t>* word)
+{
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+#endif
+
+void
+ChangeNotifier::notify()
+{
+	generation.fetch_add(1, std::memory_order_seq_cst);
+	if (waiters.load(std::memory_order_seq_cst) != 0)
+		futexWakeAll(&generation);
+}
+
+uint32_t
+ChangeNotifier::waitForChange(uint32_t seen, DWORD timeout)
+{
+	uint32_t now = generation.load(std::memory_order_acquire);
+	if (now != seen)
+		return now;
+
+	// Registering before the final check pairs with notify() bumping the generation before it looks for waiters.
+	waiters.fetch_add(1, std::memory_order_seq_cst);
+	auto start = std::chrono::steady_clock::now();
+	while ((now = generation.load(std::memory_order_seq_cst)) == seen) {
+		DWORD remaining = INFINITE;
+		if (timeout != INFINITE) {
+			auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+			if (elapsed >= (long long)timeout)
+				break;
+			remaining = (DWORD)(timeout - elapsed);
+		}
+		futexWait(&generation, seen, remaining);
+	}
+	waiters.fetch_sub(1, std::memory_order_relaxed);
+	return now;
+}
@@ -0,0 +1,56 @@
+#ifndef __FUTEX_H__
+#define __FUTEX_H__
+
+#include <atomic>
+#include <cstdint>
+#include "rt.h"
+
+/*
+ * Block the calling thread while `*word == expected`, without holding any lock.
+ * This is the building block for the lock-free structures that live in data pools: a
+ * thread only sleeps in the kernel when there is genuinely nothing to do, and the
+ * thread that changes the word wakes it up with `futexWakeOne` or `futexWakeAll`.
+ *
+ * On Linux this is a (non-private) futex, so it also works between processes on a
+ * word inside a data pool. On Windows it is `WaitOnAddress`, which only wakes threads in
+ * the same process; there the wait is cut into slices of `FUTEX_POLL_SLICE` ms so that a
+ * waiter in another process still notices the change.
+ *
+ * Spurious wake-ups are possible, so callers must always re-check their condition.
+ */
+const DWORD FUTEX_POLL_SLICE = 10;
+
+void futexWait(std::atomic<uint32_t>* word, uint32_t expected, DWORD timeout = INFINITE);
+void futexWakeOne(std::atomic<uint32_t>* word);
+void futexWakeAll(std::atomic<uint32_t>* word);
+
+/*
+ * A generation counter that threads can block on until it moves.
+ *
+ * The thread making a change calls `notify()` after publishing it. A thread waiting for
+ * changes remembers the generation it has already seen (`current()`), looks at the data,
+ * and then calls `waitForChange()` with that generation, so a change made in between is
+ * never missed. `notify()` only enters the kernel when somebody is actually waiting.
+ *
+ * All-zero bytes are a valid initial state, so a ChangeNotifier can live in a data pool
+ * and be shared between processes.
+ */
+class ChangeNotifier
+{
+private:
+	std::atomic<uint32_t> generation;
+	std::atomic<uint32_t> waiters;
+
+public:
+	constexpr ChangeNotifier() : generation(0), waiters(0) {}
+
+	uint32_t current() const { return generation.load(std::memory_order_acquire); }
+
+	void notify();
+
+	// Blocks until the generation differs from `seen` or `timeout` ms have passed,
+	// and returns the generation observed on return.
+	uint32_t waitForChange(uint32_t seen, DWORD timeout = INFINITE);
+};
+
+#endif // __FUTEX_H__
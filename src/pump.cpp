@@ -1,73 +1,87 @@
 #include "pump.h"
 #include <iomanip>
+#include "screen_renderer.h"
 
 using namespace std;
 
-Pump::Pump(int id, vector<unique_ptr<FuelTank>>& tanks) : id_(id), tanks_(tanks), busy(false)
+Pump::Pump(int id, vector<unique_ptr<FuelTank>>& tanks, PumpDispatcher& dispatcher)
+	: id_(id), busy(false), tanks_(tanks), dispatcher_(dispatcher),
+	  flowRateMl(sharedResources.getConfig().flowRateMl()), hoseReturned(false)
 {
-	windowMutex = sharedResources.getPumpWindowMutex();
-
 	// for Customer objects
 	// pipe size is set to 1 so that one customer is serviced at a time.
 	pipe = sharedResources.getPumpPipe(id_);
 	
-	data = sharedResources.getPumpDpDataPtr(id_);
-
-	dpMutex = sharedResources.getPumpDpDataMutex(id_);
+	statusSlot = sharedResources.getPumpStatus(id_);
 
 	txnApprovedEvent = sharedResources.getTxnApprovedEvent(id_);
 
 	rndv = sharedResources.getRndv();
 
-	// semaphore with initial value 0 and max value 1
-	producer = sharedResources.getProducer(id_);
-	// semaphore with initial value 1 and max value 1
-	consumer = sharedResources.getConsumer(id_);
+	doneLane = sharedResources.getDoneLane(id_);
 
 	/*
-	 * 1. Do not forget to initialize the value pointed by the pointer `data`. Or, the data pointed
-	 * by the `data` pointer cannot be accessed properly later on.
-	 * 2. You need to use a mutex to protect the datapool (specifically, protect the pointer pointing
-	 * to the data in the data pool). Or you may get an `access violation writing location` exception
-	 * in the memcpy.asm file or a weird bug that it needs 2 times of assignment operation to modify the
-	 * `*data` variable properply.
-	 * 3. Only the owner of the data pool (i.e., pump class) needs to initialize the data pool.
-	 * If both the pump class and the computer class initialize the data pool in their own constructor,
-	  an exception in the memcpy.asm file will be induced.
+	 * Only the owner of the data pool (i.e., pump class) initializes the data pool.
 	 */
-	do {
-		dpMutex->WaitToWrite();
-
-		*data = customer;
-
-		dpMutex->DoneWriting();
-	} while (*data != customer);
+	statusSlot->approval.store(0);
+	toWire(customer, published);
+	statusSlot->initDetails(published);
 	assert(customer.txnStatus == TxnStatus::Pending);
 }
 
+/*
+ * Tells everybody watching the pump what has just changed, without waiting for anybody to
+ * have read the previous change. Only a new customer or a reset publishes the whole record;
+ * everything else goes out as the 12-byte event alone.
+ */
 void
-Pump::sendTransactionInfo()
+Pump::sendTransactionInfo(PumpEventType type)
 {
-	consumer->Wait();
-
-	dpMutex->WaitToWrite();
-	*data = customer;
-	assert(*data == customer);
-	dpMutex->DoneWriting();
-	
-	producer->Signal();
+	PumpEvent event{};
+	event.type = type;
+	event.status = static_cast<uint8_t>(customer.txnStatus);
+	event.receivedMl = litresToMl(customer.receivedVolume);
+	event.costMills = dollarsToMills(customer.cost);
+
+	const CustomerRecordWire* record = nullptr;
+	switch (type) {
+	case PumpEventType::TxnStarted:
+	case PumpEventType::Reset:
+		event.changed = PUMP_FIELDS_ALL;
+		toWire(customer, published);
+		record = &published;
+		break;
+	case PumpEventType::Tick:
+		event.changed = PUMP_FIELD_VOLUME | PUMP_FIELD_COST;
+		break;
+	default:
+		event.changed = PUMP_FIELD_STATUS;
+		break;
+	}
+	statusSlot->publish(event, record);
+	statusChanges.notify();
 }
 
 float
 Pump::getReceivedVolume()
 {
-	return data->receivedVolume;
+	CustomerRecordWire status;
+	statusSlot->read(status);
+	return status.receivedVolume;
 }
 
 float
 Pump::getTotalCost()
 {
-	return data->cost;
+	CustomerRecordWire status;
+	statusSlot->read(status);
+	return status.cost;
+}
+
+TaskNotifier&
+Pump::getStatusNotifier()
+{
+	return statusChanges;
 }
 
 FuelTank&
@@ -89,33 +103,77 @@ Pump::getFuel()
 	assert(chosen_tank.getFuelGrade() == customer.grade);
 
 	if (customer.txnStatus == TxnStatus::Approved) {
-		if (chosen_tank.readVolume() >= customer.requestedVolume) {
-			txnApprovedEvent->Signal();
-			do {
-				if (chosen_tank.decrement()) {
-					customer.receivedVolume += FLOW_RATE;
-					//customer.cost = fuelPrice_.getTotalCost(customer.receivedVolume, customer.grade);
-					customer.cost = customer.receivedVolume * customer.unitCost;
-					sendTransactionInfo();
-				}
-			} while (customer.receivedVolume < customer.requestedVolume && chosen_tank.checkRemainingVolume());
+		// The whole request is set aside first, so another pump cannot take the same fuel meanwhile.
+		int32_t reserved_ml = litresToMl(customer.requestedVolume);
+		if (chosen_tank.reserve(reserved_ml)) {
+			int32_t received_ml = 0;
+			while (received_ml < reserved_ml) {
+				int32_t tick_ml = min(flowRateMl, reserved_ml - received_ml);
+				chosen_tank.dispense(tick_ml);
+				received_ml += tick_ml;
+				customer.receivedVolume = mlToLitres(received_ml);
+				//customer.cost = fuelPrice_.getTotalCost(customer.receivedVolume, customer.grade);
+				customer.cost = customer.receivedVolume * customer.unitCost;
+				sendTransactionInfo(PumpEventType::Tick);
+			}
 		}
 		else {
-			cout << "Warning: The fuel tank does not have enough fuel left. Customer transaction cannot be completed." << endl;
+			ostringstream notice;
+			notice << "The " << fuelGradeToString(customer.grade) << " tank cannot cover " << customer.requestedVolume
+				<< " L; nothing was dispensed.";
+			showNotice(notice.str());
 			// No charge to the customer in this branch.
 		}
 	}
 	else {
 		assert(customer.txnStatus != TxnStatus::Pending);
-		cout << "Customer transaction was denied by the gas station attendant. Fuel cannot be dispensed." << endl;
+		showNotice("The attendant denied the transaction; nothing was dispensed.");
 		// No charge to the customer in this branch.
 	}
 
 	customer.txnStatus = TxnStatus::Done;
-	sendTransactionInfo(); // This is to ensure TxnStatus::Done is sent successfully to the computer.
+	// The Computer may miss events, but not this one: it goes down the Done lane before being published.
+	toWire(customer, wire);
+	doneLane->Write(&wire);
+	sendTransactionInfo(PumpEventType::Done);
 
 }
 
+/*
+ * Puts `text` on the PumpFacility's notice line, in place of whatever any pump last said there.
+ */
+void
+Pump::showNotice(const string& text)
+{
+	ostringstream line;
+	line << "Pump " << id_ << ": " << text;
+	ostringstream padded;
+	padded << left << setw(SCREEN_MAX_COLUMNS / 2) << line.str();
+	ScreenRenderer::get().print(0, PUMP_NOTICE_POSITION, padded.str(), YELLOW);
+}
+
+void
+Pump::returnHose()
+{
+	hoseReturned.store(true, memory_order_release);
+	hoseChanges.notify();
+}
+
+/*
+ * Keeps the Done record in the data pool until the customer has seen it and hung up the hose,
+ * since the next record published is the reset one.
+ */
+void
+Pump::waitForHose()
+{
+	while (true) {
+		uint32_t generation = hoseChanges.current();
+		if (hoseReturned.exchange(false, memory_order_acq_rel))
+			break;
+		hoseChanges.waitForChange(generation);
+	}
+}
+
 void
 Pump::resetPump()
 {
@@ -123,9 +181,13 @@ Pump::resetPump()
 	assert(busy == true);
 	customer.resetToDefault();
 
-	sendTransactionInfo();
+	statusSlot->approval.store(0);
+	sendTransactionInfo(PumpEventType::Reset);
 
 	busy = false; // notify the customer the transaction is done.
+
+	// Hand the pump to the next waiting customer, if any.
+	dispatcher_.release(id_);
 }
 void
 Pump::readPipe()
@@ -137,15 +199,13 @@ Pump::readPipe()
 	 * will be induced. Since the pump is the only reader to its pipe, it does not
 	 * need mutex protection.
 	 */
-	/* BUG: The creditCardNumber value of customer is empty when it's printed out.
-	 * This is why `data->creditCardNumber = customer.creditCardNumber;` later on can cause
-	 * the memcpy exception.
-	 */
 
 	// This pump has arrived at Rendezvous and is about to read the pipe ...
 	rendezvousOnce();
 
-	pipe->Read(&customer);
+	CustomerRecordWire wire;
+	pipe->Read(&wire);
+	fromWire(wire, customer);
 
 	assert(customer.txnStatus == TxnStatus::Pending);
 }
@@ -157,10 +217,9 @@ Pump::waitForAuth()
 
 	txnApprovedEvent->Wait();
 
-	dpMutex->WaitToRead();
-	assert(data->txnStatus == TxnStatus::Approved);
-	customer.txnStatus = data->txnStatus;
-	dpMutex->DoneReading();
+	// The attendant only raises the flag; the pump publishes the new status itself.
+	assert(statusSlot->approval.load() == 1);
+	customer.txnStatus = TxnStatus::Approved;
 }
 
 int
@@ -205,7 +264,7 @@ Pump::main()
 		if (customer.txnStatus != TxnStatus::Pending)
 			cout << "DEBUG 2: customer.txnStatus = " << txnStatusToString(customer.txnStatus) << endl;
 
-		sendTransactionInfo();
+		sendTransactionInfo(PumpEventType::TxnStarted);
 
 		if (customer.txnStatus != TxnStatus::Pending)
 			cout << "DEBUG 3: customer.txnStatus = " << txnStatusToString(customer.txnStatus) << endl;
@@ -217,10 +276,12 @@ Pump::main()
 
 		assert(customer.txnStatus == TxnStatus::Approved);
 
-		sendTransactionInfo();
+		sendTransactionInfo(PumpEventType::Approved);
 
 		getFuel();
 
+		waitForHose();
+
 		resetPump();
 	}
 	return 0;
@@ -5,51 +5,68 @@
 #include "fuel_tank.h"
 #include "common.h"
 #include "fuel_price.h"
+#include "pump_dispatcher.h"
+#include "task.h"
+#include <atomic>
 
 
 class Pump : public ActiveClass 
 {
 private:
 	int id_;
-	bool busy;
+	std::atomic<bool> busy;
 	std::string name;
 
-	std::shared_ptr<CustomerRecord> data;
-	// to protect data pointer pointing to the data in the pump data pool
-	std::shared_ptr<CReadersWritersMutex> dpMutex;
+	// pump data pool, this pump is the only writer of the details and events in it
+	std::shared_ptr<PumpStatusSlot> statusSlot;
+	CustomerRecordWire published;	// the customer's whole record, as sent with TxnStarted and Reset
+	CustomerRecordWire wire;
 
-	std::shared_ptr<CTypedPipe<CustomerRecord>> pipe;
+	// wakes the customer task parked on this pump whenever statusSlot changes
+	TaskNotifier statusChanges;
 
-	// to protect DOS window from being shared by multiple threads at the same time
-	std::shared_ptr<CMutex> windowMutex;
+	std::shared_ptr<PumpPipe> pipe;
 
 	CustomerRecord customer;
 
 	std::vector<std::unique_ptr<FuelTank>>& tanks_;
 
+	PumpDispatcher& dispatcher_;
+
+	int32_t flowRateMl;
+
 	std::shared_ptr<CEvent> txnApprovedEvent;
 
 	std::shared_ptr<CRendezvous> rndv;
 
-	std::shared_ptr<CSemaphore> producer, consumer;
+	// completed transactions for the Computer
+	std::shared_ptr<DoneLane> doneLane;
+
+	// set by the customer when they are done with the pump; the pump waits for it before the next customer
+	std::atomic<bool> hoseReturned;
+	ChangeNotifier hoseChanges;
 
 	// To create a class thread out of this function, the return value type must be `int`.
 	void readPipe();
 	void getFuel();
+	void showNotice(const std::string& text);
 	void resetPump();
-	void sendTransactionInfo();
+	void sendTransactionInfo(PumpEventType type);
 	void waitForAuth();
+	void waitForHose();
 	void rendezvousOnce();
 	int main();
 	
 	FuelTank& getTank(int id);
 
 public:
-	Pump(int id, std::vector<std::unique_ptr<FuelTank>>& tanks);
+	Pump(int id, std::vector<std::unique_ptr<FuelTank>>& tanks, PumpDispatcher& dispatcher);
 	void setBusy();
 	bool isBusy();
 	int getId();
 	float getReceivedVolume();
 	float getTotalCost();
+	TaskNotifier& getStatusNotifier();
+	void returnHose();
 };
 #endif // __PUMP_H__
\ No newline at end of file
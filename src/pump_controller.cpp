@@ -1,54 +1,53 @@
 #include "pump_controller.h"
+#include "screen_renderer.h"
 
 using namespace std;
 
-PumpController::PumpController(int id) : id_(id)
+PumpController::PumpController(int id)
+	: id_(id), dirtyFields(0), statusSlot(sharedResources.getPumpStatus(id)), doneLane(sharedResources.getDoneLane(id)),
+	  events(*statusSlot)
 {
-	windowMutex = sharedResources.getComputerWindowMutex();
-
-	// Must use the reset function to avoid the error E0349 `no operator "=" matches these operands 
-	dpData = sharedResources.getPumpDpDataPtr(id_);
-
-	// This mutex is used for customers to directly get real time data from computer directly.
-	mutex = sharedResources.getPumpDpDataMutex(id_);
-	assert(data.txnStatus == TxnStatus::Pending && prev_data.txnStatus == TxnStatus::Pending);
-
-	producer = sharedResources.getProducer(id_);
-	consumer = sharedResources.getConsumer(id_);
+	assert(data.txnStatus == TxnStatus::Pending);
 }
 
 void
-PumpController::readData()
+PumpController::readEvents()
 {
-	
-	producer->Wait();
+	while (true) {
+		// Taken before looking, so an event published in between is not missed.
+		uint32_t generation = statusSlot->changed.current();
+		if (events.hasEvents() || doneLane->TestForData() > 0)
+			break;
+		statusSlot->changed.waitForChange(generation);
+	}
 
-	mutex->WaitToRead();
-	data = *dpData;
-	assert(data == *dpData);
-	mutex->DoneReading();
+	dirtyFields |= events.apply(data);
+}
 
-	consumer->Signal();
-	
+bool
+PumpController::readFinished(CustomerRecord& txn)
+{
+	if (doneLane->TestForData() == 0)
+		return false;
+
+	CustomerRecordWire wire;
+	doneLane->Read(&wire);
+	fromWire(wire, txn);
+	return true;
 }
 
 void
 PumpController::archiveData()
 {
+	// Only the pump writes to its data pool; the archived status is kept by the computer.
 	data.txnStatus = TxnStatus::Archived;
-	
-	mutex->WaitToWrite();
-	dpData->txnStatus = data.txnStatus;
-	mutex->DoneWriting();	
+	dirtyFields |= PUMP_FIELD_STATUS;
 }
 
 void
 PumpController::addTimestamp()
 {
-	mutex->WaitToWrite();
 	data.nowTime = getTimestamp();
-	dpData->nowTime = data.nowTime;
-	mutex->DoneWriting();
 }
 
 CustomerRecord
@@ -62,48 +61,67 @@ PumpController::getData() const
 void
 PumpController::printPumpData()
 {
-	if (prev_data == data) {
+	if (dirtyFields == 0)
 		return;
+
+	if (dirtyFields == PUMP_FIELDS_ALL) {
+		printPumpStatus(data);
 	}
 	else {
-		prev_data = data;
-		printPumpStatus(prev_data);
+		// rows 1 to 5 are the customer's details, then the volume, the cost and the status
+		static const uint8_t ROW_FIELDS[] = { 0, PUMP_FIELD_DETAILS, PUMP_FIELD_DETAILS, PUMP_FIELD_DETAILS,
+			PUMP_FIELD_DETAILS, PUMP_FIELD_DETAILS, PUMP_FIELD_VOLUME, PUMP_FIELD_COST, PUMP_FIELD_STATUS };
+		const int top = PUMP_STATUS_POSITION + id_ * 12;
+		for (int row = 1; row <= 8; row++) {
+			if (dirtyFields & ROW_FIELDS[row])
+				ScreenRenderer::get().print(0, top + row, statusLine(row, data));
+		}
 	}
+	dirtyFields = 0;
 }
 
-void
-PumpController::printPumpStatus(const CustomerRecord& record) const
+/*
+ * For some reason, there are some residual characters on the screen that were printed from previous calls
+ * of this function, leanding to some puzzling characters printed in the furture calls of this function
+ * (e.g., waitoved, N/A 85, etc.).
+ * To resolve this problem, we can print use empty string " " to overwrite those residual characters.
+ */
+string
+PumpController::statusLine(int row, const CustomerRecord& record) const
 {
-	windowMutex->Wait();
-	MOVE_CURSOR(0, PUMP_STATUS_POSITION + id_ * 12);
-	cout << "--------------- Pump " << id_ << " Status ---------------\n";
-	/*
-	 * For some reason, there are some residual characters on the DOS window that were printed from previous calls
-	 * of this function, leanding to some puzzling characters printed in the furture calls of this function
-	 * (e.g., waitoved, N/A 85, etc.).
-	 * To resolve this problem, we can print use empty string " " to overwrite those residual characters.
-	 */
+	ostringstream out;
 	if (record.name == "___Unknown___") {
-		cout << "Name:                      " << "N/A             " << "\n";
-		cout << "Credit Card Number:        " << "N/A             " << "\n";
-		cout << "Fuel Grade:                " << "N/A             " << "\n";
-		cout << "Unit Cost ($/L):           " << "N/A             " << "\n";
-		cout << "Requested Volume (L):      " << "N/A             " << "\n";
-		cout << "Received Volume (L):       " << "N/A             " << "\n";
-		cout << "Total Cost ($):            " << "N/A             " << "\n";
-		cout << "Transaction Status:        " << "N/A             " << "\n";
+		static const char* const LABELS[] = { "", "Name:", "Credit Card Number:", "Fuel Grade:", "Unit Cost ($/L):",
+			"Requested Volume (L):", "Received Volume (L):", "Total Cost ($):", "Transaction Status:" };
+		out << left << setw(27) << LABELS[row] << (row == 4 ? "N/A                             " : "N/A             ");
+		return out.str();
 	}
-	else {
-		cout << "Name:                      " << record.name << "          " << "\n";
-		cout << "Credit Card Number:        " << record.creditCardNumber << "          " << "\n";
-		cout << "Fuel Grade:                " << fuelGradeToString(record.grade) << "          " << "\n";
-		cout << "Unit Cost ($/L):           " << record.unitCost << "          " << "\n";
-		cout << "Requested Volume (L):      " << record.requestedVolume << "          " << "\n";
-		cout << "Received Volume (L):       " << record.receivedVolume << "          " << "\n";
-		cout << "Total Cost ($):            " << record.cost << "          " << "\n";
-		cout << "Transaction Status:        " << txnStatusToString(record.txnStatus) << "          " << "\n";
+
+	switch (row) {
+	case 1: out << "Name:                      " << record.name; break;
+	case 2: out << "Credit Card Number:        " << record.creditCardNumber; break;
+	case 3: out << "Fuel Grade:                " << fuelGradeToString(record.grade); break;
+	case 4: out << "Unit Cost ($/L):           " << record.unitCost << " (price list " << record.priceVersion << ")"; break;
+	case 5: out << "Requested Volume (L):      " << record.requestedVolume; break;
+	case 6: out << "Received Volume (L):       " << record.receivedVolume; break;
+	case 7: out << "Total Cost ($):            " << record.cost; break;
+	case 8: out << "Transaction Status:        " << txnStatusToString(record.txnStatus); break;
 	}
-	cout << "---------------------------------------------\n";
-	cout << "\n";
-	windowMutex->Signal();
+	out << "          ";
+	return out.str();
+}
+
+void
+PumpController::printPumpStatus(const CustomerRecord& record) const
+{
+	ostringstream out;
+	out << "--------------- Pump " << id_ << " Status ---------------";
+	if (events.getResyncs() > 0)
+		out << " (missed events, resynced " << events.getResyncs() << "x)";
+	out << "\n";
+	for (int row = 1; row <= 8; row++)
+		out << statusLine(row, record) << "\n";
+	out << "---------------------------------------------\n";
+	out << "\n";
+	ScreenRenderer::get().print(0, PUMP_STATUS_POSITION + id_ * 12, out.str());
 }
@@ -4,6 +4,99 @@
 #include "rt.h"
 #include "common.h"
 
+// most pump events applied before the status is drawn again
+const size_t PUMP_EVENT_BATCH = 16;
+
+/*
+ * Follows one pump's events into a CustomerRecord, copying only the fields each event has
+ * changed. When the reader has fallen so far behind that the ring has been lapped, the record
+ * is taken from the pump's newest status instead and the events after that are applied on top
+ * of it from the next call on.
+ */
+class PumpEventReader
+{
+private:
+	const PumpStatusSlot* slot;
+
+	// number of the next pump event to apply, and the events taken in one go
+	uint64_t nextEvent;
+	PumpEvent batch[PUMP_EVENT_BATCH];
+
+	// times the pump got a whole ring of events ahead
+	uint64_t resyncs;
+
+	bool applyEvent(const PumpEvent& event, uint64_t number, CustomerRecord& data) const;
+
+public:
+	explicit PumpEventReader(const PumpStatusSlot& slot) : slot(&slot), nextEvent(1), resyncs(0) {}
+
+	// whether the pump has published events not applied yet
+	bool hasEvents() const { return slot->events.getPublished() >= nextEvent; }
+
+	uint64_t getResyncs() const { return resyncs; }
+
+	/*
+	 * Applies up to PUMP_EVENT_BATCH new events to `data` and returns the PUMP_FIELD_* bits
+	 * they changed. `applied(data, changed)` is called after each event, or once with
+	 * PUMP_FIELDS_ALL after a resync.
+	 */
+	template <class Applied>
+	uint8_t apply(CustomerRecord& data, Applied applied);
+
+	uint8_t apply(CustomerRecord& data)
+	{
+		return apply(data, [](const CustomerRecord&, uint8_t) {});
+	}
+};
+
+/*
+ * False if the event starts a transaction whose details the pump has already replaced with
+ * those of a later one.
+ */
+inline bool
+PumpEventReader::applyEvent(const PumpEvent& event, uint64_t number, CustomerRecord& data) const
+{
+	if (event.changed & PUMP_FIELD_DETAILS) {
+		PumpDetails details;
+		if (!slot->readDetails(number, details))
+			return false;
+		fromWire(details.record, data);
+	}
+	if (event.changed & PUMP_FIELD_STATUS)
+		data.txnStatus = event.txnStatus();
+	if (event.changed & PUMP_FIELD_VOLUME)
+		data.receivedVolume = mlToLitres(event.receivedMl);
+	if (event.changed & PUMP_FIELD_COST)
+		data.cost = millsToDollars(event.costMills);
+	return true;
+}
+
+template <class Applied>
+uint8_t
+PumpEventReader::apply(CustomerRecord& data, Applied applied)
+{
+	const uint64_t first = nextEvent;
+	bool overrun = false;
+	uint8_t changed = 0;
+	size_t count = slot->events.read(nextEvent, batch, PUMP_EVENT_BATCH, overrun);
+	for (size_t i = 0; i < count && !overrun; i++) {
+		overrun = !applyEvent(batch[i], first + i, data);
+		if (!overrun) {
+			changed |= batch[i].changed;
+			applied(data, batch[i].changed);
+		}
+	}
+
+	if (overrun) {
+		CustomerRecordWire wire;
+		nextEvent = slot->read(wire) + 1;
+		fromWire(wire, data);
+		resyncs++;
+		changed = PUMP_FIELDS_ALL;
+		applied(data, changed);
+	}
+	return changed;
+}
 
 class PumpController
 {
@@ -13,20 +106,31 @@ private:
 	// No need to initialize this variable because it is
 	// initialized by its contructor when it is declared.
 	CustomerRecord data;
-	CustomerRecord prev_data;
 
-	std::shared_ptr<CReadersWritersMutex> mutex;
-	std::shared_ptr<CMutex> windowMutex;
+	// PUMP_FIELD_* bits of `data` changed since it was last drawn
+	uint8_t dirtyFields;
 
-	std::shared_ptr<CustomerRecord> dpData;
+	std::shared_ptr<PumpStatusSlot> statusSlot;
+	std::shared_ptr<DoneLane> doneLane;
+	PumpEventReader events;
 
-	std::shared_ptr<CSemaphore> producer, consumer;
+	// one line of the status block, `row` 1 to 8
+	std::string statusLine(int row, const CustomerRecord& record) const;
 
 public:
 	PumpController(int id);
+	// Redraws the lines of the status block whose fields have changed.
 	void printPumpData();
 	void printPumpStatus(const CustomerRecord& record) const;
-	void readData();
+
+	/*
+	 * Waits until the pump has published events not applied yet, or finished a transaction,
+	 * and applies up to PUMP_EVENT_BATCH of them to `data`.
+	 */
+	void readEvents();
+
+	// Takes the next transaction the pump has finished, if there is one.
+	bool readFinished(CustomerRecord& txn);
 	void archiveData();
 	void addTimestamp();
 
@@ -0,0 +1,71 @@
+#include "pump_dispatcher.h"
+#include <cassert>
+#include <chrono>
+#include "sim_clock.h"
+
+using namespace std;
+
+PumpDispatcher::PumpDispatcher(int num_pumps, ChangeNotifier& queue_changes)
+	: freePumps(num_pumps, true), queueChanges(queue_changes)
+{
+}
+
+bool
+PumpDispatcher::AcquireAwaiter::await_suspend(coroutine_handle<> task)
+{
+	lock_guard<mutex> lock(dispatcher.queueMutex);
+	vector<bool>& freePumps = dispatcher.freePumps;
+
+	for (size_t i = 0; i < freePumps.size(); i++) {
+		if (freePumps[i]) {
+			freePumps[i] = false;
+			waiter.pumpId = static_cast<int>(i);
+			return false;		// carry on without suspending
+		}
+	}
+
+	// Every pump is busy: wait at the end of the queue.
+	// The waiter lives in the parked coroutine's frame until handOver() resumes it.
+	waiter.task = task;
+	waiter.since = chrono::duration_cast<chrono::seconds>(SimClock::get().now().time_since_epoch()).count();
+	dispatcher.queue.push_back(&waiter);
+	dispatcher.queueChanges.notify();
+	return true;
+}
+
+void
+PumpDispatcher::handOver(int pump_id)
+{
+	Waiter* waiter = queue.front();
+	queue.pop_front();
+	waiter->pumpId = pump_id;
+	// The waiter must not be touched once it has been posted: it may already be running.
+	waiter->pool->post(waiter->task);
+	queueChanges.notify();
+}
+
+void
+PumpDispatcher::release(int pump_id)
+{
+	lock_guard<mutex> lock(queueMutex);
+	assert(!freePumps[pump_id]);
+
+	if (!queue.empty())
+		handOver(pump_id);
+	else
+		freePumps[pump_id] = true;
+}
+
+int
+PumpDispatcher::queueDepth() const
+{
+	lock_guard<mutex> lock(queueMutex);
+	return static_cast<int>(queue.size());
+}
+
+int64_t
+PumpDispatcher::oldestSince() const
+{
+	lock_guard<mutex> lock(queueMutex);
+	return queue.empty() ? 0 : queue.front()->since;
+}
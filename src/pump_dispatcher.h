@@ -0,0 +1,73 @@
+#ifndef __PUMP_DISPATCHER_H__
+#define __PUMP_DISPATCHER_H__
+
+#include <cstdint>
+#include <mutex>
+#include <deque>
+#include <vector>
+#include "futex.h"
+#include "task.h"
+
+/*
+ * Hands out pumps to customers.
+ *
+ * A customer that finds every pump busy joins the end of the forecourt's one queue and is
+ * parked until a pump is handed to it, instead of rescanning the pumps. Customers are
+ * coroutines on a TaskPool, so a parked customer holds no thread; the hand-over posts it back
+ * to its pool. When a pump is released it goes to the customer at the head of the queue, so
+ * customers are served in arrival (FIFO) order and a pump never stands idle while somebody
+ * is waiting.
+ *
+ * How many are waiting and since when is exposed for the display, and `queueChanges` is
+ * notified whenever the queue changes.
+ */
+class PumpDispatcher
+{
+private:
+	struct Waiter
+	{
+		std::coroutine_handle<> task;
+		TaskPool* pool = nullptr;
+		int pumpId = -1;
+		int64_t since = 0;		// simulated time the customer joined the queue, seconds since the epoch
+	};
+
+	mutable std::mutex queueMutex;
+	std::vector<bool> freePumps;
+	std::deque<Waiter*> queue;
+	ChangeNotifier& queueChanges;
+
+	void handOver(int pump_id);
+
+public:
+	class AcquireAwaiter
+	{
+	private:
+		PumpDispatcher& dispatcher;
+		Waiter waiter;
+
+	public:
+		AcquireAwaiter(PumpDispatcher& d, TaskPool& pool) : dispatcher(d) { waiter.pool = &pool; }
+
+		bool await_ready() const { return false; }
+		bool await_suspend(std::coroutine_handle<> task);
+		int await_resume() const { return waiter.pumpId; }
+	};
+
+	PumpDispatcher(int num_pumps, ChangeNotifier& queue_changes);
+
+	// `co_await acquire(pool)` yields the id of a pump for the caller, resuming on `pool`
+	// if it had to queue for it.
+	AcquireAwaiter acquire(TaskPool& pool) { return AcquireAwaiter(*this, pool); }
+
+	// Gives the pump to the next waiting customer, or marks it free if nobody is waiting.
+	void release(int pump_id);
+
+	// Number of customers waiting for a pump.
+	int queueDepth() const;
+
+	// Simulated time the customer at the head of the queue joined it, seconds since the epoch; 0 if nobody is waiting.
+	int64_t oldestSince() const;
+};
+
+#endif // __PUMP_DISPATCHER_H__
@@ -1,10 +1,11 @@
 #include "pump_facility.h"
 #include "command_processor.h"
+#include "screen_renderer.h"
 #include <iomanip> // Required for std::setw()
 
 using namespace std;
 
-static FuelPrice fuelPrice;
+static unique_ptr<FuelPrice> fuelPrice;
 
 /**
  * Plan: incorperate the four tanks inside the pump facility which is the top level.
@@ -18,15 +19,16 @@ static FuelPrice fuelPrice;
  *                                             *
  ***********************************************/
 vector<unique_ptr<FuelTank>> tanks;
-shared_ptr<CMutex> windowMutex = sharedResources.getPumpWindowMutex();
+ScreenRenderer& screen = ScreenRenderer::get();
 
 void
 setupTanks()
 {
-	for (int i = 0; i < NUM_TANKS; i++) {
+	const int num_tanks = sharedResources.getConfig().numTanks;
+	for (int i = 0; i < num_tanks; i++) {
 		tanks.emplace_back(make_unique<FuelTank>(i));
 	}
-	for (int i = 0; i < NUM_TANKS; i++) {
+	for (int i = 0; i < num_tanks; i++) {
 		assert(fuelGradeToInt(tanks[i]->getFuelGrade()) == i);
 	}
 }
@@ -38,13 +40,28 @@ setupTanks()
  ***********************************************/
 vector<unique_ptr<Pump>> pumps;
 
+// Queues customers for the pumps; must be constructed before the pumps and the customers.
+// Queue changes wake the customer display like any other customer change.
+unique_ptr<PumpDispatcher> dispatcher;
+
+unique_ptr<CommandProcessor> cmdProcessor;
+shared_ptr<CRendezvous> rndv;
+
 void
 setupPumpFacility()
 {
-	for (int i = 0; i < NUM_PUMPS; i++) {
-		pumps.emplace_back(make_unique<Pump>(i, tanks));
+	const int num_pumps = sharedResources.getConfig().numPumps;
+
+	fuelPrice = make_unique<FuelPrice>();
+	dispatcher = make_unique<PumpDispatcher>(num_pumps, Customer::getChangeNotifier());
+	rndv = sharedResources.getRndv();
+
+	for (int i = 0; i < num_pumps; i++) {
+		pumps.emplace_back(make_unique<Pump>(i, tanks, *dispatcher));
 		pumps[i]->Resume();
 	}
+
+	cmdProcessor = make_unique<CommandProcessor>(*fuelPrice, pumps, *dispatcher);
 }
 
 /***********************************************
@@ -52,12 +69,10 @@ setupPumpFacility()
  *                Command Processor            *
  *                                             *
  ***********************************************/
-CommandProcessor cmdProcessor(fuelPrice, pumps);
-
 UINT __stdcall
 runCommandProcessor(void* args)
 {
-	cmdProcessor.run();
+	cmdProcessor->run();
 	return 0;
 }
 
@@ -68,113 +83,141 @@ runCommandProcessor(void* args)
  ***********************************************/
 
 //vector<unique_ptr<Customer>> customers;
-shared_ptr<CRendezvous> rndv = sharedResources.getRndv();
 
 UINT __stdcall printCustomers(void* args)
 {
-	windowMutex->Wait();
-	MOVE_CURSOR(0, 0);
-	std::cout << "--------------------------------------------------------------------------------" << std::endl;
-	std::cout << "                   Welcome to Gas Station Control Panel                         " << std::endl;
-	std::cout << "--------------------------------------------------------------------------------" << std::endl;
-	std::cout << "Supported commands:" << std::endl;
+	ostringstream out;
+	out << "--------------------------------------------------------------------------------\n";
+	out << "                   Welcome to Gas Station Control Panel                         \n";
+	out << "--------------------------------------------------------------------------------\n";
+	out << "Supported commands:\n";
 
 	// Set the width for the command and description columns
 	const int commandWidth = 10;
 	const int descriptionWidth = 25;
 
 	// Set the left alignment for the columns
-	std::cout << std::left << std::setw(commandWidth) << "- gc#:";
-	std::cout << std::setw(descriptionWidth) << "Generate # number of customers (must less than "<< MAX_NUM_CUSTOMERS << ")" << std::endl;
+	out << std::left << std::setw(commandWidth) << "- gc#:";
+	out << std::setw(descriptionWidth) << "Generate # number of customers" << "\n";
 
-	std::cout << std::left << std::setw(commandWidth) << "- op#";
-	std::cout << std::setw(descriptionWidth) << "Authorize the transaction at pump # by opening that pump" << std::endl;
+	out << std::left << std::setw(commandWidth) << "- op#";
+	out << std::setw(descriptionWidth) << "Authorize the transaction at pump # by opening that pump" << "\n";
 
-	std::cout << std::left << std::setw(commandWidth) << "- cpX Y:";
-	std::cout << std::setw(descriptionWidth) << "Change the unit price of fuel grade X to the price Y" << std::endl;
+	out << std::left << std::setw(commandWidth) << "- cpX Y:";
+	out << std::setw(descriptionWidth) << "Change the unit price of fuel grade X to the price Y" << "\n";
 
-	std::cout << std::left << std::setw(commandWidth) << "- pt:";
-	std::cout << std::setw(descriptionWidth) << "Print transaction history" << std::endl;
+	out << std::left << std::setw(commandWidth) << "- pt:";
+	out << std::setw(descriptionWidth) << "Print transaction history (filters: card= pump= grade= since= until=)" << "\n";
 
-	std::cout << std::left << std::setw(commandWidth) << "- rf#:";
-	std::cout << std::setw(descriptionWidth) << "Refill tank # to full capacity" << std::endl;
+	out << std::left << std::setw(commandWidth) << "- rf#:";
+	out << std::setw(descriptionWidth) << "Refill tank # to full capacity" << "\n";
 
 
-	std::cout << "\n";
+	out << "\n";
+	out << "\n";
 	
 
-	std::cout << "--------------------------------------------------------------------------------" << std::endl;
-	std::cout << "                           Customer Information                                 " << std::endl;
-	std::cout << "--------------------------------------------------------------------------------" << std::endl;
-	windowMutex->Signal();
+	out << "--------------------------------------------------------------------------------\n";
+	out << "                           Customer Information                                 \n";
+	out << "--------------------------------------------------------------------------------\n";
+	screen.print(0, 0, out.str());
 
 	static size_t num_customers = 0;
+	ChangeNotifier& customer_changes = Customer::getChangeNotifier();
 
 	while (true) {
-		num_customers = cmdProcessor.getCustomers().size();
+		// Redraw only after a customer has changed rather than spinning over all of them.
+		uint32_t generation = customer_changes.current();
+		printPendingCustomers();
+		num_customers = min(cmdProcessor->getCustomers().size(), static_cast<size_t>(MAX_DISPLAYED_CUSTOMERS));
 		for (size_t i = 0; i < num_customers; ++i) {
-			printCustomerRecord(i, cmdProcessor.getCustomers());
+			printCustomerRecord(static_cast<int>(i), cmdProcessor->getCustomers().at(i));
 		}
+		customer_changes.waitForChange(generation);
 	}
 }
 
+void
+printPendingCustomers()
+{
+	// Uses the blank line above the pumps' notice line.
+	const int pending_position = PUMP_NOTICE_POSITION - 1;
+	static int prev_depth = -1;
+	static int64_t prev_since = -1;
+
+	// Any free pump takes whoever has waited longest, so there is one queue to show.
+	const int depth = dispatcher->queueDepth();
+	const int64_t since = dispatcher->oldestSince();
+	if (depth == prev_depth && since == prev_since)
+		return;
+
+	ostringstream out;
+	out << "Customers waiting: " << std::setw(5) << depth;
+	if (since != 0)
+		out << "   First in line since " << timestampToString(epochToTimestamp(since));
+	out << std::setw(40) << "";
+	screen.print(0, pending_position, out.str());
+
+	prev_depth = depth;
+	prev_since = since;
+}
 
 void
-printCustomerRecord(int idx, vector<unique_ptr<Customer>>& customers)
+printCustomerRecord(int idx, Customer& customer)
 {
 	const int block_height = 13;
-	static vector<CustomerRecord> prev_records(MAX_NUM_CUSTOMERS); // declare a vector with a size of `MAX_NUM_CUSTOMERS`
-	static vector<string> prev_statuses(MAX_NUM_CUSTOMERS, "Null"); // declare a vector with a size of `MAX_NUM_CUSTOMERS`, initialized with value "Null"
-	static vector<CustomerRecord> records(MAX_NUM_CUSTOMERS);
+	static vector<CustomerRecord> prev_records(MAX_DISPLAYED_CUSTOMERS); // declare a vector with a size of `MAX_DISPLAYED_CUSTOMERS`
+	static vector<string> prev_statuses(MAX_DISPLAYED_CUSTOMERS, "Null"); // declare a vector with a size of `MAX_DISPLAYED_CUSTOMERS`, initialized with value "Null"
+	static vector<CustomerRecord> records(MAX_DISPLAYED_CUSTOMERS);
 
-	records[idx] = customers[idx]->getData();
+	records[idx] = customer.getData();
+	const string status = customer.getStatusString();
 
-	if (customers[idx]->getStatusString() == "Null")
+	if (status == "Null")
 		return;
 
-	if (prev_records[idx] == records[idx] && prev_statuses[idx] == customers[idx]->getStatusString()) {
+	if (prev_records[idx] == records[idx] && prev_statuses[idx] == status) {
 		return;
 	}
 	else {
-		windowMutex->Wait();
-		MOVE_CURSOR(0, idx * block_height + CUSTOMER_STATUS_POSITION);
-		std::cout << "---------------------------------------------\n";
-		std::cout << "Name:                      " << records[idx].name << "                        " << "\n";
-		std::cout << "Credit Card Number:        " << records[idx].creditCardNumber << "                        " << "\n";
-		std::cout << "Fuel Grade:                " << fuelGradeToString(records[idx].grade) << "                        " << "\n";
-		std::cout << "Unit Cost ($/L):           " << records[idx].unitCost << "                        " << "\n";
-		std::cout << "Requested Volume (L):      " << records[idx].requestedVolume << "                        " << "\n";
-		std::cout << "Received Volume (L):       " << records[idx].receivedVolume << "                        " << "\n";
-		std::cout << "Total Cost ($):            " << records[idx].cost << "                        " << "\n";
-		if (customers[idx]->getStatusString() == "Wait for auth") {
-			TEXT_COLOUR(CYAN);
-		}
-		std::cout << "Status:                    " << customers[idx]->getStatusString() << "                        " << "\n";
-		TEXT_COLOUR();
+		const int position = idx * block_height + CUSTOMER_STATUS_POSITION;
+		ostringstream out;
+		out << "---------------------------------------------\n";
+		out << "Name:                      " << records[idx].name << "                        " << "\n";
+		out << "Credit Card Number:        " << records[idx].creditCardNumber << "                        " << "\n";
+		out << "Fuel Grade:                " << fuelGradeToString(records[idx].grade) << "                        " << "\n";
+		out << "Unit Cost ($/L):           " << records[idx].unitCost << "                        " << "\n";
+		out << "Requested Volume (L):      " << records[idx].requestedVolume << "                        " << "\n";
+		out << "Received Volume (L):       " << records[idx].receivedVolume << "                        " << "\n";
+		out << "Total Cost ($):            " << records[idx].cost << "                        ";
+		screen.print(0, position, out.str());
+
+		out.str("");
+		out << "Status:                    " << status << "                        ";
+		screen.print(0, position + 8, out.str(), (status == "Wait for auth") ? CYAN : 7);
+
+		out.str("");
 		if (records[idx].pumpId == -1) {
-			std::cout << "Pump ID:                   Pending" << "                        " << "\n";
+			out << "Pump ID:                   Pending" << "                        " << "\n";
 		}
 		else {
-			std::cout << "Pump ID:                   " << records[idx].pumpId << "                        " << "\n";
+			out << "Pump ID:                   " << records[idx].pumpId << "                        " << "\n";
 		}
 		if (records[idx].nowTime.tm_year == 0) {
-			std::cout << "Time:                                              " << "\n";
+			out << "Time:                                              \n";
 		}
 		else {
-			std::cout << "Time:                      ";
-			printTimestamp(records[idx].nowTime);
+			out << "Time:                      " << timestampToString(records[idx].nowTime) << "\n";
 		}
-
-		std::cout << "---------------------------------------------\n";
-		std::cout << "\n";
-		windowMutex->Signal();
+		out << "---------------------------------------------\n";
+		screen.print(0, position + 9, out.str());
 		prev_records[idx] = records[idx];
-		prev_statuses[idx] = customers[idx]->getStatusString();
+		prev_statuses[idx] = status;
 	}
 }
 
-void
-runPumpFacility()
+int
+runPumpFacility(std::FILE* commands)
 {
 	CThread printCustomersThread(printCustomers, ACTIVE, NULL);
 	/**
@@ -185,10 +228,23 @@ runPumpFacility()
 	 */
 	rndv->Wait();
 
+	if (commands != NULL) {
+		// Nobody is at the keyboard: the script's commands are run here, and the station stops with it.
+		BatchReport report = cmdProcessor->runBatch(commands);
+		screen.flush();
+		cout << "Ran " << report.commands << " commands, rejected " << report.rejectedLines.size() << " lines";
+		for (int line : report.rejectedLines)
+			cout << " " << line;
+		cout << endl;
+		return report.rejectedLines.empty() ? 0 : 1;
+	}
+
 	CThread runCommandProcessorThread(runCommandProcessor, ACTIVE, NULL);
 
 	printCustomersThread.WaitForThread();
 	runCommandProcessorThread.WaitForThread();
+	screen.flush();
 	cout << "Press Enter to terminate the Customer process." << endl;
 	waitForKeyPress();
+	return 0;
 }
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "pump.h"
 
 #include "customer.h"
+#include <cstdio>
 #include <string>
 #include <vector>
 #include "pump_controller.h"
@@ -38,12 +39,18 @@ void setupPumpFacility();
  ***********************************************/
 UINT __stdcall printCustomers(void* args);
 
+void printPendingCustomers();
 
-void printCustomerRecord(int idx, std::vector<std::unique_ptr<Customer>>& customers);
+
+void printCustomerRecord(int idx, Customer& customer);
 
 
 UINT __stdcall runCommandProcessor(void* args);
 
-void runPumpFacility();
+/*
+ * Runs the station until `ex` is typed, or, if `commands` is not NULL, until the command
+ * script in it has run; returns non-zero if any line of the script was rejected.
+ */
+int runPumpFacility(std::FILE* commands);
 
 #endif // __PUMP_FACILITY_H__
\ No newline at end of file
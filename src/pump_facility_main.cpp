@@ -1,16 +1,48 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include "rt.h"
 #include "common.h"
 #include "pump_facility.h"
 
 
 
-int main(void) {
+int main(int argc, char* argv[]) {
+
+	if (!SimClock::get().configureFromArgs(argc, argv))
+		return 1;
+
+	StationConfig config = StationConfig::defaults();
+	if (!config.configureFromArgs(argc, argv))
+		return 1;
+	if (!sharedResources.open(config))
+		std::cout << "Using the Computer's layout: " << sharedResources.getConfig().toString() << std::endl;
+	if (!sharedResources.shareClock())
+		std::cout << "Using the Computer's clock: " << SimClock::get().toString() << std::endl;
+
+	// --commands=<file> runs a command script instead of reading the keyboard; `-` is stdin
+	std::FILE* commands = NULL;
+	const char prefix[] = "--commands=";
+	for (int i = 1; i < argc; i++) {
+		if (strncmp(argv[i], prefix, sizeof(prefix) - 1) != 0)
+			continue;
+		const char* path = argv[i] + sizeof(prefix) - 1;
+		commands = (strcmp(path, "-") == 0) ? stdin : std::fopen(path, "r");
+		if (commands == NULL) {
+			std::cout << "Cannot open the command script " << path << std::endl;
+			return 1;
+		}
+	}
 
 	setupTanks();
 
 	setupPumpFacility();
 
-	runPumpFacility();
-
-	return 0;
+	int result = runPumpFacility(commands);
+	if (commands != NULL) {
+		// The pumps and customers never stop on their own, so nothing they use is destroyed under them.
+		std::cout.flush();
+		std::quick_exit(result);
+	}
+	return result;
 }
\ No newline at end of file
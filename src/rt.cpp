@@ -18,6 +18,9 @@
 #include "rt.h"
 
 using namespace std;
+
+#ifdef _WIN32		// the POSIX versions of everything inside #ifdef _WIN32 are in rt_posix.cpp
+
 // constructor to create a child process, takes four 
 //arguments, note that the last 3 make use
 //	of default argument, that is, if you do not supply 
@@ -569,6 +572,8 @@ BOOL CMutex::Read() const	// Handle of the Mutex needed
 
 }
 
+#endif // _WIN32
+
 ////////////////////////////////////////////////////////////
 //	ReaderWriters Mutex Problem
 ////////////////////////////////////////////////////////////
@@ -792,6 +797,8 @@ CRendezvous::~CRendezvous()
 }
 
 
+#ifdef _WIN32
+
 ////////////////////////////////////////////////////////////
 //	Event Functions
 ////////////////////////////////////////////////////////////
@@ -1114,6 +1121,8 @@ int main()
 
 */
 
+#endif // _WIN32
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////
 //	PIPELINE Functions
 //	
@@ -1132,6 +1141,8 @@ int main()
 //
 
 
+#ifdef _WIN32
+
 //##ModelId=3DE6123C03AB
 CPipe::CPipe(const string& Name, UINT SizeOfPipe) :PipeName(Name)
 {
@@ -1190,7 +1201,7 @@ CPipe::CPipe(const string& Name, UINT SizeOfPipe) :PipeName(Name)
 		NULL,
 		PAGE_READWRITE,
 		0,
-		sizeof(SizeOfPipe),
+		SizeOfPipe,
 		(char*)(PipeDataName.c_str())
 	);
 
@@ -1217,9 +1228,15 @@ CPipe::CPipe(const string& Name, UINT SizeOfPipe) :PipeName(Name)
 
 	// create mutex name for this pipeline and create the producer and consumer semaphores
 
+	//	The semaphores no longer count individual bytes. Read() and Write() move whole contiguous chunks
+	//	under the mutex and only park on a semaphore when the pipeline is empty/full, so each semaphore
+	//	is signalled with the number of parked readers/writers (see ReadersWaiting/WritersWaiting).
+	//	Win32 cannot decrement a semaphore by more than one per wait, which is why the byte count
+	//	itself lives in NumBytes rather than in the semaphore value.
+
 	pMutex = new CMutex(MutexName);
-	pProdSemaphore = new CSemaphore(ProdSemaName, 0, SizeOfPipe);					// create semaphore NOTE value of 0
-	pConSemaphore = new CSemaphore(ConSemaName, SizeOfPipe, SizeOfPipe);		// create semaphore note value of SizeofPipe
+	pProdSemaphore = new CSemaphore(ProdSemaName, 0, INT_MAX);					// create semaphore NOTE value of 0
+	pConSemaphore = new CSemaphore(ConSemaName, 0, INT_MAX);					// ditto, writers only wait when the pipeline is full
 
 	// now allocate some storage for the datapool and initialise the pointers which are all in the datapool
 	// for cross process communication
@@ -1230,6 +1247,8 @@ CPipe::CPipe(const string& Name, UINT SizeOfPipe) :PipeName(Name)
 		PipePointer->ReadingIndex = 0;
 		PipePointer->WritingIndex = 0;
 		PipePointer->NumBytes = 0;
+		PipePointer->ReadersWaiting = 0;
+		PipePointer->WritersWaiting = 0;
 		PipePointer->SizeOfPipe = SizeOfPipe;
 	}
 	else {	// if it is initialised, make sure the size was specified the same in all processes creating it
@@ -1279,12 +1298,18 @@ CPipe::~CPipe()
 }
 
 
+#endif // _WIN32
+
 //
 //	This functions handles writing data to a pipeline. All you need is the address of the programs
 //	data that is to be transferred to the pipline, and the size of that data. The write function takes
 //	care of the rest. Note that a process/thread writing to a full pipeline will be suspended until
 //	the process at the other end of the pipeline reads some out
 //
+//	Data is transferred in blocks: the mutex is taken once, as many bytes as there is free space for
+//	are copied in (split in two when the block wraps past the end of the buffer) and any parked
+//	readers are woken once for the whole block rather than once per byte.
+//
 
 //##ModelId=3DE6123C03CA
 BOOL CPipe::Write(void* Data, UINT Size)	// producer process
@@ -1293,20 +1318,41 @@ BOOL CPipe::Write(void* Data, UINT Size)	// producer process
 
 	LPBYTE	Addr = (LPBYTE)(Data);		// cast from void to byte pointer
 
-	for (UINT i = 0; i < Size; i++) {
-		pConSemaphore->Wait();	// make sure there is space in the pipeline, if not, suspend
-		pMutex->Wait();		// make sure no other process is using the pipeline, if not grab it
+	pMutex->Wait();		// make sure no other process is using the pipeline, if not grab it
 
-		if (PipePointer->WritingIndex == PipePointer->SizeOfPipe)			// if we have GONE PAST the end of the pipeline buffer
-			PipePointer->WritingIndex = 0;									// reset it back to the start
+	while (Size > 0) {
+		UINT Free = PipePointer->SizeOfPipe - PipePointer->NumBytes;
+
+		if (Free == 0) {								// pipeline full, park until a reader makes some space
+			++(PipePointer->WritersWaiting);
+			pMutex->Signal();
+			pConSemaphore->Wait();
+			pMutex->Wait();
+			continue;									// re-check, another writer may have got in first
+		}
 
-		DataPointer[(PipePointer->WritingIndex)++] = *(BYTE*)(Addr++);	// store next byte
-		++(PipePointer->NumBytes);										// Increment count of bytes in pipeline
+		UINT Chunk = (Size < Free) ? Size : Free;
+		UINT Index = PipePointer->WritingIndex % PipePointer->SizeOfPipe;
+		UINT First = PipePointer->SizeOfPipe - Index;	// bytes available before the end of the buffer
 
-		pMutex->Signal();													// release the process/thread blocking mutex
-		pProdSemaphore->Signal();											// wake it up after the write operation
+		if (First > Chunk)
+			First = Chunk;
 
+		memcpy(DataPointer + Index, Addr, First);				// store the block up to the end of the buffer
+		memcpy(DataPointer, Addr + First, Chunk - First);		// and the rest from the start if it wrapped
+
+		PipePointer->WritingIndex = (Index + Chunk) % PipePointer->SizeOfPipe;
+		PipePointer->NumBytes += Chunk;							// Increment count of bytes in pipeline
+		Addr += Chunk;
+		Size -= Chunk;
+
+		if (PipePointer->ReadersWaiting > 0) {					// wake up any readers parked on an empty pipeline
+			pProdSemaphore->Signal(PipePointer->ReadersWaiting);
+			PipePointer->ReadersWaiting = 0;
+		}
 	}
+
+	pMutex->Signal();	// release the process/thread blocking mutex
 	return TRUE;
 }
 
@@ -1316,6 +1362,8 @@ BOOL CPipe::Write(void* Data, UINT Size)	// producer process
 //	Note that a process/thread reading from an empty pipeline will be suspended until
 //	the process at the other end of the pipeline writes some in
 //
+//	As with Write(), whatever is already in the pipeline is copied out in one block.
+//
 
 //##ModelId=3DE6123C03B7
 BOOL CPipe::Read(void* Data, UINT Size)
@@ -1328,20 +1376,41 @@ BOOL CPipe::Read(void* Data, UINT Size)
 
 	LPBYTE	Addr = (LPBYTE)(Data);								// cast from void to byte pointer
 
-	for (UINT i = 0; i < Size; i++) {
-		pProdSemaphore->Wait();								// make sure there is data to read in the pipeline, if not suspend
-		pMutex->Wait();										// make sure no other process is using the pipeline, if not grab it
+	pMutex->Wait();										// make sure no other process is using the pipeline, if not grab it
 
-		if (PipePointer->ReadingIndex == PipePointer->SizeOfPipe)			// if we have GONE PAST the end of the pipeline buffer
-			PipePointer->ReadingIndex = 0;		// reset it back to the start
+	while (Size > 0) {
+		UINT Avail = PipePointer->NumBytes;
+
+		if (Avail == 0) {									// pipeline empty, park until a writer puts something in
+			++(PipePointer->ReadersWaiting);
+			pMutex->Signal();
+			pProdSemaphore->Wait();
+			pMutex->Wait();
+			continue;
+		}
 
-		*(BYTE*)(Addr++) = DataPointer[(PipePointer->ReadingIndex)++];		// read and store next byte
-		--(PipePointer->NumBytes);							// decrement count of bytes in pipeline
+		UINT Chunk = (Size < Avail) ? Size : Avail;
+		UINT Index = PipePointer->ReadingIndex % PipePointer->SizeOfPipe;
+		UINT First = PipePointer->SizeOfPipe - Index;
 
-		pMutex->Signal();									// release the process/thread blocking mutex
-		pConSemaphore->Signal();								// wake it up after the write operation
+		if (First > Chunk)
+			First = Chunk;
 
+		memcpy(Addr, DataPointer + Index, First);				// read the block up to the end of the buffer
+		memcpy(Addr + First, DataPointer, Chunk - First);		// and the rest from the start if it wrapped
+
+		PipePointer->ReadingIndex = (Index + Chunk) % PipePointer->SizeOfPipe;
+		PipePointer->NumBytes -= Chunk;							// decrement count of bytes in pipeline
+		Addr += Chunk;
+		Size -= Chunk;
+
+		if (PipePointer->WritersWaiting > 0) {					// wake up any writers parked on a full pipeline
+			pConSemaphore->Signal(PipePointer->WritersWaiting);
+			PipePointer->WritersWaiting = 0;
+		}
 	}
+
+	pMutex->Signal();									// release the process/thread blocking mutex
 	return TRUE;
 }
 
@@ -1359,6 +1428,8 @@ UINT CPipe::TestForData() const
 	return NumBytesInPipe;
 }
 
+#ifdef _WIN32
+
 //
 //	Constructor creates a named datapool object with a 
 //specified size
@@ -1783,6 +1854,8 @@ int TEXT_COLOUR(unsigned char foreground, unsigned char background)
 }
 
 
+#endif // _WIN32
+
 void flush(istream& is)		// can be used to flush an input stream, useful for removing operator entered rubbish
 {
 	is.clear();
@@ -1792,6 +1865,8 @@ void flush(istream& is)		// can be used to flush an input stream, useful for rem
 	is.clear();
 }
 
+#ifdef _WIN32
+
 void PERR(bool bSuccess, string ErrorMessageString)
 {
 	UINT LastError = GetLastError();
@@ -1809,4 +1884,6 @@ void PERR(bool bSuccess, string ErrorMessageString)
 		printf("\n\nPress Return to Continue...");
 		_getch();
 	}
-}
\ No newline at end of file
+}
+
+#endif // _WIN32
@@ -30,11 +30,15 @@
 #ifndef	__RT__
 #define __RT__
 
+#ifdef _WIN32
 #include <process.h>	// for spawnl and createthread
 #include <windows.h>	// for perror and sleep
+#include <conio.h>		// for _kbhit(), getch() and getche()
+#else
+#include "rt_posix.h"	// Win32 types and constants used below, implemented in rt_posix.cpp
+#endif
 #include <stdio.h>		// for printf
 #include <limits.h>		// for UINT_MAX
-#include <conio.h>		// for _kbhit(), getch() and getche()
 #include <iostream>
 #include <string>
 
@@ -48,7 +52,11 @@
 //	To overcome this MFC provides the concept of thread local storage of TLS (see help) 
 //  thus we define 'Thread' as a type specific modifier
 
+#ifdef _WIN32
 #define PerThreadStorage  __declspec(thread)
+#else
+#define PerThreadStorage  thread_local
+#endif
 #define _CRT_SECURE_NO_WARNINGS	
 
 
@@ -2132,6 +2140,8 @@ private:
 		UINT	SizeOfPipe;
 		UINT	ReadingIndex;		// index in the data array that marks the index of the next char to be read
 		UINT	WritingIndex;		// index into data array that marks the index of the next char to be written
+		UINT	ReadersWaiting;		// number of readers parked on the producer semaphore waiting for data
+		UINT	WritersWaiting;		// number of writers parked on the consumer semaphore waiting for space
 		BOOL	Initialised;		// indicates whether data structure has been initialised or not.
 	} PIPECONTROL;
 
@@ -2146,9 +2156,9 @@ private:
 	//##ModelId=3DE6123C0370
 	CMutex* pMutex;					// handle for the mutual exclusion semaphore in the pipeline
 	//##ModelId=3DE6123C037A
-	CSemaphore* pProdSemaphore;			// handle for the producer semaphore in the pipeline
+	CSemaphore* pProdSemaphore;			// wakes readers parked on an empty pipeline, signalled once per parked reader
 	//##ModelId=3DE6123C038E
-	CSemaphore* pConSemaphore;			// handle for the consumer semaphore in the pipeline
+	CSemaphore* pConSemaphore;			// wakes writers parked on a full pipeline, signalled once per parked writer
 
 	//##ModelId=3DE6123C03A2
 	const std::string PipeName;
@@ -0,0 +1,1193 @@
+#include "rt.h"
+
+#ifndef _WIN32		// the Win32 versions of everything in this file are in rt.cpp
+
+#include "futex.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/select.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+extern char** environ;
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+//	Named shared memory
+//
+//	Every named object (data pools, pipelines, mutexes, semaphores, events and conditions) is
+//	a POSIX shared memory object, so that it can be opened by name from any process just like
+//	its Win32 counterpart. Win32 destroys a named object when the last handle to it is closed
+//	and creates a fresh, zeroed one the next time, whereas a POSIX object outlives the processes
+//	that use it (even when they are killed with Ctrl-C). To get the Win32 behaviour back, each
+//	object starts with a small header recording which processes have it open: a process that
+//	links to an object nobody alive has open gets it zeroed and initialised, and the last
+//	process to unlink removes it. The header is only changed while holding flock() on the object.
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+const int MAX_LINKED_PROCESSES = 64;
+
+struct SharedHeader {
+	pid_t	Pids[MAX_LINKED_PROCESSES];		// processes linked to the object, 0 = free entry
+	int		Links[MAX_LINKED_PROCESSES];	// number of times each of them has linked to it
+};
+
+// keeps the user's data 64 byte aligned
+const size_t HEADER_SIZE = (sizeof(SharedHeader) + 63) & ~size_t(63);
+
+struct SharedMemory {
+	string	ShmName;
+	int		fd;
+	size_t	Size;			// bytes mapped, including the header
+	BYTE* Base;
+
+	SharedHeader* Header() const { return (SharedHeader*)Base; }
+	void* Data() const { return Base + HEADER_SIZE; }
+};
+
+string
+shmName(const char* kind, const string& Name)
+{
+	string name = "/rt." + to_string(getuid()) + "." + kind + ".";
+	for (char c : Name)
+		name += (c == '/') ? '_' : c;
+	return name;
+}
+
+bool
+isAlive(pid_t pid)
+{
+	return kill(pid, 0) == 0 || errno == EPERM;
+}
+
+//	Opens (creating it if need be) the named object and links this process to it. When no live
+//	process had it open, the data is zeroed and Init is run on it before anybody else can see it.
+//	Returns NULL on failure with errno set.
+
+SharedMemory*
+linkShared(const char* kind, const string& Name, size_t size, const function<void(void*)>& Init = nullptr)
+{
+	const string ShmName = shmName(kind, Name);
+	const size_t Size = HEADER_SIZE + size;
+	int fd;
+	struct stat st;
+
+	for (;;) {
+		fd = shm_open(ShmName.c_str(), O_RDWR | O_CREAT, 0600);
+		if (fd < 0)
+			return NULL;
+		flock(fd, LOCK_EX);
+
+		// the last user might have removed the object between our open and our lock
+		if (fstat(fd, &st) == 0 && st.st_nlink > 0)
+			break;
+		close(fd);
+	}
+
+	size_t MappedSize = Size;
+	if ((size_t)st.st_size < Size) {
+		if (ftruncate(fd, Size) != 0) {
+			close(fd);
+			return NULL;
+		}
+	}
+	else
+		MappedSize = st.st_size;
+
+	BYTE* Base = (BYTE*)mmap(NULL, MappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (Base == MAP_FAILED) {
+		close(fd);
+		return NULL;
+	}
+
+	SharedMemory* sm = new SharedMemory{ ShmName, fd, MappedSize, Base };
+	SharedHeader* h = sm->Header();
+	const pid_t me = getpid();
+	int MySlot = -1, FreeSlot = -1;
+	bool InUse = false;
+
+	for (int i = 0; i < MAX_LINKED_PROCESSES; i++) {
+		if (h->Pids[i] == me)
+			MySlot = i;
+		else if (h->Pids[i] != 0 && isAlive(h->Pids[i]))
+			InUse = true;
+		else {							// free, or left behind by a process that died
+			h->Pids[i] = 0;
+			h->Links[i] = 0;
+		}
+		if (h->Pids[i] == 0 && FreeSlot < 0)
+			FreeSlot = i;
+	}
+
+	if (!InUse && MySlot < 0) {			// nobody has it open, so this is a brand new object
+		memset(sm->Data(), 0, MappedSize - HEADER_SIZE);
+		if (Init)
+			Init(sm->Data());
+	}
+
+	if (MySlot < 0) {
+		MySlot = FreeSlot;
+		if (MySlot < 0) {
+			munmap(Base, MappedSize);
+			close(fd);
+			delete sm;
+			errno = EMFILE;
+			return NULL;
+		}
+		h->Pids[MySlot] = me;
+	}
+	h->Links[MySlot]++;
+
+	flock(fd, LOCK_UN);
+	return sm;
+}
+
+//	Undoes linkShared(); the object is removed when no process has it open any more
+
+BOOL
+unlinkShared(SharedMemory* sm)
+{
+	if (sm == NULL)
+		return FALSE;
+
+	flock(sm->fd, LOCK_EX);
+
+	SharedHeader* h = sm->Header();
+	const pid_t me = getpid();
+	bool InUse = false;
+
+	for (int i = 0; i < MAX_LINKED_PROCESSES; i++) {
+		if (h->Pids[i] == me && --h->Links[i] <= 0) {
+			h->Pids[i] = 0;
+			h->Links[i] = 0;
+		}
+		if (h->Pids[i] != 0 && isAlive(h->Pids[i]))
+			InUse = true;
+	}
+
+	if (!InUse)
+		shm_unlink(sm->ShmName.c_str());
+
+	flock(sm->fd, LOCK_UN);
+	munmap(sm->Base, sm->Size);
+	close(sm->fd);
+	delete sm;
+	return TRUE;
+}
+
+template <class State>
+State*
+stateOf(HANDLE h)
+{
+	return (State*)(((SharedMemory*)h)->Data());
+}
+
+//	Converts a Win32 style timeout into a deadline that waits can count down against
+
+class Deadline {
+	const DWORD Time;
+	const chrono::steady_clock::time_point Start;
+
+public:
+	explicit Deadline(DWORD time) : Time(time), Start(chrono::steady_clock::now()) {}
+
+	// mSecs left, INFINITE if there is no deadline and 0 once it has passed
+	DWORD Remaining() const
+	{
+		if (Time == INFINITE)
+			return INFINITE;
+		auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - Start).count();
+		return (elapsed >= (long long)Time) ? 0 : Time - (DWORD)elapsed;
+	}
+};
+
+uint32_t
+currentThreadId()
+{
+	static thread_local uint32_t tid = (uint32_t)syscall(SYS_gettid);
+	return tid;
+}
+
+}	// namespace
+
+
+////////////////////////////////////////////////////////////////////////////////////////////
+//	Process Functions
+////////////////////////////////////////////////////////////////////////////////////////////
+
+CProcess::CProcess(
+	const string& Name,		// path/name of executable program
+	int Priority,			// Priority of the process
+	BOOL bUseNewWindow,		// ignored, a terminal cannot open a new window for the child
+	BOOL bCreateSuspended,	// use SUSPENDED to make new child process stopped when it is created
+	const string& ChildProcessArgString)
+
+	: ProcessName(Name)
+{
+	PERR(((Priority == HIGH_PRIORITY_CLASS) ||
+		(Priority == IDLE_PRIORITY_CLASS) ||
+		(Priority == NORMAL_PRIORITY_CLASS) ||
+		(Priority == REALTIME_PRIORITY_CLASS)),
+		string("Illegal 2nd Argument (Process Priority) for Process: ") + Name);
+	PERR((bUseNewWindow == OWN_WINDOW || bUseNewWindow == PARENT_WINDOW),
+		string("Use OWN_WINDOW or PARENT_WINDOW as 3rd argument for Process: ") + Name);
+	PERR((bCreateSuspended == SUSPENDED || bCreateSuspended == ACTIVE),
+		string("Use SUSPENDED or ACTIVE as 4th Argument for Process: ") + Name);
+
+	// argv[0] is the program, followed by the space separated arguments
+
+	vector<string> Args = { Name };
+	istringstream ArgStream(ChildProcessArgString);
+	for (string Arg; ArgStream >> Arg; )
+		Args.push_back(Arg);
+
+	vector<char*> argv;
+	for (string& Arg : Args)
+		argv.push_back(&Arg[0]);
+	argv.push_back(NULL);
+
+	pid_t pid = 0;
+	int Result = posix_spawnp(&pid, Name.c_str(), NULL, NULL, argv.data(), environ);
+	errno = Result;
+	PERR(Result == 0, string("CProcess Call Unable to Create New Process: ") + Name);	// check for error and print message if appropriate
+
+	pInfo.hProcess = (Result == 0) ? (HANDLE)(intptr_t)pid : NULL;
+	pInfo.hThread = NULL;
+	pInfo.dwProcessId = pid;
+	pInfo.dwThreadId = pid;
+
+	if (Result == 0 && bCreateSuspended == SUSPENDED)
+		Suspend();
+	if (Result == 0 && Priority != NORMAL_PRIORITY_CLASS)
+		SetPriority(Priority);
+}
+
+//	Process priority classes are mapped onto nice values. Raising the priority above normal
+//	needs the privilege to do so, as it does on Windows.
+
+BOOL CProcess::SetPriority(int Priority) const
+{
+	int Nice;
+
+	switch (Priority) {
+	case IDLE_PRIORITY_CLASS:		Nice = 19;	break;
+	case NORMAL_PRIORITY_CLASS:		Nice = 0;	break;
+	case HIGH_PRIORITY_CLASS:		Nice = -10;	break;
+	case REALTIME_PRIORITY_CLASS:	Nice = -20;	break;
+	default:
+		PERR(false, string("Illegal Priority value in call to SetPiority()"));
+		return FALSE;
+	}
+
+	BOOL Success = setpriority(PRIO_PROCESS, GetProcessId(), Nice) == 0;
+	PERR(Success == TRUE, string("Unable to Set Thread Priority of Process: ") + ProcessName);	// check for error and print error message as appropriate
+	return Success;
+}
+
+BOOL CProcess::Suspend() const
+{
+	BOOL Success = kill(GetProcessId(), SIGSTOP) == 0;
+	PERR(Success == TRUE, string("Cannot Suspend Process: ") + ProcessName);
+	return Success;
+}
+
+BOOL CProcess::Resume() const
+{
+	BOOL Success = kill(GetProcessId(), SIGCONT) == 0;
+	PERR(Success == TRUE, string("Cannot Resume Process: ") + ProcessName);
+	return Success;
+}
+
+//	Returns WAIT_OBJECT_0 once the child has terminated (or had already terminated),
+//	WAIT_TIMEOUT if the time elapsed first and WAIT_FAILED on error
+
+BOOL	CProcess::WaitForProcess(DWORD Time) const
+{
+	const pid_t pid = GetProcessId();
+	Deadline deadline(Time);
+	UINT Result = WAIT_TIMEOUT;
+
+	for (;;) {
+		pid_t Done = waitpid(pid, NULL, (Time == INFINITE) ? 0 : WNOHANG);
+		if (Done == pid || (Done < 0 && errno == ECHILD)) {
+			Result = WAIT_OBJECT_0;
+			break;
+		}
+		if (Done < 0 && errno != EINTR) {
+			Result = WAIT_FAILED;
+			break;
+		}
+		if (Time != INFINITE && deadline.Remaining() == 0)
+			break;
+		if (Time != INFINITE)
+			SLEEP(1);
+	}
+
+	PERR(Result != WAIT_FAILED, string("Cannot Wait for Child Process: ") + ProcessName + string(" to Terminate.\n It might already be dead"));
+	return Result;
+}
+
+//	There are no thread message queues on POSIX, see CMailbox
+
+BOOL CProcess::Post(UINT Message) const
+{
+	PERR(false, string("Could not Signal Process:") + ProcessName + string("\nReason: Messages are not supported on this platform"));
+	return FALSE;
+}
+
+void CProcess::Exit(UINT ExitCode) const
+{
+	exit(ExitCode);
+}
+
+BOOL TerminateProcess(HANDLE hProcess, UINT uExitCode)
+{
+	if (hProcess == NULL)
+		return FALSE;
+	return kill((pid_t)(intptr_t)hProcess, SIGKILL) == 0;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////
+//	Thread Functions
+//
+//	A thread handle points to the PosixThread below, which the CThread object and the running
+//	thread both hold a reference to. The thread is created detached and first waits for the
+//	Started gate, which Resume() opens; this is how SUSPENDED threads, and therefore active
+//	classes, are held back until their constructors have finished.
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+struct PosixThread {
+	UINT(__stdcall* Function)(void*);
+	void* Args;
+	mutex Lock;
+	condition_variable Changed;
+	bool Started = false;		// the gate opened by Resume()
+	bool Cancelled = false;		// terminated before it ever ran
+	bool Finished = false;
+	UINT ExitCode = 0;
+	int References = 2;			// the CThread and the running thread
+};
+
+thread_local PosixThread* RunningThread = NULL;
+
+atomic<UINT> NextThreadID(1);
+
+void
+releaseThread(PosixThread* t)
+{
+	bool Last;
+	{
+		lock_guard<mutex> lock(t->Lock);
+		Last = (--t->References == 0);
+	}
+	if (Last)
+		delete t;
+}
+
+//	Marks the thread finished however it ends, by returning or through CThread::Exit()
+
+struct ThreadFinisher {
+	PosixThread* t;
+	~ThreadFinisher()
+	{
+		{
+			lock_guard<mutex> lock(t->Lock);
+			t->Finished = true;
+		}
+		t->Changed.notify_all();
+		releaseThread(t);
+	}
+};
+
+void*
+posixThreadMain(void* args)
+{
+	PosixThread* t = (PosixThread*)args;
+	ThreadFinisher finisher = { t };
+
+	{
+		unique_lock<mutex> lock(t->Lock);
+		t->Changed.wait(lock, [t] { return t->Started; });
+		if (t->Cancelled)
+			return NULL;
+	}
+
+	RunningThread = t;
+	t->ExitCode = t->Function(t->Args);
+	return NULL;
+}
+
+HANDLE
+createThread(UINT(__stdcall* Function)(void*), void* Args, BOOL bCreateState, UINT& ThreadID)
+{
+	PosixThread* t = new PosixThread;
+	t->Function = Function;
+	t->Args = Args;
+	t->Started = (bCreateState != SUSPENDED);
+
+	pthread_attr_t attr;
+	pthread_t id;
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	int Result = pthread_create(&id, &attr, posixThreadMain, t);
+	pthread_attr_destroy(&attr);
+
+	errno = Result;
+	PERR(Result == 0, string("Unable to Create Thread"));	// check for error and print message if appropriate
+	if (Result != 0) {
+		delete t;
+		return NULL;
+	}
+
+	ThreadID = NextThreadID++;
+	return (HANDLE)t;
+}
+
+UINT __stdcall
+activeClassMain(void* theThreadPtr)	// receives a pointer to the thread object
+{
+	return ((ActiveClass*)(theThreadPtr))->main();	// run the activeclass virtual main function
+}
+
+}	// namespace
+
+CThread::CThread(UINT __stdcall Function(void*), BOOL bCreateState, void* ThreadArgs)
+{
+	ThreadHandle = createThread(Function, ThreadArgs, bCreateState, ThreadID);
+}
+
+CThread::CThread(BOOL bCreateState)
+{
+	ThreadHandle = createThread(activeClassMain, this, bCreateState, ThreadID);
+}
+
+ActiveClass::ActiveClass()
+	: CThread(),		// created SUSPENDED, see the Win32 version in rt.cpp for why
+	TerminateFlag(FALSE)
+{}
+
+ActiveClass::~ActiveClass()
+{}
+
+void CThread::Exit(UINT ExitCode) const
+{
+	if (RunningThread != NULL)
+		RunningThread->ExitCode = ExitCode;
+	pthread_exit(NULL);
+}
+
+//	A running pthread cannot be stopped from outside, so only a thread that has not yet been
+//	resumed can be suspended
+
+BOOL CThread::Suspend() const
+{
+	PosixThread* t = (PosixThread*)ThreadHandle;
+	BOOL Success = FALSE;
+
+	if (t != NULL) {
+		lock_guard<mutex> lock(t->Lock);
+		Success = !t->Started;
+	}
+	PERR(Success == TRUE, string("Cannot Suspend Thread\n"));	// check for error and print message if appropriate
+	return Success;
+}
+
+BOOL CThread::Resume() const
+{
+	PosixThread* t = (PosixThread*)ThreadHandle;
+
+	PERR(t != NULL, string("Cannot Resume Thread\n"));	// check for error and print message if appropriate
+	if (t == NULL)
+		return FALSE;
+
+	{
+		lock_guard<mutex> lock(t->Lock);
+		t->Started = true;
+	}
+	t->Changed.notify_all();
+	return TRUE;
+}
+
+//	Thread priorities within a normal process need real-time scheduling on Linux, so the
+//	value is checked and then ignored
+
+BOOL CThread::SetPriority(UINT Priority) const
+{
+	int p = (int)Priority;
+	BOOL Success = ((p == THREAD_PRIORITY_ABOVE_NORMAL) ||
+		(p == THREAD_PRIORITY_BELOW_NORMAL) ||
+		(p == THREAD_PRIORITY_HIGHEST) ||
+		(p == THREAD_PRIORITY_IDLE) ||
+		(p == THREAD_PRIORITY_LOWEST) ||
+		(p == THREAD_PRIORITY_NORMAL) ||
+		(p == THREAD_PRIORITY_TIME_CRITICAL));
+
+	PERR(Success == TRUE, string("Illegal Priority value specified for Thread in call to CThread::SetPriority()"));
+	return Success;
+}
+
+UINT CThread::WaitForThread(DWORD Time) const
+{
+	PosixThread* t = (PosixThread*)ThreadHandle;
+
+	PERR(t != NULL, string("Cannot Wait For Thread"));	// check for error and print error message as appropriate
+	if (t == NULL)
+		return WAIT_FAILED;
+
+	unique_lock<mutex> lock(t->Lock);
+	if (Time == INFINITE) {
+		t->Changed.wait(lock, [t] { return t->Finished; });
+		return WAIT_OBJECT_0;
+	}
+	return t->Changed.wait_for(lock, chrono::milliseconds(Time), [t] { return t->Finished; }) ? WAIT_OBJECT_0 : WAIT_TIMEOUT;
+}
+
+BOOL CThread::Post(UINT Message) const
+{
+	PERR(false, string("Could not Post User Message: Messages are not supported on this platform"));
+	return FALSE;
+}
+
+BOOL TerminateThread(HANDLE hThread, DWORD dwExitCode)
+{
+	PosixThread* t = (PosixThread*)hThread;
+	if (t == NULL)
+		return FALSE;
+
+	{
+		lock_guard<mutex> lock(t->Lock);
+		if (!t->Started) {			// never resumed, let it end without running
+			t->Started = true;
+			t->Cancelled = true;
+			t->ExitCode = dwExitCode;
+		}
+	}
+	t->Changed.notify_all();
+	releaseThread(t);
+	return TRUE;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////
+//	Mutex Functions
+//
+//	A futex word that is 0 when free, 1 when locked and 2 when locked with threads (possibly in
+//	other processes) asleep on it. Like a Win32 mutex it is owned by a thread and may be
+//	re-acquired recursively by its owner.
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+struct MutexState {
+	atomic<uint32_t> Word;
+	atomic<uint32_t> Owner;		// kernel thread id of the owner, 0 if none
+	uint32_t Recursion;			// only touched by the owner
+};
+
+}	// namespace
+
+CMutex::CMutex(const string& Name, BOOL bOwned)
+	:MutexName(Name)
+{
+	const uint32_t me = currentThreadId();
+	MutexHandle = linkShared("mutex", Name, sizeof(MutexState), [&](void* p) {
+		MutexState* m = (MutexState*)p;
+		if (bOwned == OWNED) {		// only the creator of a mutex can own it, as on Win32
+			m->Word = 1;
+			m->Owner = me;
+			m->Recursion = 1;
+		}
+	});
+	PERR(MutexHandle != NULL, string("Cannot Create Mutex: ") + Name);	// check for error and print message if appropriate
+}
+
+BOOL	CMutex::Unlink() const
+{
+	BOOL Success = unlinkShared((SharedMemory*)MutexHandle);
+	PERR(Success == TRUE, string("Cannot Unlink from Mutex:") + MutexName);	// check for error and print message if appropriate
+	return Success;
+}
+
+UINT CMutex::Wait(DWORD Time) const
+{
+	MutexState* m = stateOf<MutexState>(MutexHandle);
+	const uint32_t me = currentThreadId();
+
+	if (m->Owner.load(memory_order_relaxed) == me) {
+		m->Recursion++;
+		return WAIT_OBJECT_0;
+	}
+
+	uint32_t c = 0;
+	if (!m->Word.compare_exchange_strong(c, 1, memory_order_acquire)) {
+		Deadline deadline(Time);
+		if (c != 2)
+			c = m->Word.exchange(2, memory_order_acquire);
+		while (c != 0) {
+			DWORD Remaining = deadline.Remaining();
+			if (Remaining == 0)
+				return WAIT_TIMEOUT;
+			futexWait(&m->Word, 2, Remaining);
+			c = m->Word.exchange(2, memory_order_acquire);
+		}
+	}
+
+	m->Owner.store(me, memory_order_relaxed);
+	m->Recursion = 1;
+	return WAIT_OBJECT_0;
+}
+
+BOOL CMutex::Signal() const
+{
+	MutexState* m = stateOf<MutexState>(MutexHandle);
+
+	if (m->Owner.load(memory_order_relaxed) != currentThreadId()) {		// Win32 refuses to release a mutex the caller does not own
+		PERR(false, string("Cannot Perfom SIGNAL operation on Mutex: ") + MutexName);
+		return FALSE;
+	}
+
+	if (--m->Recursion > 0)
+		return TRUE;
+
+	m->Owner.store(0, memory_order_relaxed);
+	if (m->Word.exchange(0, memory_order_release) == 2)
+		futexWakeOne(&m->Word);
+	return TRUE;
+}
+
+BOOL CMutex::Read() const
+{
+	if (Wait(0) != WAIT_OBJECT_0)
+		return FALSE;
+	Signal();
+	return TRUE;
+}
+
+
+////////////////////////////////////////////////////////////
+//	Event Functions
+//
+//	Signal() behaves like PulseEvent(): it releases the threads waiting at the time (all of
+//	them for a MULTIPLE_RELEASE event, one for SINGLE_RELEASE) and leaves the event
+//	not signalled. Waiters sleep on a generation count that every pulse advances.
+////////////////////////////////////////////////////////////
+
+namespace {
+
+struct EventState {
+	atomic<uint32_t> Generation;
+	atomic<uint32_t> Waiters;
+	atomic<uint32_t> Signalled;		// initial SIGNALLED state, cleared by the first pulse
+	atomic<uint32_t> Releases;		// threads a SINGLE_RELEASE pulse may still let through
+	uint32_t Manual;
+};
+
+}	// namespace
+
+CEvent::CEvent(const string& Name, BOOL bType, BOOL bState)
+	:EventName(Name)
+{
+	PERR(bState == SIGNALLED || bState == NOTSIGNALLED, string("Illegal Signalled/NotSignalled Type specified when creating CEvent: ") + EventName);
+	PERR(bType == SINGLE_RELEASE || bType == MULTIPLE_RELEASE, string("Illegal Single or Multithread Type specified when creating CEvent: ") + EventName);
+
+	EventHandle = linkShared("event", Name, sizeof(EventState), [&](void* p) {
+		EventState* e = (EventState*)p;
+		e->Manual = (bType != SINGLE_RELEASE);
+		e->Signalled = (bState == SIGNALLED);
+	});
+	PERR(EventHandle != NULL, string("Cannot Create CEvent: ") + Name);	// check for error and print message if appropriate
+}
+
+BOOL CEvent::Unlink() const {
+	BOOL Success = unlinkShared((SharedMemory*)EventHandle);
+	PERR(Success != 0, string("Cannot Unlink the CEvent: ") + EventName);	// check for error and print message if appropriate
+	return Success;
+}
+
+BOOL CEvent::Signal() const
+{
+	EventState* e = stateOf<EventState>(EventHandle);
+
+	e->Signalled.store(0, memory_order_relaxed);
+
+	uint32_t Waiting = e->Waiters.load(memory_order_seq_cst);
+	if (Waiting == 0)				// nobody to release
+		return TRUE;
+
+	if (!e->Manual) {
+		uint32_t r = e->Releases.load(memory_order_relaxed);
+		while (r < Waiting && !e->Releases.compare_exchange_weak(r, r + 1, memory_order_relaxed))
+			;
+	}
+	e->Generation.fetch_add(1, memory_order_seq_cst);
+	futexWakeAll(&e->Generation);
+	return TRUE;
+}
+
+UINT CEvent::Wait(DWORD Time) const
+{
+	EventState* e = stateOf<EventState>(EventHandle);
+
+	if (e->Manual) {
+		if (e->Signalled.load(memory_order_acquire))
+			return WAIT_OBJECT_0;
+	}
+	else {
+		uint32_t one = 1;
+		if (e->Signalled.compare_exchange_strong(one, 0, memory_order_acquire))
+			return WAIT_OBJECT_0;
+	}
+
+	Deadline deadline(Time);
+	uint32_t Seen = e->Generation.load(memory_order_seq_cst);
+	e->Waiters.fetch_add(1, memory_order_seq_cst);
+
+	UINT Result = WAIT_TIMEOUT;
+	for (;;) {
+		uint32_t Now = e->Generation.load(memory_order_acquire);
+		if (Now != Seen) {
+			if (e->Manual) {
+				Result = WAIT_OBJECT_0;
+				break;
+			}
+			uint32_t r = e->Releases.load(memory_order_relaxed);
+			while (r > 0 && !e->Releases.compare_exchange_weak(r, r - 1, memory_order_acquire))
+				;
+			if (r > 0) {
+				Result = WAIT_OBJECT_0;
+				break;
+			}
+			Seen = Now;			// another thread took the release, keep waiting
+		}
+		DWORD Remaining = deadline.Remaining();
+		if (Remaining == 0)
+			break;
+		futexWait(&e->Generation, Seen, Remaining);
+	}
+
+	e->Waiters.fetch_sub(1, memory_order_relaxed);
+	return Result;
+}
+
+
+////////////////////////////////////////////////////////////
+//	Condition Functions
+//
+//	Signal() sets the condition and wakes every waiter, Reset() clears it. A MANUAL condition
+//	lets every thread through while it is set, an AUTORESET one lets exactly one through and
+//	clears itself.
+////////////////////////////////////////////////////////////
+
+namespace {
+
+struct ConditionState {
+	atomic<uint32_t> Signalled;
+	atomic<uint32_t> Generation;
+	atomic<uint32_t> Waiters;
+	uint32_t Manual;
+};
+
+bool
+takeCondition(ConditionState* c)
+{
+	if (c->Manual)
+		return c->Signalled.load(memory_order_seq_cst) != 0;
+
+	uint32_t one = 1;
+	return c->Signalled.compare_exchange_strong(one, 0, memory_order_seq_cst);
+}
+
+}	// namespace
+
+CCondition::CCondition(const string& Name, BOOL bType, BOOL bState)
+	:ConditionName(Name)
+{
+	PERR(bState == SIGNALLED || bState == NOTSIGNALLED, string("Illegal Signalled/NotSignalled Type specified when creating CCondition: ") + ConditionName);
+	PERR(bType == MANUAL || bType == AUTORESET, string("Illegal Signalled/NotSignalled Type specified when creating CCondition: ") + ConditionName);
+
+	ConditionHandle = linkShared("condition", Name, sizeof(ConditionState), [&](void* p) {
+		ConditionState* c = (ConditionState*)p;
+		c->Manual = (bType == MANUAL);
+		c->Signalled = (bState == SIGNALLED);
+	});
+	PERR(ConditionHandle != NULL, string("Cannot Create CCondition: ") + Name);	// check for error and print message if appropriate
+}
+
+BOOL CCondition::Unlink() const {
+	BOOL Success = unlinkShared((SharedMemory*)ConditionHandle);
+	PERR(Success != 0, string("Cannot Unlink the CCondition: ") + ConditionName);	// check for error and print message if appropriate
+	return Success;
+}
+
+BOOL CCondition::Signal() const {
+	ConditionState* c = stateOf<ConditionState>(ConditionHandle);
+
+	c->Signalled.store(1, memory_order_seq_cst);
+	c->Generation.fetch_add(1, memory_order_seq_cst);
+	if (c->Waiters.load(memory_order_seq_cst) != 0)
+		futexWakeAll(&c->Generation);
+	return TRUE;
+}
+
+UINT CCondition::Wait(DWORD Time) const
+{
+	ConditionState* c = stateOf<ConditionState>(ConditionHandle);
+	Deadline deadline(Time);
+
+	for (;;) {
+		if (takeCondition(c))
+			return WAIT_OBJECT_0;
+
+		DWORD Remaining = deadline.Remaining();
+		if (Remaining == 0)
+			return WAIT_TIMEOUT;
+
+		uint32_t Seen = c->Generation.load(memory_order_seq_cst);
+		c->Waiters.fetch_add(1, memory_order_seq_cst);
+		if (c->Signalled.load(memory_order_seq_cst) == 0)
+			futexWait(&c->Generation, Seen, Remaining);
+		c->Waiters.fetch_sub(1, memory_order_relaxed);
+	}
+}
+
+BOOL CCondition::Reset() const
+{
+	stateOf<ConditionState>(ConditionHandle)->Signalled.store(0, memory_order_seq_cst);
+	return TRUE;
+}
+
+BOOL CCondition::Test() const
+{
+	return takeCondition(stateOf<ConditionState>(ConditionHandle)) ? TRUE : FALSE;
+}
+
+
+////////////////////////////////////////////////////////////
+//	Semaphore Functions
+////////////////////////////////////////////////////////////
+
+namespace {
+
+struct SemaphoreState {
+	atomic<uint32_t> Count;
+	atomic<uint32_t> Waiters;
+	uint32_t Max;
+};
+
+}	// namespace
+
+//	As on Win32 the initial and maximum values only count for the process that creates the
+//	semaphore; later processes simply link to it
+
+CSemaphore::CSemaphore(const string& Name, int InitialVal, int MaxVal)
+	:SemaphoreName(Name)
+{
+	SemaphoreHandle = linkShared("semaphore", Name, sizeof(SemaphoreState), [&](void* p) {
+		SemaphoreState* s = (SemaphoreState*)p;
+		s->Count = InitialVal;
+		s->Max = MaxVal;
+	});
+	PERR(SemaphoreHandle != NULL, string("Cannot Create Semaphore: ") + Name);	// check for error and print message if appropriate
+}
+
+BOOL	CSemaphore::Unlink() const
+{
+	BOOL Success = unlinkShared((SharedMemory*)SemaphoreHandle);
+	PERR(Success == TRUE, string("Cannot Unlink from Semaphore: ") + SemaphoreName);	// check for error and print message if appropriate
+	return Success;
+}
+
+UINT CSemaphore::Wait(DWORD Time) const
+{
+	SemaphoreState* s = stateOf<SemaphoreState>(SemaphoreHandle);
+	Deadline deadline(Time);
+
+	for (;;) {
+		uint32_t c = s->Count.load(memory_order_relaxed);
+		while (c > 0)
+			if (s->Count.compare_exchange_weak(c, c - 1, memory_order_acquire))
+				return WAIT_OBJECT_0;
+
+		DWORD Remaining = deadline.Remaining();
+		if (Remaining == 0)
+			return WAIT_TIMEOUT;
+
+		s->Waiters.fetch_add(1, memory_order_seq_cst);
+		if (s->Count.load(memory_order_seq_cst) == 0)
+			futexWait(&s->Count, 0, Remaining);
+		s->Waiters.fetch_sub(1, memory_order_relaxed);
+	}
+}
+
+BOOL CSemaphore::Signal(int Increment)	const
+{
+	SemaphoreState* s = stateOf<SemaphoreState>(SemaphoreHandle);
+	uint32_t c = s->Count.load(memory_order_relaxed);
+
+	do {
+		if (Increment <= 0 || (uint64_t)c + Increment > s->Max) {
+			PERR(false, string("Cannot Signal Semaphore: ") + SemaphoreName + string("\nMaxmimum Value may have been exceeded"));
+			return FALSE;
+		}
+	} while (!s->Count.compare_exchange_weak(c, c + Increment, memory_order_seq_cst));
+
+	if (s->Waiters.load(memory_order_seq_cst) != 0) {
+		if (Increment == 1)
+			futexWakeOne(&s->Count);
+		else
+			futexWakeAll(&s->Count);
+	}
+	return TRUE;
+}
+
+UINT CSemaphore::Read() const
+{
+	return stateOf<SemaphoreState>(SemaphoreHandle)->Count.load(memory_order_acquire);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////
+//	Pipeline Functions
+//
+//	Same layout and initialisation as the Win32 version in rt.cpp, with the two data pools
+//	made by linkShared()
+////////////////////////////////////////////////////////////////////////////////////////////
+
+CPipe::CPipe(const string& Name, UINT SizeOfPipe) :PipeName(Name)
+{
+	if (SizeOfPipe < 1) {
+		printf("Sorry Pipeline size is too small, Minimum is 1 byte.\n");
+		getchar();
+		exit(0);
+	}
+
+	const string PipeName = "__PipeLine__" + Name;
+	const string PipeDataName = "__PipeLineData__" + Name;
+	const string MutexName = "__PipelineMutex__" + Name;
+	const string ProdSemaName = "__PipelineProducerSemaphore__" + Name;
+	const string ConSemaName = "__PipelineConsumerSemaphore__" + Name;
+
+	SharedMemory* Pipe = linkShared("datapool", PipeName, sizeof(PIPECONTROL));
+	PERR(Pipe != NULL, string("Cannot Make Datapool For Pipeline ") + Name);
+	SharedMemory* Data = linkShared("datapool", PipeDataName, SizeOfPipe);
+	PERR(Data != NULL, string("Cannot Make Datapool For Pipeline ") + Name);
+
+	if (Pipe == NULL || Data == NULL)
+		exit(0);
+
+	hPipe = Pipe;
+	hData = Data;
+	PipePointer = (PIPECONTROL*)Pipe->Data();
+	DataPointer = (BYTE*)Data->Data();
+
+	pMutex = new CMutex(MutexName);
+	pProdSemaphore = new CSemaphore(ProdSemaName, 0, INT_MAX);
+	pConSemaphore = new CSemaphore(ConSemaName, 0, INT_MAX);
+
+	pMutex->Wait();
+	if (PipePointer->Initialised != 0x4afc) {		// if datapool not initialised
+		PipePointer->Initialised = 0x4afc;
+		PipePointer->ReadingIndex = 0;
+		PipePointer->WritingIndex = 0;
+		PipePointer->NumBytes = 0;
+		PipePointer->ReadersWaiting = 0;
+		PipePointer->WritersWaiting = 0;
+		PipePointer->SizeOfPipe = SizeOfPipe;
+	}
+	else {	// if it is initialised, make sure the size was specified the same in all processes creating it
+		PERR(SizeOfPipe == PipePointer->SizeOfPipe, string("Size of Pipeline Name:") + PipeName + string(" Conflicts with size already specified by another process"));
+		if (SizeOfPipe != PipePointer->SizeOfPipe)
+			exit(0);
+	}
+	pMutex->Signal();
+}
+
+CPipe::~CPipe()
+{
+	pMutex->Wait();
+	if (PipePointer->NumBytes == 0)			// if no data in pipeline
+		PipePointer->Initialised = 0;			// show pipeline as uninitialised
+	pMutex->Signal();
+
+	unlinkShared((SharedMemory*)hPipe);
+	unlinkShared((SharedMemory*)hData);
+
+	delete pMutex;
+	delete pConSemaphore;
+	delete pProdSemaphore;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////
+//	Datapool Functions
+////////////////////////////////////////////////////////////////////////////////////////////
+
+CDataPool::CDataPool(const string& Name, UINT size)
+	:DataPoolName(Name)
+{
+	SharedMemory* Pool = linkShared("datapool", Name, size);
+	PERR(Pool != NULL, string("Cannot Make Datapool: ") + Name);	// check for error and print error message as appropriate
+
+	if (Pool == NULL)
+		exit(0);
+
+	DPInfo.DataPoolHandle = Pool;
+	DPInfo.DataPoolPointer = Pool->Data();
+}
+
+BOOL	CDataPool::Unlink()	const
+{
+	BOOL Success = unlinkShared((SharedMemory*)DPInfo.DataPoolHandle);
+	PERR(Success == TRUE, string("Cannot UnLink from Datapool: ") + DataPoolName);		// check for error and print error message as appropriate
+	return Success;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////
+//	Console and miscellaneous functions
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void	SLEEP(UINT	Time)
+{
+	if (Time == 0) {
+		sched_yield();
+		return;
+	}
+	struct timespec ts = { (time_t)(Time / 1000), (long)(Time % 1000) * 1000000L };
+	while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+		;
+}
+
+//	Input is line buffered unless the caller has put the terminal into raw mode, in which
+//	case this reports single key presses like _kbhit()
+
+BOOL	TEST_FOR_KEYBOARD()
+{
+	fd_set fds;
+	struct timeval tv = { 0, 0 };
+	FD_ZERO(&fds);
+	FD_SET(STDIN_FILENO, &fds);
+	return select(STDIN_FILENO + 1, &fds, NULL, NULL, &tv) > 0;
+}
+
+HANDLE	GET_STDIN()
+{
+	return (HANDLE)stdin;
+}
+
+HANDLE	GET_STDOUT()
+{
+	return (HANDLE)stdout;
+}
+
+HANDLE	GET_STDERR()
+{
+	return (HANDLE)stderr;
+}
+
+UINT WAIT_FOR_CONSOLE_INPUT(HANDLE hEvent, DWORD Time)
+{
+	struct pollfd pfd = { fileno((FILE*)hEvent), POLLIN, 0 };
+	int Result = poll(&pfd, 1, (Time == INFINITE) ? -1 : (int)Time);
+	PERR(Result >= 0, string("Cannot Wait for Console Input"));	// check for error and print message if appropriate
+
+	if (Result < 0)
+		return WAIT_FAILED;
+	return (Result > 0) ? WAIT_OBJECT_0 : WAIT_TIMEOUT;
+}
+
+//	The console functions below write ANSI escape sequences, which every Linux terminal understands
+
+void MOVE_CURSOR(int x, int y)
+{
+	printf("\033[%d;%dH", y + 1, x + 1);		// ANSI rows and columns start at 1
+}
+
+void CURSOR_OFF()
+{
+	printf("\033[?25l");
+}
+
+void CURSOR_ON()
+{
+	printf("\033[?25h");
+}
+
+void REVERSE_ON()
+{
+	printf("\033[7m");
+}
+
+void REVERSE_OFF()
+{
+	printf("\033[27m");
+}
+
+void CLEAR_SCREEN()
+{
+	for (int i = 0; i < 50; i++)
+		putchar('\n');
+}
+
+//	Same colour numbers and return values as the Win32 version in rt.cpp. The console colour
+//	bits (1 blue, 2 green, 4 red, 8 bright) are reordered into the ANSI colour index
+//	(1 red, 2 green, 4 blue) and bright colours use the 90-97/100-107 codes.
+
+static int
+ansiColour(unsigned char colour, int normal, int bright)
+{
+	int ansi = ((colour & 4) ? 1 : 0) | (colour & 2) | ((colour & 1) ? 4 : 0);
+	return ((colour & 8) ? bright : normal) + ansi;
+}
+
+int TEXT_COLOUR(unsigned char foreground, unsigned char background)
+{
+	if ((foreground > 15) || (background > 15) || (background == foreground))
+	{
+		return -1;
+	}
+	if (foreground == 7 && background == 0)		// the defaults
+		printf("\033[0m");
+	else
+		printf("\033[%d;%dm", ansiColour(foreground, 30, 90), ansiColour(background, 40, 100));
+	return 0;
+}
+
+void PERR(bool bSuccess, string ErrorMessageString)
+{
+	int LastError = errno;
+
+	if (!(bSuccess)) {
+		putchar('\a');
+		MOVE_CURSOR(0, 0);
+		REVERSE_ON();
+		printf(" Error %d in Process %d:\n", LastError, (int)getpid());
+		printf(" Translation: %s Error: %s", strerror(LastError), ErrorMessageString.c_str());
+		REVERSE_OFF();
+		printf("\n\nPress Return to Continue...");
+		fflush(stdout);
+		getchar();
+	}
+}
+
+#endif // _WIN32
@@ -0,0 +1,126 @@
+#ifndef __RT_POSIX_H__
+#define __RT_POSIX_H__
+
+//
+//	The rt.h classes are written in terms of Win32 types (HANDLE, BOOL, DWORD ...) and constants
+//	(INFINITE, WAIT_OBJECT_0 ...). This header supplies those names when building on Linux so that
+//	rt.h keeps exactly the same interface on both platforms. The classes themselves are implemented
+//	in rt_posix.cpp:
+//
+//		CDataPool							POSIX shared memory (shm_open/mmap)
+//		CMutex, CSemaphore, CEvent,			futex based objects living in their own shared memory,
+//		CCondition							so they can be shared by name between processes
+//		CThread, ActiveClass				pthreads
+//		CPipe								shared memory plus the objects above
+//		CProcess							posix_spawn
+//		MOVE_CURSOR, TEXT_COLOUR ...		ANSI escape sequences
+//
+//	CMailbox, CTimer and WAIT_FOR_MULTIPLE_OBJECTS rely on Win32 message queues and have no
+//	POSIX implementation.
+//
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+typedef int					BOOL;
+typedef unsigned char		BYTE;
+typedef BYTE*				LPBYTE;
+typedef unsigned short		WORD;
+typedef unsigned int		UINT;
+typedef uint32_t			DWORD;
+typedef int32_t				LONG;
+typedef uintptr_t			UINT_PTR;
+typedef void				VOID;
+typedef void*				PVOID;
+typedef void*				HANDLE;
+
+#define CONST				const
+#define __stdcall
+
+#ifndef TRUE
+#define TRUE				1
+#endif
+#ifndef FALSE
+#define FALSE				0
+#endif
+
+#define INFINITE			0xFFFFFFFF
+#define WAIT_OBJECT_0		0x00000000L
+#define WAIT_ABANDONED		0x00000080L
+#define WAIT_TIMEOUT		0x00000102L
+#define WAIT_FAILED			0xFFFFFFFF
+
+// process priorities, mapped onto nice values by CProcess::SetPriority()
+#define IDLE_PRIORITY_CLASS			0x00000040
+#define NORMAL_PRIORITY_CLASS		0x00000020
+#define HIGH_PRIORITY_CLASS			0x00000080
+#define REALTIME_PRIORITY_CLASS		0x00000100
+
+// thread priorities, accepted but ignored by CThread::SetPriority()
+#define THREAD_PRIORITY_LOWEST			-2
+#define THREAD_PRIORITY_BELOW_NORMAL	-1
+#define THREAD_PRIORITY_NORMAL			0
+#define THREAD_PRIORITY_ABOVE_NORMAL	1
+#define THREAD_PRIORITY_HIGHEST			2
+#define THREAD_PRIORITY_TIME_CRITICAL	15
+#define THREAD_PRIORITY_IDLE			-15
+
+typedef struct {
+	HANDLE	hProcess;		// the child's pid
+	HANDLE	hThread;		// unused
+	DWORD	dwProcessId;
+	DWORD	dwThreadId;
+} PROCESS_INFORMATION;
+
+typedef VOID(*TIMERPROC)(HANDLE, UINT, UINT_PTR, DWORD);
+
+//	Called by the CThread and CProcess destructors. A pthread cannot be killed safely, so
+//	TerminateThread() only releases the handle; a thread that is still running is left to finish
+//	(or is ended with the process).
+
+BOOL TerminateThread(HANDLE hThread, DWORD dwExitCode);
+BOOL TerminateProcess(HANDLE hProcess, UINT uExitCode);
+
+//	Critical sections are recursive in Win32, so are these
+
+typedef pthread_mutex_t CRITICAL_SECTION;
+
+inline void InitializeCriticalSection(CRITICAL_SECTION* cs)
+{
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(cs, &attr);
+	pthread_mutexattr_destroy(&attr);
+}
+
+inline void DeleteCriticalSection(CRITICAL_SECTION* cs) { pthread_mutex_destroy(cs); }
+inline void EnterCriticalSection(CRITICAL_SECTION* cs) { pthread_mutex_lock(cs); }
+inline void LeaveCriticalSection(CRITICAL_SECTION* cs) { pthread_mutex_unlock(cs); }
+
+//	The "secure" CRT functions used by rt.h and the application
+
+template <size_t N>
+inline int strcpy_s(char(&Dest)[N], const char* Src)
+{
+	snprintf(Dest, N, "%s", Src);
+	return 0;
+}
+
+template <size_t N, class... Args>
+inline int sprintf_s(char(&Buffer)[N], const char* Format, Args... args)
+{
+	return snprintf(Buffer, N, Format, args...);
+}
+
+inline int localtime_s(struct tm* Result, const time_t* Time)
+{
+	return localtime_r(Time, Result) ? 0 : errno;
+}
+
+#endif // __RT_POSIX_H__
@@ -0,0 +1,228 @@
+#include "screen_renderer.h"
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+static const uint8_t DEFAULT_COLOUR = 7;	// grey on black, what TEXT_COLOUR() goes back to
+
+ScreenRenderer::ScreenRenderer()
+	: isDirty(SCREEN_MAX_ROWS, false), outputColour(DEFAULT_COLOUR)
+{
+	renderer = thread(&ScreenRenderer::renderLoop, this);
+}
+
+ScreenRenderer&
+ScreenRenderer::get()
+{
+	/*
+	 * Never destroyed: threads that are still running while the process exits can go on
+	 * printing, and the renderer thread goes with the process.
+	 */
+	static ScreenRenderer* renderer = new ScreenRenderer();
+	return *renderer;
+}
+
+uint8_t
+ScreenRenderer::colourOf(int foreground, int background)
+{
+	return static_cast<uint8_t>((foreground & 0x0f) | ((background & 0x0f) << 4));
+}
+
+/*
+ * The same escape sequences as TEXT_COLOUR() in rt_posix.cpp: the console colour bits
+ * (1 blue, 2 green, 4 red, 8 bright) reordered into the ANSI colour index (1 red, 2 green,
+ * 4 blue), with bright colours on the 90-97/100-107 codes.
+ */
+void
+ScreenRenderer::appendColour(string& out, uint8_t colour)
+{
+	if (colour == DEFAULT_COLOUR) {
+		out += "\033[0m";
+		return;
+	}
+
+	auto ansi = [](int console, int normal, int bright) {
+		int index = ((console & 4) ? 1 : 0) | (console & 2) | ((console & 1) ? 4 : 0);
+		return ((console & 8) ? bright : normal) + index;
+	};
+	char sequence[16];
+	snprintf(sequence, sizeof(sequence), "\033[%d;%dm", ansi(colour & 0x0f, 30, 90), ansi(colour >> 4, 40, 100));
+	out += sequence;
+}
+
+void
+ScreenRenderer::print(int x, int y, const string& text, int foreground, int background)
+{
+	const uint8_t colour = colourOf(foreground, background);
+
+	lock_guard<mutex> lock(canvasMutex);
+	int column = x;
+	bool marked = false;
+	for (char ch : text) {
+		if (ch == '\n') {
+			y++;
+			column = x;
+			marked = false;
+			continue;
+		}
+		if (y < 0 || y >= SCREEN_MAX_ROWS || column < 0 || column >= SCREEN_MAX_COLUMNS) {
+			column++;
+			continue;
+		}
+
+		if (static_cast<int>(canvas.size()) <= y)
+			canvas.resize(y + 1);
+		Row& row = canvas[y];
+		if (static_cast<int>(row.size()) <= column)
+			row.resize(column + 1, Cell{ '\0', DEFAULT_COLOUR });
+		row[column] = Cell{ ch, colour };
+		column++;
+
+		if (!marked && !isDirty[y]) {
+			isDirty[y] = true;
+			dirtyRows.push_back(y);
+		}
+		marked = true;
+	}
+}
+
+/*
+ * Draws the rows printed to since the previous frame. Only the copy of those rows is done
+ * under canvasMutex; comparing and writing are not.
+ */
+void
+ScreenRenderer::renderFrame()
+{
+	lock_guard<mutex> render(renderMutex);
+
+	frameRows.clear();
+	{
+		lock_guard<mutex> lock(canvasMutex);
+		for (int y : dirtyRows) {
+			frameRows.emplace_back(y, canvas[y]);
+			isDirty[y] = false;
+		}
+		dirtyRows.clear();
+	}
+	if (frameRows.empty())
+		return;
+
+	// anything the process has written to the console itself goes first
+	cout.flush();
+	fflush(stdout);
+
+	output.clear();
+	outputColour = DEFAULT_COLOUR;
+	for (auto& frame_row : frameRows) {
+		int y = frame_row.first;
+		const Row& wanted = frame_row.second;
+		if (static_cast<int>(screen.size()) <= y)
+			screen.resize(y + 1);
+		Row& shown = screen[y];
+		if (shown.size() < wanted.size())
+			shown.resize(wanted.size(), Cell{ '\0', DEFAULT_COLOUR });
+
+		// each run of adjacent cells that changed goes out with one cursor move
+		int x = 0;
+		while (x < static_cast<int>(wanted.size())) {
+			if (wanted[x].ch == '\0' || wanted[x] == shown[x]) {
+				x++;
+				continue;
+			}
+			int end = x + 1;
+			while (end < static_cast<int>(wanted.size()) && wanted[end].ch != '\0' && wanted[end] != shown[end])
+				end++;
+			writeRun(x, y, &wanted[x], end - x);
+			copy(wanted.begin() + x, wanted.begin() + end, shown.begin() + x);
+			x = end;
+		}
+	}
+
+#ifndef _WIN32
+	// leave the console as anything else writing to it expects
+	if (outputColour != DEFAULT_COLOUR)
+		appendColour(output, DEFAULT_COLOUR);
+
+	if (!output.empty())
+		write(output);
+#endif
+}
+
+#ifdef _WIN32
+/*
+ * Rows are addressed in the console's screen buffer, as MOVE_CURSOR() does with
+ * SetConsoleCursorPosition: an ANSI cursor move only reaches the visible window, and
+ * the Computer draws far below it. The cells' colours are already console attributes.
+ * Neither call moves the cursor.
+ */
+void
+ScreenRenderer::writeRun(int x, int y, const Cell* cells, int count)
+{
+	HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
+	runChars.clear();
+	runAttributes.clear();
+	for (int i = 0; i < count; i++) {
+		runChars.push_back(cells[i].ch);
+		runAttributes.push_back(cells[i].colour);
+	}
+
+	COORD at = { static_cast<SHORT>(x), static_cast<SHORT>(y) };
+	DWORD written = 0;
+	WriteConsoleOutputCharacterA(console, runChars.data(), static_cast<DWORD>(count), at, &written);
+	WriteConsoleOutputAttribute(console, reinterpret_cast<const WORD*>(runAttributes.data()), static_cast<DWORD>(count), at, &written);
+}
+#else
+void
+ScreenRenderer::writeRun(int x, int y, const Cell* cells, int count)
+{
+	char move[24];
+	snprintf(move, sizeof(move), "\033[%d;%dH", y + 1, x + 1);	// ANSI rows and columns start at 1
+	output += move;
+	for (int i = 0; i < count; i++) {
+		if (cells[i].colour != outputColour) {
+			outputColour = cells[i].colour;
+			appendColour(output, outputColour);
+		}
+		output += cells[i].ch;
+	}
+}
+
+void
+ScreenRenderer::write(const string& bytes)
+{
+	size_t done = 0;
+	while (done < bytes.size()) {
+		ssize_t n = ::write(STDOUT_FILENO, bytes.data() + done, bytes.size() - done);
+		if (n <= 0)
+			break;
+		done += static_cast<size_t>(n);
+	}
+}
+#endif
+
+void
+ScreenRenderer::renderLoop()
+{
+	const chrono::microseconds frame(1000000 / SCREEN_FPS);
+	auto next = chrono::steady_clock::now();
+	while (true) {
+		next += frame;
+		this_thread::sleep_until(next);
+		renderFrame();
+	}
+}
+
+void
+ScreenRenderer::flush()
+{
+	renderFrame();
+}
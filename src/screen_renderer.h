@@ -0,0 +1,92 @@
+#ifndef __SCREEN_RENDERER_H__
+#define __SCREEN_RENDERER_H__
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * The only thing in a process that writes the console.
+ *
+ * Threads that have something to show `print` it into a canvas of character cells, which
+ * costs a copy under a lock that is never held across any I/O. A renderer thread wakes
+ * SCREEN_FPS times a second, takes the rows changed since the previous frame, compares them
+ * cell by cell with what it last put on the screen, and sends only the cells that differ,
+ * with the cursor moves and colour changes they need, in a single write. On Windows each
+ * run of changed cells is written straight into the console's screen buffer instead, at
+ * the same buffer coordinates MOVE_CURSOR() uses.
+ *
+ * Cells nobody has printed to are never written, so the canvas only covers what the
+ * process draws, as the console did. Text beyond SCREEN_MAX_COLUMNS or SCREEN_MAX_ROWS is
+ * dropped, so whoever may draw that far has to say so on the screen.
+ */
+const int SCREEN_FPS = 30;
+const int SCREEN_MAX_COLUMNS = 160;
+const int SCREEN_MAX_ROWS = 4096;
+
+class ScreenRenderer
+{
+private:
+	struct Cell
+	{
+		char ch;			// '\0' for a cell nobody has printed to
+		uint8_t colour;		// foreground in the low nibble, background in the high one
+
+		bool operator==(const Cell& other) const { return ch == other.ch && colour == other.colour; }
+		bool operator!=(const Cell& other) const { return !(*this == other); }
+	};
+
+	typedef std::vector<Cell> Row;
+
+	// what the producers have printed, and which rows of it the next frame has to look at
+	std::mutex canvasMutex;
+	std::vector<Row> canvas;
+	std::vector<int> dirtyRows;
+	std::vector<bool> isDirty;
+
+	// the renderer's side: the changed rows of this frame and what the console shows now
+	std::mutex renderMutex;
+	std::vector<std::pair<int, Row>> frameRows;
+	std::vector<Row> screen;
+	std::string output;
+	uint8_t outputColour;
+#ifdef _WIN32
+	std::vector<char> runChars;
+	std::vector<uint16_t> runAttributes;	// console attributes (WORD)
+#endif
+
+	std::thread renderer;
+
+	ScreenRenderer();
+
+	void renderFrame();
+	void renderLoop();
+	// sends `count` cells from column `x` of row `y`
+	void writeRun(int x, int y, const Cell* cells, int count);
+#ifndef _WIN32
+	void write(const std::string& bytes);
+#endif
+
+	static uint8_t colourOf(int foreground, int background);
+	static void appendColour(std::string& out, uint8_t colour);
+
+public:
+	// one per process, started on first use
+	static ScreenRenderer& get();
+
+	ScreenRenderer(const ScreenRenderer&) = delete;
+	ScreenRenderer& operator=(const ScreenRenderer&) = delete;
+
+	/*
+	 * Puts `text` on the screen from column `x` of row `y`; after each '\n' it carries on
+	 * from column `x` of the next row. The colours are the TEXT_COLOUR() numbers.
+	 */
+	void print(int x, int y, const std::string& text, int foreground = 7, int background = 0);
+
+	// Draws everything printed so far before returning, e.g. before the process writes to the console itself.
+	void flush();
+};
+
+#endif // __SCREEN_RENDERER_H__
@@ -0,0 +1,90 @@
+#ifndef __SEQLOCK_H__
+#define __SEQLOCK_H__
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/*
+ * A sequence lock for one writer and any number of readers.
+ *
+ * The writer makes the sequence number odd, copies the value in and makes the sequence
+ * number even again. A reader copies the value out and keeps the copy only if the sequence
+ * number was even and unchanged across the copy, so readers never block the writer and
+ * never take a lock themselves; they retry instead.
+ *
+ * The object lives in a `CDataPool`, so it has to work when its bytes are all zero and must
+ * not contain pointers. The value is kept in an array of relaxed 64-bit atomics rather than
+ * as a plain `T`, so a reader racing with the writer copies garbage words (which it then
+ * throws away) instead of performing a data race.
+ *
+ * Only one thread may call `write()` at a time.
+ */
+template <class T>
+class SeqLock
+{
+	static_assert(std::is_trivially_copyable<T>::value, "SeqLock values are copied byte by byte");
+
+private:
+	static const size_t NUM_WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+	std::atomic<uint32_t> sequence;
+	std::atomic<uint64_t> words[NUM_WORDS];
+
+public:
+	// Publishes a new value. Must only be called by the single writer.
+	void write(const T& value)
+	{
+		uint64_t buffer[NUM_WORDS] = {};
+		memcpy(buffer, &value, sizeof(T));
+
+		uint32_t seq = sequence.load(std::memory_order_relaxed);
+		sequence.store(seq + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		for (size_t i = 0; i < NUM_WORDS; i++)
+			words[i].store(buffer[i], std::memory_order_relaxed);
+
+		sequence.store(seq + 2, std::memory_order_release);
+	}
+
+	// Copies one consistent value into `value`. Returns false if the writer was busy, in
+	// which case `value` must not be used.
+	bool tryRead(T& value) const
+	{
+		uint32_t before = sequence.load(std::memory_order_acquire);
+		if (before & 1)
+			return false;
+
+		uint64_t buffer[NUM_WORDS];
+		for (size_t i = 0; i < NUM_WORDS; i++)
+			buffer[i] = words[i].load(std::memory_order_relaxed);
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (sequence.load(std::memory_order_relaxed) != before)
+			return false;
+
+		memcpy(&value, buffer, sizeof(T));
+		return true;
+	}
+
+	// Copies one consistent value into `value`, retrying until the writer is not in the middle of a write.
+	void read(T& value) const
+	{
+		while (!tryRead(value))
+			;
+	}
+
+	T read() const
+	{
+		T value;
+		read(value);
+		return value;
+	}
+
+	// Number of completed writes times 2 (odd while a write is in progress).
+	uint32_t getSequence() const { return sequence.load(std::memory_order_acquire); }
+};
+
+#endif // __SEQLOCK_H__
@@ -0,0 +1,163 @@
+#include "sim_clock.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+// AsFastAsPossible: how far the calling thread has got, in ms since the start
+static thread_local int64_t threadElapsedMs = 0;
+
+SimClock::SimClock() :
+	mode(ClockMode::RealTime),
+	scale(1.0),
+	startTime(chrono::system_clock::now()),
+	realStart(chrono::steady_clock::now()),
+	fastElapsedMs(&localFastElapsedMs),
+	localFastElapsedMs(0)
+{}
+
+SimClock&
+SimClock::get()
+{
+	static SimClock clock;
+	return clock;
+}
+
+void
+SimClock::configure(ClockMode new_mode, double new_scale)
+{
+	mode = new_mode;
+	scale = (new_mode == ClockMode::Scaled && new_scale > 0) ? new_scale : 1.0;
+	startTime = chrono::system_clock::now();
+	realStart = chrono::steady_clock::now();
+	fastElapsedMs->store(0);
+}
+
+bool
+SimClock::configure(const string& option)
+{
+	if (option == "realtime") {
+		configure(ClockMode::RealTime);
+		return true;
+	}
+	if (option == "fast") {
+		configure(ClockMode::AsFastAsPossible);
+		return true;
+	}
+	if (option.size() > 1 && option[0] == 'x') {
+		char* end = nullptr;
+		double factor = strtod(option.c_str() + 1, &end);
+		if (*end == '\0' && factor > 0) {
+			configure(ClockMode::Scaled, factor);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool
+SimClock::configureFromArgs(int argc, char* argv[])
+{
+	const char prefix[] = "--clock=";
+
+	for (int i = 1; i < argc; i++) {
+		if (strncmp(argv[i], prefix, sizeof(prefix) - 1) != 0)
+			continue;
+		if (!configure(string(argv[i] + sizeof(prefix) - 1))) {
+			cout << "Usage: " << argv[0] << " [--clock=realtime|x<speed-up>|fast]" << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+bool
+SimClock::share(SharedClockState* shared)
+{
+	const ClockMode requested_mode = mode;
+	const double requested_scale = scale;
+
+	uint32_t state = 0;
+	if (shared->state.compare_exchange_strong(state, CLOCK_WRITING)) {
+		shared->mode = mode;
+		shared->scale = scale;
+		shared->startTimeNs = chrono::duration_cast<chrono::nanoseconds>(startTime.time_since_epoch()).count();
+		shared->realStartNs = chrono::duration_cast<chrono::nanoseconds>(realStart.time_since_epoch()).count();
+		shared->fastElapsedMs.store(fastElapsedMs->load());
+		shared->state.store(CLOCK_PUBLISHED, memory_order_release);
+	}
+	else {
+		// the other process is publishing its clock right now; it takes no time
+		while (shared->state.load(memory_order_acquire) != CLOCK_PUBLISHED)
+			this_thread::yield();
+		mode = shared->mode;
+		scale = shared->scale;
+		startTime = chrono::system_clock::time_point(
+			chrono::duration_cast<chrono::system_clock::duration>(chrono::nanoseconds(shared->startTimeNs)));
+		realStart = chrono::steady_clock::time_point(
+			chrono::duration_cast<chrono::steady_clock::duration>(chrono::nanoseconds(shared->realStartNs)));
+	}
+	fastElapsedMs = &shared->fastElapsedMs;
+
+	return mode == requested_mode && scale == requested_scale;
+}
+
+string
+SimClock::toString() const
+{
+	switch (mode) {
+	case ClockMode::Scaled: {
+		ostringstream out;
+		out << "x" << scale;
+		return out.str();
+	}
+	case ClockMode::AsFastAsPossible:
+		return "fast";
+	default:
+		return "realtime";
+	}
+}
+
+void
+SimClock::sleep(UINT ms)
+{
+	switch (mode) {
+	case ClockMode::RealTime:
+		SLEEP(ms);
+		break;
+
+	case ClockMode::Scaled:
+		this_thread::sleep_for(chrono::duration<double, milli>(ms / scale));
+		break;
+
+	case ClockMode::AsFastAsPossible: {
+		int64_t furthest = fastElapsedMs->load(memory_order_relaxed);
+		threadElapsedMs = max(threadElapsedMs, furthest) + ms;
+		while (furthest < threadElapsedMs &&
+			!fastElapsedMs->compare_exchange_weak(furthest, threadElapsedMs, memory_order_relaxed))
+			;
+		SLEEP(0);		// give the other simulated threads a turn
+		break;
+	}
+	}
+}
+
+chrono::system_clock::time_point
+SimClock::now() const
+{
+	switch (mode) {
+	case ClockMode::Scaled:
+		return startTime + chrono::duration_cast<chrono::system_clock::duration>(
+			(chrono::steady_clock::now() - realStart) * scale);
+
+	case ClockMode::AsFastAsPossible:
+		return startTime + chrono::milliseconds(fastElapsedMs->load(memory_order_relaxed));
+
+	default:
+		return chrono::system_clock::now();
+	}
+}
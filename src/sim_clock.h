@@ -0,0 +1,104 @@
+#ifndef __SIM_CLOCK_H__
+#define __SIM_CLOCK_H__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include "rt.h"
+
+/*
+ * The time the simulation runs on.
+ *
+ * Everything that models the passing of time (dispensing and refilling a tank, time stamping
+ * a transaction) asks the process's SimClock instead of calling SLEEP() or reading the system
+ * clock, so the same code can run
+ *
+ *   RealTime           one simulated second per second, the default
+ *   Scaled             `scale` simulated seconds per second, e.g. x60 runs an hour a minute
+ *   AsFastAsPossible   sleeps return straight away and only move simulated time forward
+ *
+ * In AsFastAsPossible mode every thread keeps its own simulated time, which a sleep moves
+ * forward; the clock reads the furthest any thread has got, and a thread that has fallen
+ * behind (e.g. a customer that has just arrived) catches up to it on its next sleep. That
+ * keeps concurrent pumps from adding their ticks together.
+ *
+ * The mode is chosen once at start-up, before any thread uses the clock.
+ */
+enum class ClockMode
+{
+	RealTime,
+	Scaled,
+	AsFastAsPossible
+};
+
+/*
+ * Contents of the "SimClock" data pool, through which the Computer and the PumpFacility run on
+ * one clock: the first of them to call SimClock::share() publishes its mode and start, the
+ * other adopts them, and in AsFastAsPossible mode both move and read the same `fastElapsedMs`.
+ * `state` goes from 0 through CLOCK_WRITING to CLOCK_PUBLISHED like StationLayout's.
+ *
+ * The start on the steady clock is shared as a count since its epoch, which is the same for
+ * every process on the machine (CLOCK_MONOTONIC, QueryPerformanceCounter).
+ */
+const uint32_t CLOCK_WRITING = 1;
+const uint32_t CLOCK_PUBLISHED = 2;
+
+struct SharedClockState
+{
+	std::atomic<uint32_t> state;
+	ClockMode mode;
+	double scale;
+	int64_t startTimeNs;		// system_clock, since its epoch
+	int64_t realStartNs;		// steady_clock, since its epoch
+	std::atomic<int64_t> fastElapsedMs;
+};
+
+class SimClock
+{
+private:
+	ClockMode mode;
+	double scale;
+
+	// wall-clock time at which the simulation started, and the same instant on the steady clock
+	std::chrono::system_clock::time_point startTime;
+	std::chrono::steady_clock::time_point realStart;
+
+	// AsFastAsPossible: the furthest simulated time any thread has reached, in ms since startTime;
+	// points at `localFastElapsedMs` until the clock is shared
+	std::atomic<int64_t>* fastElapsedMs;
+	std::atomic<int64_t> localFastElapsedMs;
+
+	SimClock();
+
+public:
+	static SimClock& get();
+
+	void configure(ClockMode new_mode, double new_scale = 1.0);
+
+	// Accepts "realtime", "x<scale>" (e.g. "x60") or "fast"; returns false if `option` is none of them.
+	bool configure(const std::string& option);
+
+	// Looks for a --clock=<option> argument, prints the usage and returns false if it is invalid.
+	bool configureFromArgs(int argc, char* argv[]);
+
+	/*
+	 * Runs this clock on `shared`, which lives in a data pool, so another process sharing it
+	 * reads the same time. Whichever process shares first decides the mode and start time.
+	 * Returns false if this process was configured differently and now runs on the other's clock.
+	 */
+	bool share(SharedClockState* shared);
+
+	// "realtime", "x<scale>" or "fast", as given to configure()
+	std::string toString() const;
+
+	// Lets `ms` of simulated time pass for the calling thread.
+	void sleep(UINT ms);
+
+	std::chrono::system_clock::time_point now() const;
+
+	ClockMode getMode() const { return mode; }
+	double getScale() const { return scale; }
+};
+
+#endif // __SIM_CLOCK_H__
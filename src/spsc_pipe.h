@@ -0,0 +1,169 @@
+#ifndef __SPSC_PIPE_H__
+#define __SPSC_PIPE_H__
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include "rt.h"
+#include "futex.h"
+
+/*
+ * A typed pipeline for exactly one reader and one writer at a time.
+ *
+ * The pump pipes only ever have one reader (`Pump::readPipe`) and the customers writing to
+ * them are serialised by the pump assignment, so the mutex and the two semaphores that a
+ * `CTypedPipe` goes through for every transfer are not needed. This pipe is a ring buffer
+ * in a `CDataPool` with a head index owned by the reader and a tail index owned by the
+ * writer, each on its own cache line. A transfer is a `memcpy` plus one atomic store; the
+ * kernel is only entered (futex) when the ring is empty for the reader or full for the writer.
+ *
+ * The interface matches `CTypedPipe<T>` so the two can be swapped by changing a type.
+ * `T` is copied byte by byte into the data pool, so it must be trivially copyable.
+ */
+
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+template <class T>
+class SpscTypedPipe
+{
+	static_assert(std::is_trivially_copyable<T>::value, "SpscTypedPipe elements are copied byte by byte");
+
+private:
+	struct Control {
+		alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> head;	// number of elements read so far, written by the reader
+		alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> tail;	// number of elements written so far, written by the writer
+		alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> readerWaiting;	// set by a reader about to sleep on an empty ring
+		std::atomic<uint32_t> writerWaiting;	// set by a writer about to sleep on a full ring
+		UINT capacity;							// number of elements in the ring, always a power of 2
+		std::atomic<uint32_t> initialised;
+	};
+
+	static const uint32_t INITIALISING = 1;
+	static const uint32_t INITIALISED = 0x4afc;		// same marker as CPipe
+
+	std::unique_ptr<CDataPool> dataPool;
+	Control* control;
+	BYTE* slots;
+	uint32_t mask;
+	const std::string pipeName;
+
+	static UINT roundUpToPowerOfTwo(UINT n);
+	static size_t controlSize() { return (sizeof(Control) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE; }
+	BYTE* slot(uint32_t index) const { return slots + (size_t)(index & mask) * sizeof(T); }
+
+public:
+	SpscTypedPipe(const std::string& Name, UINT NumElements = 1024);
+
+	BOOL	Read(T* Data);				// reads a 'T' object from the pipe into 'Data', blocks while the pipe is empty
+	BOOL	Write(const T* Data);		// writes a 'T' object into the pipe, blocks while the pipe is full
+	UINT	TestForData() const;		// indicates how many T's are in the pipe to read
+
+	inline operator std::string	() const { return pipeName; }
+	inline std::string	GetName() const { return pipeName; }
+};
+
+template <class T>
+UINT
+SpscTypedPipe<T>::roundUpToPowerOfTwo(UINT n)
+{
+	UINT capacity = 1;
+	while (capacity < n)
+		capacity <<= 1;
+	return capacity;
+}
+
+template <class T>
+SpscTypedPipe<T>::SpscTypedPipe(const std::string& Name, UINT NumElements)
+	: pipeName(Name)
+{
+	PERR(NumElements >= 1, std::string("SpscTypedPipe size is too small, Minimum is 1 element: ") + Name);
+
+	UINT capacity = roundUpToPowerOfTwo(NumElements < 1 ? 1 : NumElements);
+
+	dataPool = std::make_unique<CDataPool>(std::string("__SpscPipe__") + Name,
+										   (UINT)(controlSize() + (size_t)capacity * sizeof(T)));
+	control = static_cast<Control*>(dataPool->LinkDataPool());
+	slots = static_cast<BYTE*>(dataPool->LinkDataPool()) + controlSize();
+	mask = capacity - 1;
+
+	/*
+	 * The data pool is zero filled when it is first created. Whoever gets to move
+	 * `initialised` from 0 sets the ring up, everybody else waits until it is ready and
+	 * then checks that they asked for the same size.
+	 */
+	uint32_t state = 0;
+	if (control->initialised.compare_exchange_strong(state, INITIALISING)) {
+		control->head.store(0, std::memory_order_relaxed);
+		control->tail.store(0, std::memory_order_relaxed);
+		control->readerWaiting.store(0, std::memory_order_relaxed);
+		control->writerWaiting.store(0, std::memory_order_relaxed);
+		control->capacity = capacity;
+		control->initialised.store(INITIALISED, std::memory_order_release);
+	}
+	else {
+		while (control->initialised.load(std::memory_order_acquire) != INITIALISED)
+			SLEEP(0);
+		PERR(control->capacity == capacity, std::string("Size of SpscTypedPipe Name: ") + Name +
+			std::string(" Conflicts with size already specified by another process"));
+	}
+}
+
+template <class T>
+BOOL
+SpscTypedPipe<T>::Write(const T* Data)
+{
+	uint32_t tail = control->tail.load(std::memory_order_relaxed);
+
+	// Wait while the ring is full. The flag is raised before re-checking so that a reader
+	// freeing a slot in between either sees the flag or is seen here.
+	while (tail - control->head.load(std::memory_order_acquire) == control->capacity) {
+		control->writerWaiting.store(1, std::memory_order_seq_cst);
+		uint32_t head = control->head.load(std::memory_order_seq_cst);
+		if (tail - head != control->capacity)
+			break;
+		futexWait(&control->head, head);
+	}
+
+	memcpy(slot(tail), Data, sizeof(T));
+	control->tail.store(tail + 1, std::memory_order_seq_cst);
+
+	if (control->readerWaiting.exchange(0, std::memory_order_seq_cst))
+		futexWakeOne(&control->tail);
+
+	return TRUE;
+}
+
+template <class T>
+BOOL
+SpscTypedPipe<T>::Read(T* Data)
+{
+	uint32_t head = control->head.load(std::memory_order_relaxed);
+
+	// Wait while the ring is empty, mirror image of Write().
+	while (control->tail.load(std::memory_order_acquire) == head) {
+		control->readerWaiting.store(1, std::memory_order_seq_cst);
+		if (control->tail.load(std::memory_order_seq_cst) != head)
+			break;
+		futexWait(&control->tail, head);
+	}
+
+	memcpy(Data, slot(head), sizeof(T));
+	control->head.store(head + 1, std::memory_order_seq_cst);
+
+	if (control->writerWaiting.exchange(0, std::memory_order_seq_cst))
+		futexWakeOne(&control->head);
+
+	return TRUE;
+}
+
+template <class T>
+UINT
+SpscTypedPipe<T>::TestForData() const
+{
+	return control->tail.load(std::memory_order_acquire) - control->head.load(std::memory_order_acquire);
+}
+
+#endif // __SPSC_PIPE_H__
@@ -0,0 +1,129 @@
+#include "station_config.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+StationConfig
+StationConfig::defaults()
+{
+	StationConfig config;
+	config.numPumps = DEFAULT_NUM_PUMPS;
+	config.numTanks = MAX_TANKS;
+	config.tankCapacity = DEFAULT_TANK_CAPACITY;
+	config.flowRate = DEFAULT_FLOW_RATE;
+	return config;
+}
+
+int32_t
+StationConfig::tankCapacityMl() const
+{
+	return static_cast<int32_t>(lround(tankCapacity * 1000));
+}
+
+int32_t
+StationConfig::flowRateMl() const
+{
+	return static_cast<int32_t>(lround(flowRate * 1000));
+}
+
+bool
+StationConfig::set(const string& key, const string& value)
+{
+	const char* text = value.c_str();
+	char* end = nullptr;
+
+	if (key == "pumps" || key == "tanks") {
+		long number = strtol(text, &end, 10);
+		if (value.empty() || *end != '\0' || number < 1 || number > (key == "pumps" ? MAX_PUMPS : MAX_TANKS))
+			return false;
+		(key == "pumps" ? numPumps : numTanks) = static_cast<int32_t>(number);
+		return true;
+	}
+	if (key == "tank-capacity" || key == "flow-rate") {
+		// volumes are kept in millilitres in an int32_t
+		double litres = strtod(text, &end);
+		if (value.empty() || *end != '\0' || !(litres >= 0.001 && litres <= 1000000.0))
+			return false;
+		(key == "tank-capacity" ? tankCapacity : flowRate) = static_cast<float>(litres);
+		return true;
+	}
+	return false;
+}
+
+bool
+StationConfig::load(const string& path)
+{
+	ifstream file(path);
+	if (!file) {
+		cout << "Cannot open the station configuration " << path << endl;
+		return false;
+	}
+
+	string line;
+	int line_number = 0;
+	while (getline(file, line)) {
+		line_number++;
+		size_t start = line.find_first_not_of(" \t\r");
+		if (start == string::npos || line[start] == '#')
+			continue;
+
+		size_t equals = line.find('=');
+		size_t last = line.find_last_not_of(" \t\r");
+		string key, value;
+		if (equals != string::npos) {
+			key = line.substr(start, equals - start);
+			key.erase(key.find_last_not_of(" \t") + 1);
+			size_t value_start = line.find_first_not_of(" \t", equals + 1);
+			if (value_start != string::npos && value_start <= last)
+				value = line.substr(value_start, last + 1 - value_start);
+		}
+		if (!set(key, value)) {
+			cout << path << ":" << line_number << ": cannot use \"" << line.substr(start) << "\"" << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+bool
+StationConfig::configureFromArgs(int argc, char* argv[])
+{
+	const char config_prefix[] = "--config=";
+	const char* options[] = { "pumps", "tanks", "tank-capacity", "flow-rate" };
+	bool valid = true;
+
+	// the file first, so the options on the command line override it
+	for (int i = 1; i < argc && valid; i++) {
+		if (strncmp(argv[i], config_prefix, sizeof(config_prefix) - 1) == 0)
+			valid = load(argv[i] + sizeof(config_prefix) - 1);
+	}
+
+	for (int i = 1; i < argc && valid; i++) {
+		for (const char* option : options) {
+			string prefix = string("--") + option + "=";
+			if (strncmp(argv[i], prefix.c_str(), prefix.size()) == 0 && !set(option, argv[i] + prefix.size())) {
+				cout << "Invalid option " << argv[i] << endl;
+				valid = false;
+			}
+		}
+	}
+
+	if (!valid) {
+		cout << "Usage: " << argv[0] << " [--config=<file>] [--pumps=1.." << MAX_PUMPS << "] [--tanks=1.." << MAX_TANKS
+			<< "] [--tank-capacity=<litres>] [--flow-rate=<litres per tick>]" << endl;
+	}
+	return valid;
+}
+
+string
+StationConfig::toString() const
+{
+	ostringstream out;
+	out << numPumps << " pumps, " << numTanks << " tanks of " << tankCapacity << " L, " << flowRate << " L per tick";
+	return out.str();
+}
@@ -0,0 +1,71 @@
+#ifndef __STATION_CONFIG_H__
+#define __STATION_CONFIG_H__
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+/*
+ * How big the station is: the number of pumps and tanks and how fast fuel moves.
+ *
+ * Each process fills one in at start-up from its command line, optionally starting from a
+ * file of `key=value` lines:
+ *
+ *   --config=<file>  --pumps=N  --tanks=N  --tank-capacity=<litres>  --flow-rate=<litres per tick>
+ *
+ * and hands it to SharedResources::open(), which sizes the pipes, events, semaphores and data
+ * pools from it. The first process to open the shared resources publishes its configuration
+ * in the "StationLayout" data pool; the other one adopts it, so both always agree on how many
+ * of each object there are even if they were started with different options.
+ *
+ * There is one tank per fuel grade, so at most MAX_TANKS of them; tank i holds grade i.
+ * Lives in a data pool, so it has to stay trivially copyable.
+ */
+const int MAX_PUMPS = 256;
+const int MAX_TANKS = 4;
+
+const int DEFAULT_NUM_PUMPS = 6;
+const float DEFAULT_TANK_CAPACITY = 500.0f;
+const float DEFAULT_FLOW_RATE = 5.0f;
+
+struct StationConfig
+{
+	int32_t numPumps;
+	int32_t numTanks;
+	float tankCapacity;		// litres
+	float flowRate;			// litres dispensed or refilled per FLOW_TICK_MS
+
+	static StationConfig defaults();
+
+	int32_t tankCapacityMl() const;
+	int32_t flowRateMl() const;
+
+	// Sets one option, e.g. set("pumps", "32"); false if the key is unknown or the value out of range.
+	bool set(const std::string& key, const std::string& value);
+
+	// Applies the `key=value` lines of `path`; blank lines and lines starting with '#' are skipped.
+	bool load(const std::string& path);
+
+	// Looks for the options above, prints the usage and returns false if any of them is invalid.
+	bool configureFromArgs(int argc, char* argv[]);
+
+	std::string toString() const;
+};
+
+static_assert(std::is_trivially_copyable<StationConfig>::value, "StationConfig is kept in a data pool");
+
+/*
+ * Contents of the "StationLayout" data pool. `state` goes from 0 (nobody has opened the
+ * station yet) through LAYOUT_WRITING to LAYOUT_PUBLISHED, after which `config` never changes.
+ */
+const uint32_t LAYOUT_WRITING = 1;
+const uint32_t LAYOUT_PUBLISHED = 2;
+
+struct StationLayout
+{
+	std::atomic<uint32_t> state;
+	StationConfig config;
+};
+
+#endif // __STATION_CONFIG_H__
@@ -0,0 +1,87 @@
+#include "task.h"
+
+using namespace std;
+
+void
+Task::start(TaskPool& pool)
+{
+	// The frame frees itself when the coroutine finishes, so this object lets go of it.
+	pool.post(exchange(handle, nullptr));
+}
+
+TaskPool::TaskPool(unsigned num_workers) :
+	stopping(false)
+{
+	if (num_workers == 0)
+		num_workers = max(1u, thread::hardware_concurrency());
+
+	for (unsigned i = 0; i < num_workers; i++)
+		workers.emplace_back(&TaskPool::work, this);
+}
+
+TaskPool::~TaskPool()
+{
+	{
+		lock_guard<mutex> lock(queueMutex);
+		stopping = true;
+	}
+	workAvailable.notify_all();
+
+	for (thread& worker : workers)
+		worker.join();
+}
+
+void
+TaskPool::post(coroutine_handle<> task)
+{
+	{
+		lock_guard<mutex> lock(queueMutex);
+		ready.push_back(task);
+	}
+	workAvailable.notify_one();
+}
+
+void
+TaskPool::work()
+{
+	while (true) {
+		coroutine_handle<> task;
+		{
+			unique_lock<mutex> lock(queueMutex);
+			workAvailable.wait(lock, [this] { return stopping || !ready.empty(); });
+			// Coroutines still parked or queued at shutdown are abandoned with their owners.
+			if (stopping)
+				return;
+			task = ready.front();
+			ready.pop_front();
+		}
+		task.resume();
+	}
+}
+
+void
+TaskNotifier::notify()
+{
+	vector<pair<coroutine_handle<>, TaskPool*>> woken;
+	{
+		lock_guard<mutex> lock(parkedMutex);
+		generation.fetch_add(1, memory_order_release);
+		woken.swap(parked);
+	}
+
+	for (auto& [task, pool] : woken)
+		pool->post(task);
+}
+
+bool
+TaskNotifier::ChangeAwaiter::await_suspend(coroutine_handle<> task)
+{
+	lock_guard<mutex> lock(notifier.parkedMutex);
+
+	// notify() bumps the generation under the same lock, so it cannot slip in between.
+	if (notifier.current() != seen)
+		return false;
+
+	notifier.parked.emplace_back(task, &pool);
+	return true;
+}
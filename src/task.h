@@ -0,0 +1,124 @@
+#ifndef __TASK_H__
+#define __TASK_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class TaskPool;
+
+/*
+ * A fire-and-forget coroutine.
+ *
+ * A function returning Task does not run when it is called: `start()` hands it to a
+ * TaskPool, whose workers run it up to its first `co_await` on something that is not ready.
+ * It is then parked (no thread is held) until whatever it waits for hands it back to the
+ * pool, and so on until it returns, at which point its frame frees itself. The object that
+ * owns the coroutine's `this` must therefore outlive it.
+ */
+class Task
+{
+public:
+	struct promise_type
+	{
+		Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); }
+	};
+
+	Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+	Task(const Task&) = delete;
+	Task& operator=(const Task&) = delete;
+	~Task() { if (handle) handle.destroy(); }
+
+	// Queues the coroutine on `pool`; the Task object may be dropped afterwards.
+	void start(TaskPool& pool);
+
+private:
+	std::coroutine_handle<promise_type> handle;
+
+	explicit Task(std::coroutine_handle<promise_type> h) : handle(h) {}
+};
+
+/*
+ * A fixed set of worker threads running parked coroutines as they become ready.
+ *
+ * Work is resumed in the order it is posted. Coroutines running on the pool must not block
+ * their worker for long; they wait by `co_await`ing an awaitable that posts them back here
+ * (TaskNotifier::waitForChange, PumpDispatcher::acquire).
+ */
+class TaskPool
+{
+private:
+	std::mutex queueMutex;
+	std::condition_variable workAvailable;
+	std::deque<std::coroutine_handle<>> ready;
+	bool stopping;
+	std::vector<std::thread> workers;
+
+	void work();
+
+public:
+	// 0 workers: one per hardware thread.
+	explicit TaskPool(unsigned num_workers = 0);
+	~TaskPool();
+
+	TaskPool(const TaskPool&) = delete;
+	TaskPool& operator=(const TaskPool&) = delete;
+
+	void post(std::coroutine_handle<> task);
+
+	size_t size() const { return workers.size(); }
+};
+
+/*
+ * The coroutine counterpart of ChangeNotifier, for a single process.
+ *
+ * The thread making a change calls `notify()` after publishing it. A coroutine remembers the
+ * generation it has seen (`current()`), looks at the data, and then `co_await`s
+ * `waitForChange()` with that generation; if nothing has changed in the meantime it is
+ * parked, and `notify()` posts every parked coroutine back to the pool it came from.
+ */
+class TaskNotifier
+{
+private:
+	std::mutex parkedMutex;
+	std::atomic<uint32_t> generation;
+	std::vector<std::pair<std::coroutine_handle<>, TaskPool*>> parked;
+
+public:
+	TaskNotifier() : generation(0) {}
+
+	uint32_t current() const { return generation.load(std::memory_order_acquire); }
+
+	void notify();
+
+	class ChangeAwaiter
+	{
+	private:
+		TaskNotifier& notifier;
+		uint32_t seen;
+		TaskPool& pool;
+
+	public:
+		ChangeAwaiter(TaskNotifier& n, uint32_t s, TaskPool& p) : notifier(n), seen(s), pool(p) {}
+
+		bool await_ready() const { return notifier.current() != seen; }
+		bool await_suspend(std::coroutine_handle<> task);
+		void await_resume() const {}
+	};
+
+	// Resumes the awaiting coroutine on `pool` once the generation differs from `seen`.
+	ChangeAwaiter waitForChange(uint32_t seen, TaskPool& pool) { return ChangeAwaiter(*this, seen, pool); }
+};
+
+#endif // __TASK_H__
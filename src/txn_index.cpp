@@ -0,0 +1,148 @@
+#include "txn_index.h"
+#include <algorithm>
+#include <climits>
+
+using namespace std;
+
+TxnIndex::TxnIndex(const TxnHistory& history) : history(&history) {}
+
+/*
+ * "dddd dddd dddd" to the number the twelve digits make, NO_CARD if it is anything else
+ * (e.g. the placeholder of a pump nobody used).
+ */
+uint64_t
+TxnIndex::cardKey(const char* card)
+{
+	uint64_t key = 0;
+	int digits = 0;
+	for (const char* c = card; *c != '\0'; c++) {
+		if (*c == ' ')
+			continue;
+		if (*c < '0' || *c > '9')
+			return NO_CARD;
+		key = key * 10 + static_cast<uint64_t>(*c - '0');
+		digits++;
+	}
+	return (digits == 12) ? key : NO_CARD;
+}
+
+void
+TxnIndex::add(uint32_t id, const CustomerRecordWire& txn)
+{
+	TxnKey key;
+	key.card = cardKey(txn.creditCardNumber);
+	key.time = txn.nowTime;
+	key.pumpId = txn.pumpId;
+	key.grade = fuelGradeToInt(txn.grade());
+	keys.push_back(key);
+
+	if (key.pumpId >= 0 && key.pumpId < MAX_PUMPS)
+		byPump[key.pumpId].push_back(id);
+	if (key.grade >= 0 && key.grade < MAX_TANKS)
+		byGrade[key.grade].push_back(id);
+	if (key.card != NO_CARD) {
+		byCard[key.card].push_back(id);
+		byCardEnding[static_cast<uint32_t>(key.card % 10000)].push_back(id);
+	}
+	if (key.time != 0) {
+		// Pumps archive in about the order they finish, so this lands at or near the end.
+		pair<int64_t, uint32_t> entry(key.time, id);
+		byTime.insert(upper_bound(byTime.begin(), byTime.end(), entry), entry);
+	}
+}
+
+void
+TxnIndex::catchUp()
+{
+	CustomerRecordWire txn;
+	while (true) {
+		uint32_t id = static_cast<uint32_t>(cursor.position());
+		if (!history->read(cursor, txn))
+			break;
+		add(id, txn);
+	}
+}
+
+bool
+TxnIndex::matches(const TxnKey& key, const Filter& filter)
+{
+	if (filter.pumpId >= 0 && key.pumpId != filter.pumpId)
+		return false;
+	if (filter.grade >= 0 && key.grade != filter.grade)
+		return false;
+	if (filter.card != NO_CARD && (key.card == NO_CARD || key.card % filter.cardModulus != filter.card))
+		return false;
+	if (filter.timed && (key.time == 0 || key.time < filter.since || key.time > filter.until))
+		return false;
+	return true;
+}
+
+vector<uint32_t>
+TxnIndex::query(const TxnQuery& query, int64_t midnight)
+{
+	catchUp();
+
+	Filter filter;
+	filter.pumpId = query.pumpId;
+	filter.grade = query.grade;
+	filter.card = (query.card[0] != '\0') ? strtoull(query.card, nullptr, 10) : NO_CARD;
+	filter.cardModulus = (strlen(query.card) == 4) ? 10000 : UINT64_MAX;
+	filter.timed = query.since >= 0 || query.until >= 0;
+	filter.since = (query.since >= 0) ? midnight + query.since : LLONG_MIN;
+	filter.until = (query.until >= 0) ? midnight + query.until : LLONG_MAX;
+
+	/*
+	 * Pick the shortest list of candidates the filters allow. A card or a pump is usually
+	 * much more selective than a grade; a time range can be either.
+	 */
+	static const vector<uint32_t> none;
+	const vector<uint32_t>* candidates = nullptr;
+	auto consider = [&candidates](const vector<uint32_t>& list) {
+		if (candidates == nullptr || list.size() < candidates->size())
+			candidates = &list;
+	};
+
+	if (filter.card != NO_CARD) {
+		if (filter.cardModulus == 10000) {
+			auto it = byCardEnding.find(static_cast<uint32_t>(filter.card));
+			consider(it != byCardEnding.end() ? it->second : none);
+		}
+		else {
+			auto it = byCard.find(filter.card);
+			consider(it != byCard.end() ? it->second : none);
+		}
+	}
+	if (filter.pumpId >= 0)
+		consider(byPump[filter.pumpId]);
+	if (filter.grade >= 0)
+		consider(byGrade[filter.grade]);
+
+	vector<uint32_t> result;
+	auto first = byTime.begin(), last = byTime.end();
+	if (filter.timed) {
+		first = lower_bound(byTime.begin(), byTime.end(), make_pair(filter.since, 0u));
+		last = upper_bound(byTime.begin(), byTime.end(), make_pair(filter.until, UINT32_MAX));
+	}
+
+	if (filter.timed && (candidates == nullptr || static_cast<size_t>(last - first) < candidates->size())) {
+		for (auto it = first; it != last; ++it) {
+			if (matches(keys[it->second], filter))
+				result.push_back(it->second);
+		}
+		// back into the order they were archived
+		sort(result.begin(), result.end());
+	}
+	else if (candidates != nullptr) {
+		for (uint32_t id : *candidates) {
+			if (matches(keys[id], filter))
+				result.push_back(id);
+		}
+	}
+	else {
+		// no filters at all
+		result.resize(keys.size());
+		for (uint32_t id = 0; id < keys.size(); id++)
+			result[id] = id;
+	}
+	return result;
+}
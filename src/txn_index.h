@@ -0,0 +1,81 @@
+#ifndef __TXN_INDEX_H__
+#define __TXN_INDEX_H__
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "common.h"
+#include "txn_journal.h"
+
+/*
+ * Secondary indexes over the TxnHistory, for `pt` with filters.
+ *
+ * Every archived transaction is posted, by its position in the history, to a list for its
+ * pump, a list for its fuel grade, a hash table keyed on its card number (one for all
+ * twelve digits and one for the last four) and a list ordered by time. A query starts
+ * from whichever of those gives the fewest candidates and checks the remaining filters
+ * against a small key kept for each transaction, so it never walks the whole history.
+ *
+ * The index catches up with the history itself at the start of each query, reading only the
+ * transactions archived since the last one; the first query also reads whatever an earlier
+ * run left in the journal. It belongs to the one thread that queries it.
+ */
+class TxnIndex
+{
+private:
+	// what the filters look at, per transaction
+	struct TxnKey
+	{
+		uint64_t card;		// all twelve digits, NO_CARD if there is no card number
+		int64_t time;		// seconds since the epoch, 0 if never timestamped
+		int32_t pumpId;
+		int32_t grade;
+	};
+
+	static const uint64_t NO_CARD = UINT64_MAX;
+
+	// a TxnQuery in the terms of TxnKey
+	struct Filter
+	{
+		int32_t pumpId;
+		int32_t grade;
+		uint64_t card;			// NO_CARD for any card
+		uint64_t cardModulus;	// 10000 when only the last four digits are given
+		bool timed;
+		int64_t since;
+		int64_t until;
+	};
+
+	const TxnHistory* history;
+	TxnHistory::Cursor cursor;
+
+	std::vector<TxnKey> keys;
+	std::vector<uint32_t> byPump[MAX_PUMPS];
+	std::vector<uint32_t> byGrade[MAX_TANKS];
+	std::unordered_map<uint64_t, std::vector<uint32_t>> byCard;
+	std::unordered_map<uint32_t, std::vector<uint32_t>> byCardEnding;
+	std::vector<std::pair<int64_t, uint32_t>> byTime;	// sorted by time
+
+	void add(uint32_t id, const CustomerRecordWire& txn);
+	static bool matches(const TxnKey& key, const Filter& filter);
+
+	static uint64_t cardKey(const char* card);
+
+public:
+	explicit TxnIndex(const TxnHistory& history);
+
+	// Indexes whatever has been archived since the last call.
+	void catchUp();
+
+	/*
+	 * Positions in the history of the transactions that pass every filter, in the order they
+	 * were archived. `midnight` is the start of the day that `since` and `until` refer to.
+	 */
+	std::vector<uint32_t> query(const TxnQuery& query, int64_t midnight);
+
+	// Number of transactions indexed so far.
+	size_t size() const { return keys.size(); }
+};
+
+#endif // __TXN_INDEX_H__
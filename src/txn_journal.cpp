@@ -0,0 +1,386 @@
+#include "txn_journal.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// The records start on their own page, so flushing them never has to touch the header's page.
+static const size_t JOURNAL_HEADER_BYTES = 4096;
+static const char JOURNAL_MAGIC[8] = { 'G', 'S', 'J', 'R', 'N', 'L', '0', '1' };
+static const uint32_t JOURNAL_VERSION = 1;
+
+TxnJournal::TxnJournal(const string& path) :
+	path(path),
+#ifdef _WIN32
+	file(INVALID_HANDLE_VALUE),
+	mapping(NULL),
+#else
+	fd(-1),
+#endif
+	base(nullptr),
+	mappedSize(0),
+	count(0),
+	capacity(0),
+	committed(0),
+	groupReady(false),
+	stopping(false)
+{
+	uint64_t file_size = 0;
+
+#ifdef _WIN32
+	file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	PERR(file != INVALID_HANDLE_VALUE, string("Cannot open the transaction journal: ") + path);
+	if (file == INVALID_HANDLE_VALUE)
+		return;
+	LARGE_INTEGER size;
+	GetFileSizeEx(file, &size);
+	file_size = static_cast<uint64_t>(size.QuadPart);
+#else
+	fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+	PERR(fd != -1, string("Cannot open the transaction journal: ") + path);
+	if (fd == -1)
+		return;
+	struct stat st;
+	fstat(fd, &st);
+	file_size = static_cast<uint64_t>(st.st_size);
+#endif
+
+	if (file_size < JOURNAL_HEADER_BYTES + sizeof(JournalRecord)) {
+		// a new journal
+		if (!map(JOURNAL_GROW_RECORDS))
+			return;
+		memcpy(header()->magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+		header()->version = JOURNAL_VERSION;
+		header()->recordSize = sizeof(JournalRecord);
+		header()->committed = 0;
+		header()->capacity = capacity;
+		flushToDisk(0, sizeof(JournalHeader));
+	}
+	else {
+		if (!map((file_size - JOURNAL_HEADER_BYTES) / sizeof(JournalRecord)))
+			return;
+		bool valid = memcmp(header()->magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) == 0 &&
+			header()->version == JOURNAL_VERSION && header()->recordSize == sizeof(JournalRecord);
+		PERR(valid, string("Not a transaction journal, or written by another version: ") + path);
+		if (!valid) {
+			// leave the file as it is for someone to look at
+			unmap();
+			return;
+		}
+		recover();
+	}
+
+	committer = thread(&TxnJournal::commitLoop, this);
+}
+
+TxnJournal::~TxnJournal()
+{
+	if (committer.joinable()) {
+		{
+			lock_guard<mutex> lock(wakeMutex);
+			stopping = true;
+		}
+		wake.notify_one();
+		committer.join();
+	}
+
+	unmap();
+#ifdef _WIN32
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+#else
+	if (fd != -1)
+		close(fd);
+#endif
+}
+
+JournalRecord*
+TxnJournal::records() const
+{
+	return reinterpret_cast<JournalRecord*>(base + JOURNAL_HEADER_BYTES);
+}
+
+/*
+ * Maps the file with room for `new_capacity` records, extending it if it is shorter.
+ */
+bool
+TxnJournal::map(uint64_t new_capacity)
+{
+	size_t size = JOURNAL_HEADER_BYTES + static_cast<size_t>(new_capacity) * sizeof(JournalRecord);
+
+#ifdef _WIN32
+	// A mapping larger than the file extends it with zeros.
+	mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+		static_cast<DWORD>(size), NULL);
+	PERR(mapping != NULL, string("Cannot map the transaction journal: ") + path);
+	if (mapping == NULL)
+		return false;
+	void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	PERR(view != NULL, string("Cannot map the transaction journal: ") + path);
+	if (view == NULL) {
+		CloseHandle(mapping);
+		mapping = NULL;
+		return false;
+	}
+#else
+	struct stat st;
+	fstat(fd, &st);
+	if (static_cast<size_t>(st.st_size) < size && ftruncate(fd, static_cast<off_t>(size)) != 0) {
+		PERR(false, string("Cannot extend the transaction journal: ") + path);
+		return false;
+	}
+	void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	PERR(view != MAP_FAILED, string("Cannot map the transaction journal: ") + path);
+	if (view == MAP_FAILED)
+		return false;
+#endif
+
+	base = static_cast<char*>(view);
+	mappedSize = size;
+	capacity = new_capacity;
+	return true;
+}
+
+void
+TxnJournal::unmap()
+{
+	if (base == nullptr)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(base);
+	CloseHandle(mapping);
+	mapping = NULL;
+#else
+	munmap(base, mappedSize);
+#endif
+	base = nullptr;
+	mappedSize = 0;
+}
+
+/*
+ * Called with appendMutex held when the file is full. The commit thread is kept out while
+ * the map moves.
+ */
+void
+TxnJournal::grow()
+{
+	lock_guard<mutex> lock(commitMutex);
+
+	uint64_t new_capacity = capacity + JOURNAL_GROW_RECORDS;
+	unmap();
+	if (!map(new_capacity))
+		return;
+	header()->capacity = capacity;
+	flushToDisk(0, sizeof(JournalHeader));
+}
+
+/*
+ * Writes the given byte range of the map to disk and waits until it is there.
+ */
+void
+TxnJournal::flushToDisk(size_t offset, size_t length)
+{
+#ifdef _WIN32
+	FlushViewOfFile(base + offset, length);
+	FlushFileBuffers(file);
+#else
+	// msync() wants a page-aligned start; MS_SYNC also writes the file size out after growing.
+	size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	size_t start = offset / page * page;
+	msync(base + start, offset + length - start, MS_SYNC);
+#endif
+}
+
+/*
+ * Finds the end of the journal from the committed count in the header, then keeps any
+ * complete records written after the last commit.
+ */
+void
+TxnJournal::recover()
+{
+	uint64_t end = header()->committed < capacity ? header()->committed : capacity;
+
+	while (end < capacity) {
+		const JournalRecord& record = records()[end];
+		if (record.seq != end + 1 || record.checksum != checksumOf(record))
+			break;
+		end++;
+	}
+
+	count = end;
+	committed.store(header()->committed < capacity ? header()->committed : capacity);
+	commit();
+}
+
+uint32_t
+TxnJournal::checksumOf(const JournalRecord& record)
+{
+	// FNV-1a over the sequence number and the transaction
+	uint32_t hash = 2166136261u;
+	auto mix = [&hash](const void* data, size_t length) {
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < length; i++) {
+			hash ^= bytes[i];
+			hash *= 16777619u;
+		}
+	};
+	mix(&record.seq, sizeof(record.seq));
+	mix(&record.txn, sizeof(record.txn));
+	return hash;
+}
+
+void
+TxnJournal::append(const CustomerRecord& txn)
+{
+	// Built in full, padding included, before it is copied in: the checksum covers every byte.
+	JournalRecord record;
+	memset(&record, 0, sizeof(record));
+	toWire(txn, record.txn);
+
+	bool group_full = false;
+	{
+		lock_guard<mutex> lock(appendMutex);
+		if (base == nullptr)
+			return;
+		if (count == capacity) {
+			grow();
+			if (base == nullptr)
+				return;
+		}
+
+		record.seq = count + 1;
+		record.checksum = checksumOf(record);
+		memcpy(&records()[count], &record, sizeof(record));
+		count++;
+
+		group_full = count - committed.load(memory_order_relaxed) >= JOURNAL_GROUP_SIZE;
+	}
+
+	if (group_full) {
+		{
+			lock_guard<mutex> lock(wakeMutex);
+			groupReady = true;
+		}
+		wake.notify_one();
+	}
+}
+
+/*
+ * Makes every record appended so far durable: first the records, then the header that
+ * counts them, so a crash in between only loses the new count, which recover() rebuilds.
+ */
+void
+TxnJournal::commit()
+{
+	uint64_t target;
+	{
+		lock_guard<mutex> lock(appendMutex);
+		target = count;
+	}
+
+	lock_guard<mutex> lock(commitMutex);
+	uint64_t from = committed.load(memory_order_relaxed);
+	if (base == nullptr || target <= from)
+		return;
+
+	flushToDisk(JOURNAL_HEADER_BYTES + static_cast<size_t>(from) * sizeof(JournalRecord),
+		static_cast<size_t>(target - from) * sizeof(JournalRecord));
+	header()->committed = target;
+	flushToDisk(0, sizeof(JournalHeader));
+
+	committed.store(target, memory_order_relaxed);
+}
+
+void
+TxnJournal::commitLoop()
+{
+	while (true) {
+		{
+			unique_lock<mutex> lock(wakeMutex);
+			wake.wait_for(lock, chrono::milliseconds(JOURNAL_COMMIT_MS), [this] { return stopping || groupReady; });
+			groupReady = false;
+			if (stopping)
+				break;
+		}
+		commit();
+	}
+
+	// whatever came in since the last group
+	commit();
+}
+
+void
+TxnJournal::flush()
+{
+	commit();
+}
+
+uint64_t
+TxnJournal::size()
+{
+	lock_guard<mutex> lock(appendMutex);
+	return count;
+}
+
+bool
+TxnJournal::read(uint64_t index, CustomerRecordWire& txn)
+{
+	lock_guard<mutex> lock(appendMutex);
+	if (index >= count)
+		return false;
+	memcpy(&txn, &records()[index].txn, sizeof(txn));
+	return true;
+}
+
+TxnHistory::TxnHistory(const TxnStore& store) : store(&store), earlier(0) {}
+
+void
+TxnHistory::startWith(const shared_ptr<TxnJournal>& journal)
+{
+	this->journal = journal;
+	earlier = journal ? journal->size() : 0;
+}
+
+bool
+TxnHistory::read(Cursor& cursor, CustomerRecordWire& txn) const
+{
+	if (cursor.next < earlier) {
+		if (!journal->read(cursor.next, txn))
+			return false;
+	}
+	else if (!store->read(cursor.inStore, txn))
+		return false;
+	cursor.next++;
+	return true;
+}
+
+bool
+TxnHistory::at(uint64_t index, CustomerRecordWire& txn) const
+{
+	if (index < earlier)
+		return journal->read(index, txn);
+	return store->at(index - earlier, txn);
+}
+
+string
+dailyJournalPath(const tm& day)
+{
+	char path[32];
+	snprintf(path, sizeof(path), "txn_%04d%02d%02d.journal", day.tm_year + 1900, day.tm_mon + 1, day.tm_mday);
+	return path;
+}
+
+string
+dailyJournalPath()
+{
+	return dailyJournalPath(getTimestamp());
+}
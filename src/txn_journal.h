@@ -0,0 +1,166 @@
+#ifndef __TXN_JOURNAL_H__
+#define __TXN_JOURNAL_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "common.h"
+#include "txn_store.h"
+
+/*
+ * Append-only, memory-mapped log of archived transactions.
+ *
+ * Each transaction is a fixed-size JournalRecord written straight into the mapped file, so
+ * appending costs a copy and no system call. A commit thread makes the records durable in
+ * groups: whenever JOURNAL_GROUP_SIZE records are waiting or JOURNAL_COMMIT_MS has passed,
+ * it flushes the new records, then advances `committed` in the file header and flushes that.
+ *
+ * On start-up the header says how many records were committed; only the records after that
+ * are examined, and those whose sequence number and checksum are intact (written, but not yet
+ * committed when the process stopped) are kept. Nothing before the tail is read then, nor
+ * later unless asked for: a TxnHistory reads the older records straight out of the map when
+ * the history or a `pt` query gets to them.
+ *
+ * The file grows by JOURNAL_GROW_RECORDS records at a time and is remapped when it does.
+ */
+const uint32_t JOURNAL_GROUP_SIZE = 64;
+const uint32_t JOURNAL_COMMIT_MS = 100;
+const uint64_t JOURNAL_GROW_RECORDS = 4096;
+
+struct JournalRecord
+{
+	uint64_t seq;			// 1 for the first record in the file
+	uint32_t checksum;		// over seq and txn
+	uint32_t reserved;
+	CustomerRecordWire txn;
+};
+
+static_assert(std::is_trivially_copyable<JournalRecord>::value,
+	"JournalRecord is written to the journal file byte by byte");
+
+struct JournalHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t recordSize;
+	uint64_t committed;		// records known to be on disk
+	uint64_t capacity;		// records the file has room for
+};
+
+class TxnJournal
+{
+private:
+	std::string path;
+
+#ifdef _WIN32
+	HANDLE file;
+	HANDLE mapping;
+#else
+	int fd;
+#endif
+	char* base;
+	size_t mappedSize;
+
+	// appenders: slot allocation and copying into the map, and growing the file
+	std::mutex appendMutex;
+	uint64_t count;
+	uint64_t capacity;
+
+	// the commit thread: flushing, and keeping the map in place while it does
+	std::mutex commitMutex;
+	std::atomic<uint64_t> committed;
+
+	std::mutex wakeMutex;
+	std::condition_variable wake;
+	bool groupReady;
+	bool stopping;
+	std::thread committer;
+
+	JournalHeader* header() const { return reinterpret_cast<JournalHeader*>(base); }
+	JournalRecord* records() const;
+
+	bool map(uint64_t new_capacity);
+	void unmap();
+	void grow();
+	void flushToDisk(size_t offset, size_t length);
+
+	void recover();
+	void commit();
+	void commitLoop();
+
+	static uint32_t checksumOf(const JournalRecord& record);
+
+public:
+	// Opens or creates the journal at `path` and recovers it.
+	explicit TxnJournal(const std::string& path);
+	~TxnJournal();
+
+	TxnJournal(const TxnJournal&) = delete;
+	TxnJournal& operator=(const TxnJournal&) = delete;
+
+	bool isOpen() const { return base != nullptr; }
+
+	// Adds a transaction; it becomes durable with the next group commit.
+	void append(const CustomerRecord& txn);
+
+	// Commits everything appended so far before returning.
+	void flush();
+
+	// Number of records in the journal, including those not committed yet.
+	uint64_t size();
+
+	// Copies record `index` (0-based) out of the journal; false if there is no such record.
+	bool read(uint64_t index, CustomerRecordWire& txn);
+};
+
+/*
+ * The transactions the Computer shows and queries: those an earlier run left in the day's
+ * journal, then those archived into the TxnStore since. The journal's records are not
+ * loaded at start-up; they are read from the map as a cursor or `at` reaches them, so a
+ * restart costs the same however long the day has been. Positions run on from the
+ * journal's records into the store's.
+ */
+class TxnHistory
+{
+private:
+	const TxnStore* store;
+	std::shared_ptr<TxnJournal> journal;
+	uint64_t earlier;	// records of `journal` in front of the store's
+
+public:
+	class Cursor
+	{
+	private:
+		uint64_t next = 0;
+		TxnStore::Cursor inStore;
+		friend class TxnHistory;
+
+	public:
+		// number of records this cursor has read
+		uint64_t position() const { return next; }
+	};
+
+	explicit TxnHistory(const TxnStore& store);
+
+	// Puts the records `journal` holds now in front of the store's, before anyone reads the history.
+	void startWith(const std::shared_ptr<TxnJournal>& journal);
+
+	// Copies the record after `cursor` into `txn` and moves past it; false if it is not there yet.
+	bool read(Cursor& cursor, CustomerRecordWire& txn) const;
+
+	// Copies record `index` (0-based) into `txn`; false if it has not been written yet.
+	bool at(uint64_t index, CustomerRecordWire& txn) const;
+
+	uint64_t size() const { return earlier + store->size(); }
+};
+
+// e.g. "txn_20240131.journal", for `day` or the simulated date at the time of the call
+std::string dailyJournalPath(const std::tm& day);
+std::string dailyJournalPath();
+
+#endif // __TXN_JOURNAL_H__
@@ -0,0 +1,163 @@
+#ifndef __TXN_STORE_H__
+#define __TXN_STORE_H__
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include "common.h"
+
+/*
+ * An append-only sequence of records in fixed-size chunks, for any number of writers and
+ * readers without a lock.
+ *
+ * A writer claims the next index with one fetch_add, allocates the chunk holding it if
+ * nobody has yet (a CAS on the chunk directory), copies the record in and marks the slot
+ * ready. Chunks never move or go away, so a record is never copied again once written.
+ *
+ * Writers can finish out of order, so a reader walks the store with a Cursor that stops at
+ * the first slot that is not ready yet and carries on from there next time. Each read only
+ * costs the new records, whatever the size of the store, and never holds up a writer.
+ *
+ * The store holds up to ChunkSize * MaxChunks records; `append` returns false beyond that.
+ */
+template <class T, size_t ChunkSize = 256, size_t MaxChunks = 16384>
+class ChunkedStore
+{
+	static_assert(std::is_trivially_copyable<T>::value, "ChunkedStore elements are copied byte by byte");
+
+private:
+	struct Slot
+	{
+		std::atomic<bool> ready;
+		T value;
+	};
+
+	struct Chunk
+	{
+		Slot slots[ChunkSize];
+
+		Chunk()
+		{
+			for (Slot& slot : slots)
+				slot.ready.store(false, std::memory_order_relaxed);
+		}
+	};
+
+	std::atomic<uint64_t> claimed;
+	std::unique_ptr<std::atomic<Chunk*>[]> chunks;
+
+	Chunk* chunkFor(uint64_t index);
+
+public:
+	class Cursor
+	{
+	private:
+		uint64_t next = 0;
+		friend class ChunkedStore;
+
+	public:
+		// number of records this cursor has read
+		uint64_t position() const { return next; }
+	};
+
+	ChunkedStore();
+	~ChunkedStore();
+
+	ChunkedStore(const ChunkedStore&) = delete;
+	ChunkedStore& operator=(const ChunkedStore&) = delete;
+
+	bool append(const T& value);
+
+	// Copies the record after `cursor` into `value` and moves past it; false if it is not there yet.
+	bool read(Cursor& cursor, T& value) const;
+
+	// Copies record `index` (0-based) into `value`; false if it has not been written yet.
+	bool at(uint64_t index, T& value) const;
+
+	// Number of records claimed so far, including any still being written.
+	uint64_t size() const { return claimed.load(std::memory_order_acquire); }
+};
+
+template <class T, size_t ChunkSize, size_t MaxChunks>
+ChunkedStore<T, ChunkSize, MaxChunks>::ChunkedStore()
+	: claimed(0), chunks(new std::atomic<Chunk*>[MaxChunks])
+{
+	for (size_t i = 0; i < MaxChunks; i++)
+		chunks[i].store(nullptr, std::memory_order_relaxed);
+}
+
+template <class T, size_t ChunkSize, size_t MaxChunks>
+ChunkedStore<T, ChunkSize, MaxChunks>::~ChunkedStore()
+{
+	for (size_t i = 0; i < MaxChunks; i++)
+		delete chunks[i].load(std::memory_order_relaxed);
+}
+
+template <class T, size_t ChunkSize, size_t MaxChunks>
+typename ChunkedStore<T, ChunkSize, MaxChunks>::Chunk*
+ChunkedStore<T, ChunkSize, MaxChunks>::chunkFor(uint64_t index)
+{
+	std::atomic<Chunk*>& entry = chunks[index / ChunkSize];
+	Chunk* chunk = entry.load(std::memory_order_acquire);
+	if (chunk != nullptr)
+		return chunk;
+
+	// Several writers can reach a new chunk together; the first one to publish its chunk wins.
+	Chunk* fresh = new Chunk();
+	if (entry.compare_exchange_strong(chunk, fresh, std::memory_order_acq_rel, std::memory_order_acquire))
+		return fresh;
+	delete fresh;
+	return chunk;
+}
+
+template <class T, size_t ChunkSize, size_t MaxChunks>
+bool
+ChunkedStore<T, ChunkSize, MaxChunks>::append(const T& value)
+{
+	uint64_t index = claimed.fetch_add(1, std::memory_order_acq_rel);
+	if (index >= ChunkSize * MaxChunks) {
+		claimed.fetch_sub(1, std::memory_order_acq_rel);
+		return false;
+	}
+
+	Slot& slot = chunkFor(index)->slots[index % ChunkSize];
+	slot.value = value;
+	slot.ready.store(true, std::memory_order_release);
+	return true;
+}
+
+template <class T, size_t ChunkSize, size_t MaxChunks>
+bool
+ChunkedStore<T, ChunkSize, MaxChunks>::read(Cursor& cursor, T& value) const
+{
+	if (cursor.next >= ChunkSize * MaxChunks)
+		return false;
+
+	Chunk* chunk = chunks[cursor.next / ChunkSize].load(std::memory_order_acquire);
+	if (chunk == nullptr)
+		return false;
+
+	const Slot& slot = chunk->slots[cursor.next % ChunkSize];
+	if (!slot.ready.load(std::memory_order_acquire))
+		return false;
+
+	value = slot.value;
+	cursor.next++;
+	return true;
+}
+
+template <class T, size_t ChunkSize, size_t MaxChunks>
+bool
+ChunkedStore<T, ChunkSize, MaxChunks>::at(uint64_t index, T& value) const
+{
+	Cursor cursor;
+	cursor.next = index;
+	return read(cursor, value);
+}
+
+// Every transaction the Computer has archived, in the order they were archived.
+typedef ChunkedStore<CustomerRecordWire> TxnStore;
+
+#endif // __TXN_STORE_H__